@@ -3,6 +3,7 @@
 #include "glib.h"
 #include "rmf/rmf-iterator.h"
 #include "rmf/rmf-private.h"
+#include "rmf/rmf-solid.h"
 
 #include <float.h>
 #include <glib-object.h>
@@ -54,6 +55,41 @@ enum Property {
 
 static GParamSpec *obj_properties[N_PROPERTIES];
 
+// Private /////////////////////////////////////////////////////////////////////
+
+static void collect_texture_names(
+    RmfMapObject *object,
+    GHashTable *seen,
+    GPtrArray *names
+)
+{
+    if (RMF_IS_SOLID(object)) {
+        g_autoptr(RmfFaceIterator) faces = rmf_solid_get_faces(
+            RMF_SOLID(object)
+        );
+        RMF_ITERATOR_FOREACH(RmfFace, face, faces) {
+            if (face->texture_name[0] == '\0') {
+                continue;
+            }
+            char *key = g_ascii_strdown(face->texture_name, -1);
+            if (g_hash_table_add(seen, key)) {
+                g_ptr_array_add(names, g_strdup(face->texture_name));
+            }
+        }
+    }
+
+    g_autoptr(GListStore) children = rmf_map_object_get_children(object);
+    if (!children) {
+        return;
+    }
+    guint n_children = g_list_model_get_n_items(G_LIST_MODEL(children));
+    for (guint i = 0; i < n_children; ++i) {
+        g_autoptr(RmfMapObject) child
+            = g_list_model_get_item(G_LIST_MODEL(children), i);
+        collect_texture_names(child, seen, names);
+    }
+}
+
 // GObject /////////////////////////////////////////////////////////////////////
 
 static void rmf_root_dispose(GObject *object)
@@ -224,6 +260,30 @@ RmfDocinfo *rmf_root_get_docinfo(RmfRoot *self)
     return value;
 }
 
+/**
+ * rmf_root_get_texture_names
+ * @root: The root.
+ *
+ * Gets the names of the textures applied to the faces of every solid in the
+ * map. Each name appears once, compared ignoring case, in the order it is first
+ * met.
+ *
+ * Returns: (transfer full): A `NULL`-terminated array of texture names.
+ */
+char **rmf_root_get_texture_names(RmfRoot *self)
+{
+    g_return_val_if_fail(RMF_IS_ROOT(self), nullptr);
+
+    g_autoptr(GHashTable) seen
+        = g_hash_table_new_full(g_str_hash, g_str_equal, g_free, nullptr);
+    GPtrArray *names = g_ptr_array_new();
+    if (self->worldspawn) {
+        collect_texture_names(RMF_MAP_OBJECT(self->worldspawn), seen, names);
+    }
+    g_ptr_array_add(names, nullptr);
+    return (char **)g_ptr_array_free(names, FALSE);
+}
+
 // Internal ////////////////////////////////////////////////////////////////////
 
 RmfRoot *rmf_root_new(RmfLoader *loader)
@@ -34,6 +34,7 @@ rmf_int rmf_root_get_n_visgroups(RmfRoot *root);
 RmfVisgroupIterator *rmf_root_get_visgroups(RmfRoot *root);
 RmfWorldspawn *rmf_root_get_worldspawn(RmfRoot *root);
 RmfDocinfo *rmf_root_get_docinfo(RmfRoot *root);
+char **rmf_root_get_texture_names(RmfRoot *root);
 
 G_END_DECLS
 
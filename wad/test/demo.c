@@ -4,17 +4,8 @@
 
 static GdkPaintable *make_miptex_paintable(WadMiptexFile *miptex)
 {
-    guchar const *image = (guchar *)miptex->mip_images[0]->data;
-    WadRgb const *palette = (WadRgb *)miptex->palette->data;
-
     guchar *data = g_new(guchar, miptex->width * miptex->height * 4);
-    for (size_t i = 0; i < miptex->width * miptex->height; ++i) {
-        guchar pixel = image[i];
-        data[(i * 4) + 0] = palette[pixel].rgb[0];
-        data[(i * 4) + 1] = palette[pixel].rgb[1];
-        data[(i * 4) + 2] = palette[pixel].rgb[2];
-        data[(i * 4) + 3] = 0xff;
-    }
+    wad_miptex_file_to_rgba(miptex, 0, nullptr, data, miptex->width * 4);
 
     g_autoptr(GBytes) bytes
         = g_bytes_new_take(data, miptex->width * miptex->height * 4);
@@ -69,13 +60,8 @@ static void open(GApplication *application, GFile *files[], int, char *, void *)
     WadTextureArchive *archive = wad_root_get_archive(root);
     g_autofree char const **names = wad_texture_archive_get_names(archive);
     for (char const **name = names; *name != nullptr; ++name) {
-        GValue const *value = wad_texture_archive_get_texture(archive, *name);
-        GType const type = G_VALUE_TYPE(value);
-        if (type == WAD_TYPE_FONT_FILE) {
-            WadFontFile *font = g_value_get_boxed(value);
-        } else if (type == WAD_TYPE_MIPTEX_FILE) {
-            WadMiptexFile *miptex = g_value_get_boxed(value);
-
+        WadMiptexFile *miptex = wad_texture_archive_get_miptex(archive, *name);
+        if (miptex) {
             g_autoptr(GdkPaintable) texture = make_miptex_paintable(miptex);
 
             GtkWidget *picture = gtk_picture_new_for_paintable(texture);
@@ -90,8 +76,6 @@ static void open(GApplication *application, GFile *files[], int, char *, void *)
             gtk_box_append(GTK_BOX(box), label);
 
             gtk_flow_box_append(GTK_FLOW_BOX(flowbox), box);
-        } else if (type == WAD_TYPE_QPIC_FILE) {
-            WadQpicFile *font = g_value_get_boxed(value);
         }
     }
 
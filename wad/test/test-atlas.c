@@ -0,0 +1,107 @@
+#include "wad/wad-atlas.h"
+
+#include <glib.h>
+
+static WadMiptexFile *make_miptex(guint32 width, guint32 height, guchar shade)
+{
+    gsize size = (gsize)width * height * 4;
+    g_autofree guchar *rgba = g_new(guchar, size);
+    memset(rgba, shade, size);
+    return wad_miptex_file_new_from_rgba(
+        "tex",
+        width,
+        height,
+        rgba,
+        width * 4,
+        WAD_DITHER_NONE,
+        nullptr
+    );
+}
+
+static bool padded_overlap(
+    WadAtlasRegion const *a,
+    WadAtlasRegion const *b,
+    guint pad
+)
+{
+    return a->page == b->page && a->x < b->x + b->width + 2 * pad
+        && b->x < a->x + a->width + 2 * pad
+        && a->y < b->y + b->height + 2 * pad
+        && b->y < a->y + a->height + 2 * pad;
+}
+
+static void test_no_overlap(void)
+{
+    constexpr guint n = 60;
+    constexpr guint pad = 2;
+    g_autoptr(WadAtlas) atlas = wad_atlas_new(256, pad, TRUE);
+    char name[17];
+
+    // Mixed sizes, more than fit on one page.
+    for (guint i = 0; i < n; ++i) {
+        guint32 width = 16 * (1 + i % 5);
+        guint32 height = 16 * (1 + (i * 3) % 4);
+        WadMiptexFile *miptex = make_miptex(width, height, i * 4);
+        g_snprintf(name, sizeof(name), "tex%u", i);
+        wad_atlas_add_miptex(atlas, name, miptex);
+        wad_miptex_file_free(miptex);
+    }
+    GError *e = nullptr;
+    wad_atlas_build(atlas, nullptr, &e);
+    g_assert_no_error(e);
+    guint n_pages = wad_atlas_get_n_pages(atlas);
+    g_assert_cmpuint(n_pages, >, 1);
+
+    WadAtlasRegion regions[n];
+    for (guint i = 0; i < n; ++i) {
+        g_snprintf(name, sizeof(name), "TEX%u", i);
+        g_assert_true(wad_atlas_get_region(atlas, name, &regions[i]));
+        g_assert_cmpuint(regions[i].width, ==, 16 * (1 + i % 5));
+        g_assert_cmpuint(regions[i].height, ==, 16 * (1 + (i * 3) % 4));
+        g_assert_cmpuint(regions[i].page, <, n_pages);
+
+        guint width = 0;
+        guint height = 0;
+        g_autoptr(GBytes) page
+            = wad_atlas_get_page(atlas, regions[i].page, &width, &height);
+        g_assert_cmpuint(width, <=, 256);
+        g_assert_cmpuint(height, <=, 256);
+        g_assert_cmpuint(regions[i].x, >=, pad);
+        g_assert_cmpuint(regions[i].y, >=, pad);
+        g_assert_cmpuint(regions[i].x + regions[i].width + pad, <=, width);
+        g_assert_cmpuint(regions[i].y + regions[i].height + pad, <=, height);
+    }
+
+    // Padded rectangles are offset by the padding from the placed ones.
+    for (guint i = 0; i < n; ++i) {
+        regions[i].x -= pad;
+        regions[i].y -= pad;
+    }
+    for (guint i = 0; i < n; ++i) {
+        for (guint j = i + 1; j < n; ++j) {
+            g_assert_false(padded_overlap(&regions[i], &regions[j], pad));
+        }
+    }
+}
+
+static void test_too_large(void)
+{
+    g_autoptr(WadAtlas) atlas = wad_atlas_new(64, 1, FALSE);
+    WadMiptexFile *miptex = make_miptex(64, 16, 0);
+    wad_atlas_add_miptex(atlas, "wide", miptex);
+    wad_miptex_file_free(miptex);
+
+    GError *e = nullptr;
+    wad_atlas_build(atlas, nullptr, &e);
+    g_assert_error(e, WAD_ATLAS_ERROR, WAD_ATLAS_ERROR_TOO_LARGE);
+    g_clear_error(&e);
+    g_assert_cmpuint(wad_atlas_get_n_pages(atlas), ==, 0);
+}
+
+int main(int argc, char *argv[])
+{
+    g_test_init(&argc, &argv, nullptr);
+    g_test_add_func("/atlas/no-overlap", test_no_overlap);
+    g_test_add_func("/atlas/too-large", test_too_large);
+    return g_test_run();
+}
@@ -0,0 +1,215 @@
+#include "wad/wad-contentregistry.h"
+#include "wad/wad-private.h"
+
+#include <glib.h>
+
+static void
+add_miptex(WadTextureArchive *archive, char const *name, guchar shade)
+{
+    guchar rgba[16 * 16 * 4];
+    for (gsize i = 0; i < sizeof(rgba); i += 4) {
+        rgba[i + 0] = shade;
+        rgba[i + 1] = i / 4;
+        rgba[i + 2] = 0;
+        rgba[i + 3] = 255;
+    }
+    WadTexture texture = {
+        .type = WAD_TYPE_MIPTEX_FILE,
+        .boxed = wad_miptex_file_new_from_rgba(
+            name,
+            16,
+            16,
+            rgba,
+            16 * 4,
+            WAD_DITHER_NONE,
+            nullptr
+        ),
+    };
+    wad_texture_archive_take_texture(archive, name, &texture);
+}
+
+static bool has_member(
+    WadDuplicateGroup const *group,
+    WadTextureArchive *archive,
+    char const *name
+)
+{
+    for (guint i = 0; i < group->names->len; ++i) {
+        if (group->archives->pdata[i] == archive
+            && g_str_equal(group->names->pdata[i], name)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+static void test_duplicates(void)
+{
+    g_autoptr(WadContentRegistry) registry = wad_content_registry_new();
+    g_autoptr(WadTextureArchive) a = wad_texture_archive_new();
+    add_miptex(a, "brick", 10);
+    add_miptex(a, "brick_copy", 10);
+    add_miptex(a, "grass", 20);
+    g_autoptr(WadTextureArchive) b = wad_texture_archive_new();
+    add_miptex(b, "brick", 10);
+    add_miptex(b, "grass2", 20);
+    add_miptex(b, "sky", 30);
+    // Same pixels as "brick", but the name makes the last palette entry
+    // transparent, so it looks different.
+    add_miptex(b, "{brick", 10);
+
+    g_assert_cmpuint(wad_content_registry_add_archive(registry, a, 1), ==, 1);
+    g_assert_cmpuint(wad_content_registry_add_archive(registry, b, 0), ==, 2);
+
+    guint64 brick = 0;
+    guint64 other = 0;
+    g_assert_true(wad_content_registry_get_hash(registry, a, "BRICK", &brick));
+    g_assert_true(wad_content_registry_get_hash(registry, b, "brick", &other));
+    g_assert_cmpuint(brick, ==, other);
+    g_assert_true(wad_content_registry_get_hash(registry, b, "{brick", &other));
+    g_assert_cmpuint(brick, !=, other);
+    g_assert_false(wad_content_registry_get_hash(registry, a, "sky", nullptr));
+
+    // The three bricks waste more than the two grasses, so come first.
+    g_autoptr(GPtrArray) duplicates
+        = wad_content_registry_get_duplicates(registry);
+    g_assert_cmpuint(duplicates->len, ==, 2);
+    WadDuplicateGroup const *bricks = duplicates->pdata[0];
+    g_assert_cmpuint(bricks->hash, ==, brick);
+    g_assert_cmpuint(bricks->names->len, ==, 3);
+    g_assert_cmpuint(bricks->size, >, 16 * 16);
+    g_assert_true(has_member(bricks, a, "brick"));
+    g_assert_true(has_member(bricks, a, "brick_copy"));
+    g_assert_true(has_member(bricks, b, "brick"));
+    WadDuplicateGroup const *grasses = duplicates->pdata[1];
+    g_assert_cmpuint(grasses->names->len, ==, 2);
+    g_assert_true(has_member(grasses, a, "grass"));
+    g_assert_true(has_member(grasses, b, "grass2"));
+
+    // Adding an archive again picks up its changes.
+    add_miptex(a, "brick_copy", 40);
+    wad_content_registry_add_archive(registry, a, 0);
+    g_clear_pointer(&duplicates, g_ptr_array_unref);
+    duplicates = wad_content_registry_get_duplicates(registry);
+    g_assert_cmpuint(duplicates->len, ==, 2);
+    bricks = duplicates->pdata[0];
+    g_assert_cmpuint(bricks->names->len, ==, 2);
+    g_assert_false(has_member(bricks, a, "brick_copy"));
+
+    wad_content_registry_remove_archive(registry, b);
+    g_clear_pointer(&duplicates, g_ptr_array_unref);
+    duplicates = wad_content_registry_get_duplicates(registry);
+    g_assert_cmpuint(duplicates->len, ==, 0);
+}
+
+static void test_lookup_rgba_shared(void)
+{
+    g_autoptr(WadContentRegistry) registry = wad_content_registry_new();
+    g_autoptr(WadTextureArchive) archive = wad_texture_archive_new();
+    add_miptex(archive, "a", 10);
+    add_miptex(archive, "b", 10);
+    wad_content_registry_add_archive(registry, archive, 0);
+
+    guint width = 0;
+    guint height = 0;
+    g_autoptr(GBytes) a = wad_content_registry_lookup_rgba(
+        registry,
+        archive,
+        "a",
+        &width,
+        &height
+    );
+    g_assert_nonnull(a);
+    g_assert_cmpuint(width, ==, 16);
+    g_assert_cmpuint(height, ==, 16);
+    g_autoptr(GBytes) b = wad_content_registry_lookup_rgba(
+        registry,
+        archive,
+        "b",
+        nullptr,
+        nullptr
+    );
+    // Expanded once for the group.
+    g_assert_true(a == b);
+    g_assert_null(wad_content_registry_lookup_rgba(
+        registry,
+        archive,
+        "c",
+        nullptr,
+        nullptr
+    ));
+}
+
+static void test_archive_finalized(void)
+{
+    g_autoptr(WadContentRegistry) registry = wad_content_registry_new();
+    g_autoptr(WadTextureArchive) a = wad_texture_archive_new();
+    add_miptex(a, "brick", 10);
+    WadTextureArchive *b = wad_texture_archive_new();
+    add_miptex(b, "brick", 10);
+    wad_content_registry_add_archive(registry, a, 0);
+    wad_content_registry_add_archive(registry, b, 0);
+
+    g_autoptr(GPtrArray) duplicates
+        = wad_content_registry_get_duplicates(registry);
+    g_assert_cmpuint(duplicates->len, ==, 1);
+    g_clear_pointer(&duplicates, g_ptr_array_unref);
+
+    // The registry does not keep the archive alive, and forgets its textures
+    // when it goes.
+    g_object_unref(b);
+    duplicates = wad_content_registry_get_duplicates(registry);
+    g_assert_cmpuint(duplicates->len, ==, 0);
+    g_assert_true(wad_content_registry_get_hash(registry, a, "brick", nullptr));
+}
+
+static void test_texture_invalidated(void)
+{
+    g_autoptr(WadContentRegistry) registry = wad_content_registry_new();
+    g_autoptr(WadTextureArchive) archive = wad_texture_archive_new();
+    add_miptex(archive, "a", 10);
+    add_miptex(archive, "b", 10);
+    add_miptex(archive, "c", 10);
+    wad_content_registry_add_archive(registry, archive, 0);
+
+    // Replaced and removed textures leave their group at once.
+    add_miptex(archive, "a", 20);
+    wad_texture_archive_remove_texture(archive, "b");
+    g_assert_false(
+        wad_content_registry_get_hash(registry, archive, "a", nullptr)
+    );
+    g_assert_false(
+        wad_content_registry_get_hash(registry, archive, "b", nullptr)
+    );
+    g_assert_true(
+        wad_content_registry_get_hash(registry, archive, "c", nullptr)
+    );
+    g_autoptr(GPtrArray) duplicates
+        = wad_content_registry_get_duplicates(registry);
+    g_assert_cmpuint(duplicates->len, ==, 0);
+
+    // Adding the archive again hashes the new texture.
+    wad_content_registry_add_archive(registry, archive, 0);
+    g_assert_true(
+        wad_content_registry_get_hash(registry, archive, "a", nullptr)
+    );
+}
+
+int main(int argc, char *argv[])
+{
+    g_test_init(&argc, &argv, nullptr);
+    g_test_add_func("/contentregistry/duplicates", test_duplicates);
+    g_test_add_func(
+        "/contentregistry/lookup-rgba-shared",
+        test_lookup_rgba_shared
+    );
+    g_test_add_func(
+        "/contentregistry/archive-finalized",
+        test_archive_finalized
+    );
+    g_test_add_func(
+        "/contentregistry/texture-invalidated",
+        test_texture_invalidated
+    );
+    return g_test_run();
+}
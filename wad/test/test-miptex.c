@@ -0,0 +1,126 @@
+#include "wad/wad-miptexfile.h"
+
+#include <glib.h>
+
+// A texture with more colors than fit in a palette, and a hole that covers
+// whole 8x8 blocks, so that every mip level has a hole of its own.
+static guchar *make_holed_image(guint32 size, guint32 hole, guint32 hole_size)
+{
+    guchar *rgba = g_new(guchar, (gsize)size * size * 4);
+    for (guint32 y = 0; y < size; ++y) {
+        for (guint32 x = 0; x < size; ++x) {
+            guchar *p = rgba + ((gsize)y * size + x) * 4;
+            bool in_hole = x >= hole && x < hole + hole_size && y >= hole
+                        && y < hole + hole_size;
+            p[0] = x * 8;
+            p[1] = y * 8;
+            p[2] = (x ^ y) * 8;
+            p[3] = in_hole ? 0 : 255;
+        }
+    }
+    return rgba;
+}
+
+static void test_import_transparent_mips(void)
+{
+    constexpr guint32 size = 32;
+    constexpr guint32 hole = 8;
+    constexpr guint32 hole_size = 16;
+    g_autofree guchar *rgba = make_holed_image(size, hole, hole_size);
+
+    WadMiptexFile *miptex = wad_miptex_file_new_from_rgba(
+        "{fence",
+        size,
+        size,
+        rgba,
+        size * 4,
+        WAD_DITHER_NONE,
+        nullptr
+    );
+    g_assert_nonnull(miptex);
+
+    for (guint level = 0; level < 4; ++level) {
+        guint32 width = size >> level;
+        guint32 lo = hole >> level;
+        guint32 hi = (hole + hole_size) >> level;
+        gsize n = 0;
+        guchar const *data = wad_miptex_file_get_mip_data(miptex, level, &n);
+        g_assert_cmpuint(n, ==, (gsize)width * width);
+        for (guint32 y = 0; y < width; ++y) {
+            for (guint32 x = 0; x < width; ++x) {
+                bool in_hole = x >= lo && x < hi && y >= lo && y < hi;
+                guchar index = data[(gsize)y * width + x];
+                bool transparent = index == WAD_MIPTEX_TRANSPARENT_INDEX;
+                g_assert_cmpint(transparent, ==, in_hole);
+            }
+        }
+    }
+    wad_miptex_file_free(miptex);
+}
+
+static void set_pixel(guchar *rgba, guint32 x, guint32 y, guint32 color)
+{
+    guchar *p = rgba + ((gsize)y * 16 + x) * 4;
+    p[0] = color >> 24;
+    p[1] = color >> 16;
+    p[2] = color >> 8;
+    p[3] = color;
+}
+
+static void test_mips_transparent_majority(void)
+{
+    // Orange, with a purple block that is close to what orange and the blue of
+    // the transparent index average to. Along the top row, the 2x2 blocks have
+    // 3, 2 and 1 transparent pixels.
+    constexpr guint32 orange = 0xc86432ff;
+    constexpr guint32 purple = 0x9247beff;
+    guchar rgba[16 * 16 * 4];
+    for (guint32 y = 0; y < 16; ++y) {
+        for (guint32 x = 0; x < 16; ++x) {
+            set_pixel(rgba, x, y, x >= 14 && y >= 14 ? purple : orange);
+        }
+    }
+    set_pixel(rgba, 0, 0, 0);
+    set_pixel(rgba, 1, 0, 0);
+    set_pixel(rgba, 0, 1, 0);
+    set_pixel(rgba, 2, 0, 0);
+    set_pixel(rgba, 3, 0, 0);
+    set_pixel(rgba, 4, 0, 0);
+
+    WadMiptexFile *miptex = wad_miptex_file_new_from_rgba(
+        "{grate",
+        16,
+        16,
+        rgba,
+        16 * 4,
+        WAD_DITHER_NONE,
+        nullptr
+    );
+    g_assert_nonnull(miptex);
+    gsize n = 0;
+    guchar const *level0 = wad_miptex_file_get_mip_data(miptex, 0, &n);
+    guchar opaque = level0[8 * 16 + 8];
+    g_assert_cmpuint(opaque, !=, WAD_MIPTEX_TRANSPARENT_INDEX);
+
+    // Transparent pixels only count towards whether the block is transparent,
+    // never towards its color.
+    guchar const *level1 = wad_miptex_file_get_mip_data(miptex, 1, &n);
+    g_assert_cmpuint(level1[0], ==, WAD_MIPTEX_TRANSPARENT_INDEX);
+    g_assert_cmpuint(level1[1], ==, opaque);
+    g_assert_cmpuint(level1[2], ==, opaque);
+    wad_miptex_file_free(miptex);
+}
+
+int main(int argc, char *argv[])
+{
+    g_test_init(&argc, &argv, nullptr);
+    g_test_add_func(
+        "/miptex/import/transparent-mips",
+        test_import_transparent_mips
+    );
+    g_test_add_func(
+        "/miptex/mips/transparent-majority",
+        test_mips_transparent_majority
+    );
+    return g_test_run();
+}
@@ -0,0 +1,98 @@
+#include "wad/wad-private.h"
+
+#include <glib.h>
+
+static void test_name_folding(void)
+{
+    WadName a;
+    WadName b;
+
+    wad_name_init(&a, "{Water");
+    wad_name_init(&b, "{WATER");
+    g_assert_true(wad_name_equal(&a, &b));
+    g_assert_cmpuint(wad_name_hash(&a), ==, wad_name_hash(&b));
+
+    // Only the 16 bytes of a directory entry's name count.
+    wad_name_init(&a, "0123456789abcdefXYZ");
+    wad_name_init(&b, "0123456789ABCDEF");
+    g_assert_true(wad_name_equal(&a, &b));
+
+    wad_name_init(&a, "brick1");
+    wad_name_init(&b, "brick2");
+    g_assert_false(wad_name_equal(&a, &b));
+}
+
+static void test_index_insert_lookup(void)
+{
+    WadNameIndex index;
+    WadName key;
+    guint value = 0;
+
+    wad_name_index_init(&index);
+    wad_name_init(&key, "brick");
+    g_assert_false(wad_name_index_lookup(&index, &key, &value));
+
+    wad_name_index_insert(&index, &key, 7);
+    g_assert_cmpuint(index.size, ==, 1);
+    g_assert_true(wad_name_index_lookup(&index, &key, &value));
+    g_assert_cmpuint(value, ==, 7);
+
+    // Inserting an existing name replaces its value.
+    wad_name_init(&key, "BRICK");
+    wad_name_index_insert(&index, &key, 0);
+    g_assert_cmpuint(index.size, ==, 1);
+    g_assert_true(wad_name_index_lookup(&index, &key, &value));
+    g_assert_cmpuint(value, ==, 0);
+
+    wad_name_index_clear(&index);
+}
+
+static void test_index_remove(void)
+{
+    constexpr guint n = 5000;
+    WadNameIndex index;
+    WadName key;
+    char name[17];
+
+    // Enough names to resize several times and form long probe runs.
+    wad_name_index_init(&index);
+    for (guint i = 0; i < n; ++i) {
+        g_snprintf(name, sizeof(name), "TeX%u", i);
+        wad_name_init(&key, name);
+        wad_name_index_insert(&index, &key, i);
+    }
+    g_assert_cmpuint(index.size, ==, n);
+
+    for (guint i = 0; i < n; i += 2) {
+        g_snprintf(name, sizeof(name), "tex%u", i);
+        wad_name_init(&key, name);
+        g_assert_true(wad_name_index_remove(&index, &key));
+        g_assert_false(wad_name_index_remove(&index, &key));
+    }
+    g_assert_cmpuint(index.size, ==, n / 2);
+
+    for (guint i = 0; i < n; ++i) {
+        guint value = G_MAXUINT;
+        g_snprintf(name, sizeof(name), "TEX%u", i);
+        wad_name_init(&key, name);
+        bool found = wad_name_index_lookup(&index, &key, &value);
+        g_assert_cmpint(found, ==, i % 2 == 1);
+        if (found) {
+            g_assert_cmpuint(value, ==, i);
+        }
+    }
+
+    wad_name_index_remove_all(&index);
+    g_assert_cmpuint(index.size, ==, 0);
+    g_assert_false(wad_name_index_lookup(&index, &key, nullptr));
+    wad_name_index_clear(&index);
+}
+
+int main(int argc, char *argv[])
+{
+    g_test_init(&argc, &argv, nullptr);
+    g_test_add_func("/name/folding", test_name_folding);
+    g_test_add_func("/name/index/insert-lookup", test_index_insert_lookup);
+    g_test_add_func("/name/index/remove", test_index_remove);
+    return g_test_run();
+}
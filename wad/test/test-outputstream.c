@@ -0,0 +1,242 @@
+#include "wad/wad-outputstream.h"
+#include "wad/wad-private.h"
+#include "wad/wad-root.h"
+
+#include <gio/gio.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+#define HEADER_SIZE 12
+#define ENTRY_SIZE 32
+#define ENTRY_FILE_TYPE 12
+
+static void
+add_miptex(WadTextureArchive *archive, char const *name, guchar shade)
+{
+    guchar rgba[16 * 16 * 4];
+    for (gsize i = 0; i < sizeof(rgba); i += 4) {
+        rgba[i + 0] = shade;
+        rgba[i + 1] = i / 4;
+        rgba[i + 2] = 255 - shade;
+        rgba[i + 3] = 255;
+    }
+    WadTexture texture = {
+        .type = WAD_TYPE_MIPTEX_FILE,
+        .boxed = wad_miptex_file_new_from_rgba(
+            name,
+            16,
+            16,
+            rgba,
+            16 * 4,
+            WAD_DITHER_NONE,
+            nullptr
+        ),
+    };
+    wad_texture_archive_take_texture(archive, name, &texture);
+}
+
+static GBytes *save(WadTextureArchive *archive)
+{
+    g_autoptr(GOutputStream) memory = g_memory_output_stream_new_resizable();
+    g_autoptr(WadOutputStream) stream = wad_output_stream_new(memory);
+    GError *e = nullptr;
+    wad_output_stream_write_archive(stream, archive, nullptr, &e);
+    g_assert_no_error(e);
+    // Closes `memory` too.
+    g_output_stream_close(G_OUTPUT_STREAM(stream), nullptr, &e);
+    g_assert_no_error(e);
+    return g_memory_output_stream_steal_as_bytes(
+        G_MEMORY_OUTPUT_STREAM(memory)
+    );
+}
+
+static WadRoot *load(GBytes *bytes)
+{
+    g_autoptr(GInputStream) stream
+        = g_memory_input_stream_new_from_bytes(bytes);
+    WadRoot *root = wad_root_new();
+    GError *e = nullptr;
+    wad_root_load_from_stream(root, stream, &e);
+    g_assert_no_error(e);
+    return root;
+}
+
+// Returns the directory entry at `index` in the WAD3 file held by `data`.
+static guchar *directory_entry(guchar *data, guint index)
+{
+    guint32 dir_offset = GUINT32_FROM_LE(*(guint32 *)(data + 8));
+    return data + dir_offset + index * ENTRY_SIZE;
+}
+
+static void test_round_trip(void)
+{
+    g_autoptr(WadTextureArchive) archive = wad_texture_archive_new();
+    add_miptex(archive, "brick", 10);
+    add_miptex(archive, "{grate", 20);
+    add_miptex(archive, "logo", 30);
+    g_autoptr(GBytes) first = save(archive);
+
+    // Mark the last entry as a spray decal, which has no texture type of its
+    // own and must survive a load and save.
+    gsize size = 0;
+    g_autofree guchar *data = g_bytes_unref_to_data(g_bytes_ref(first), &size);
+    g_assert_cmpuint(GUINT32_FROM_LE(*(guint32 *)(data + 4)), ==, 3);
+    guchar *logo = directory_entry(data, 2);
+    g_assert_cmpstr((char const *)logo + 16, ==, "logo");
+    g_assert_cmpuint(logo[ENTRY_FILE_TYPE], ==, WAD_FILE_TYPE_MIPTEX);
+    logo[ENTRY_FILE_TYPE] = WAD_FILE_TYPE_SPRAYDECAL;
+    g_autoptr(GBytes) decal = g_bytes_new(data, size);
+
+    g_autoptr(WadRoot) loaded = load(decal);
+    g_autoptr(GBytes) second = save(wad_root_get_archive(loaded));
+    g_assert_true(g_bytes_equal(second, decal));
+
+    // And once more from the written file.
+    g_autoptr(WadRoot) reloaded = load(second);
+    g_autoptr(GBytes) third = save(wad_root_get_archive(reloaded));
+    g_assert_true(g_bytes_equal(third, decal));
+
+    g_autofree char const **names
+        = wad_texture_archive_get_names(wad_root_get_archive(reloaded));
+    g_assert_cmpuint(g_strv_length((char **)names), ==, 3);
+    WadMiptexFile *a = wad_texture_archive_get_miptex(archive, "{grate");
+    WadMiptexFile *b = wad_texture_archive_get_miptex(
+        wad_root_get_archive(reloaded),
+        "{grate"
+    );
+    g_assert_cmpuint(a->width, ==, b->width);
+    g_assert_cmpuint(a->height, ==, b->height);
+    gsize a_size = 0;
+    gsize b_size = 0;
+    guchar const *a_data = wad_miptex_file_get_mip_data(a, 0, &a_size);
+    guchar const *b_data = wad_miptex_file_get_mip_data(b, 0, &b_size);
+    g_assert_cmpmem(a_data, a_size, b_data, b_size);
+}
+
+// Saves a WAD holding a miptex per name, shaded by its index in `names`.
+static GFile *
+write_source(char const *dir, char const *file_name, char const *const *names)
+{
+    g_autoptr(WadTextureArchive) archive = wad_texture_archive_new();
+    for (guint i = 0; names[i]; ++i) {
+        add_miptex(archive, names[i], i * 10);
+    }
+    g_autofree char *path = g_build_filename(dir, file_name, nullptr);
+    GFile *file = g_file_new_for_path(path);
+    GError *e = nullptr;
+    g_autoptr(GFileOutputStream) file_stream = g_file_replace(
+        file,
+        nullptr,
+        FALSE,
+        G_FILE_CREATE_NONE,
+        nullptr,
+        &e
+    );
+    g_assert_no_error(e);
+    g_autoptr(WadOutputStream) stream
+        = wad_output_stream_new(G_OUTPUT_STREAM(file_stream));
+    wad_output_stream_write_archive(stream, archive, nullptr, &e);
+    g_assert_no_error(e);
+    g_output_stream_close(G_OUTPUT_STREAM(stream), nullptr, &e);
+    g_assert_no_error(e);
+    return file;
+}
+
+static void test_subset(void)
+{
+    GError *e = nullptr;
+    g_autofree char *dir = g_dir_make_tmp("test-outputstream-XXXXXX", &e);
+    g_assert_no_error(e);
+    char const *const a_names[] = {"+0lava", "+1lava", "brick", "sky", nullptr};
+    char const *const b_names[] = {
+        "-0other",
+        "brick",
+        "+2lava",
+        "-0rand",
+        "-1rand",
+        nullptr,
+    };
+    GFile *sources[] = {
+        write_source(dir, "a.wad", a_names),
+        write_source(dir, "b.wad", b_names),
+    };
+
+    g_autoptr(GOutputStream) memory = g_memory_output_stream_new_resizable();
+    g_autoptr(WadOutputStream) stream = wad_output_stream_new(memory);
+    char const *const wanted[] = {
+        "+0LAVA",
+        "brick",
+        "-1rand",
+        "nothere",
+        "+5lava",
+        nullptr,
+    };
+    g_auto(GStrv) missing = nullptr;
+    g_assert_true(wad_output_stream_write_subset(
+        stream,
+        sources,
+        G_N_ELEMENTS(sources),
+        wanted,
+        &missing,
+        nullptr,
+        &e
+    ));
+    g_assert_no_error(e);
+    g_output_stream_close(G_OUTPUT_STREAM(stream), nullptr, &e);
+    g_assert_no_error(e);
+
+    // Frames of a family missing from every source are reported, even though
+    // the rest of the family is included.
+    char const *const expected_missing[] = {"nothere", "+5lava", nullptr};
+    g_assert_cmpstrv(missing, expected_missing);
+
+    g_autoptr(GBytes) bytes = g_memory_output_stream_steal_as_bytes(
+        G_MEMORY_OUTPUT_STREAM(memory)
+    );
+    g_autoptr(WadRoot) root = load(bytes);
+    WadTextureArchive *archive = wad_root_get_archive(root);
+    // Every `+N` frame from both sources, only the `-N` family asked for, and
+    // neither the unrequested texture nor the unrelated family.
+    char const *const expected[] = {
+        "+0lava",
+        "+1lava",
+        "brick",
+        "+2lava",
+        "-0rand",
+        "-1rand",
+        nullptr,
+    };
+    g_autofree char const **names = wad_texture_archive_get_names(archive);
+    g_assert_cmpuint(
+        g_strv_length((char **)names),
+        ==,
+        g_strv_length((char **)expected)
+    );
+    for (guint i = 0; expected[i]; ++i) {
+        g_assert_nonnull(wad_texture_archive_get_miptex(archive, expected[i]));
+    }
+
+    // The first source wins: "brick" is the third texture of a.wad, not the
+    // second of b.wad.
+    WadMiptexFile *brick = wad_texture_archive_get_miptex(archive, "brick");
+    gsize size = 0;
+    guchar const *data = wad_miptex_file_get_mip_data(brick, 0, &size);
+    WadRgb const *palette = wad_miptex_file_get_palette_data(brick, nullptr);
+    g_assert_cmpuint(size, ==, 16 * 16);
+    g_assert_cmpuint(palette[data[0]].rgb[0], ==, 20);
+
+    for (guint i = 0; i < G_N_ELEMENTS(sources); ++i) {
+        g_file_delete(sources[i], nullptr, &e);
+        g_assert_no_error(e);
+        g_object_unref(sources[i]);
+    }
+    g_rmdir(dir);
+}
+
+int main(int argc, char *argv[])
+{
+    g_test_init(&argc, &argv, nullptr);
+    g_test_add_func("/outputstream/round-trip", test_round_trip);
+    g_test_add_func("/outputstream/subset", test_subset);
+    return g_test_run();
+}
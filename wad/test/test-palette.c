@@ -0,0 +1,161 @@
+#include "wad/wad-private.h"
+
+#include <glib.h>
+
+static GArray *make_palette(guchar shade)
+{
+    GArray *palette = g_array_sized_new(FALSE, FALSE, sizeof(WadRgb), 256);
+    g_array_set_size(palette, 256);
+    for (guint i = 0; i < 256; ++i) {
+        WadRgb *color = &g_array_index(palette, WadRgb, i);
+        color->rgb[0] = i;
+        color->rgb[1] = shade;
+        color->rgb[2] = 255 - i;
+    }
+    return palette;
+}
+
+static void test_pool_shares(void)
+{
+    WadPalettePool pool;
+    wad_palette_pool_init(&pool);
+
+    GArray *a = make_palette(1);
+    GBytes *a_bytes = nullptr;
+    guint id = wad_palette_pool_intern(&pool, &a, &a_bytes);
+    g_assert_cmpuint(id, !=, 0);
+    // The palette is moved to read-only storage.
+    g_assert_null(a);
+    g_assert_nonnull(a_bytes);
+
+    GArray *b = make_palette(1);
+    GBytes *b_bytes = nullptr;
+    g_assert_cmpuint(wad_palette_pool_intern(&pool, &b, &b_bytes), ==, id);
+    g_assert_true(b_bytes == a_bytes);
+
+    gsize size = 0;
+    gconstpointer data = g_bytes_get_data(a_bytes, &size);
+    GArray *c = nullptr;
+    GBytes *c_bytes = g_bytes_new(data, size);
+    g_assert_cmpuint(wad_palette_pool_intern(&pool, &c, &c_bytes), ==, id);
+    g_assert_true(c_bytes == a_bytes);
+
+    GArray *d = make_palette(2);
+    GBytes *d_bytes = nullptr;
+    guint other = wad_palette_pool_intern(&pool, &d, &d_bytes);
+    g_assert_cmpuint(other, !=, 0);
+    g_assert_cmpuint(other, !=, id);
+    g_assert_cmpuint(g_hash_table_size(pool.palettes), ==, 2);
+
+    GArray *none = nullptr;
+    GBytes *none_bytes = nullptr;
+    g_assert_cmpuint(wad_palette_pool_intern(&pool, &none, &none_bytes), ==, 0);
+
+    g_bytes_unref(a_bytes);
+    g_bytes_unref(b_bytes);
+    g_bytes_unref(c_bytes);
+    g_bytes_unref(d_bytes);
+    wad_palette_pool_clear(&pool);
+}
+
+static void test_pool_release(void)
+{
+    WadPalettePool pool;
+    wad_palette_pool_init(&pool);
+
+    GArray *a = make_palette(1);
+    GBytes *a_bytes = nullptr;
+    guint id = wad_palette_pool_intern(&pool, &a, &a_bytes);
+    GArray *b = make_palette(1);
+    GBytes *b_bytes = nullptr;
+    wad_palette_pool_intern(&pool, &b, &b_bytes);
+
+    // Unknown ids are ignored.
+    wad_palette_pool_release(&pool, 0);
+    wad_palette_pool_release(&pool, id + 1000);
+
+    wad_palette_pool_release(&pool, id);
+    g_assert_cmpuint(g_hash_table_size(pool.palettes), ==, 1);
+    wad_palette_pool_release(&pool, id);
+    g_assert_cmpuint(g_hash_table_size(pool.palettes), ==, 0);
+    g_assert_cmpuint(g_hash_table_size(pool.by_id), ==, 0);
+
+    // The textures keep their copy after the pool lets go.
+    gsize size = 0;
+    g_bytes_get_data(a_bytes, &size);
+    g_assert_cmpuint(size, ==, 256 * sizeof(WadRgb));
+
+    // Interning the palette again makes a new entry.
+    GArray *c = make_palette(1);
+    GBytes *c_bytes = nullptr;
+    guint again = wad_palette_pool_intern(&pool, &c, &c_bytes);
+    g_assert_cmpuint(again, !=, id);
+    g_assert_true(c_bytes != a_bytes);
+
+    g_bytes_unref(a_bytes);
+    g_bytes_unref(b_bytes);
+    g_bytes_unref(c_bytes);
+    wad_palette_pool_clear(&pool);
+}
+
+static void
+add_miptex(WadTextureArchive *archive, char const *name, guchar shade)
+{
+    guchar rgba[16 * 16 * 4];
+    for (gsize i = 0; i < sizeof(rgba); i += 4) {
+        rgba[i + 0] = shade;
+        rgba[i + 1] = 0;
+        rgba[i + 2] = 0;
+        rgba[i + 3] = 255;
+    }
+    WadTexture texture = {
+        .type = WAD_TYPE_MIPTEX_FILE,
+        .boxed = wad_miptex_file_new_from_rgba(
+            name,
+            16,
+            16,
+            rgba,
+            16 * 4,
+            WAD_DITHER_NONE,
+            nullptr
+        ),
+    };
+    wad_texture_archive_take_texture(archive, name, &texture);
+}
+
+static void test_archive_release(void)
+{
+    g_autoptr(WadTextureArchive) archive = wad_texture_archive_new();
+    add_miptex(archive, "a", 10);
+    add_miptex(archive, "b", 10);
+
+    WadMiptexFile *a = wad_texture_archive_get_miptex(archive, "a");
+    WadMiptexFile *b = wad_texture_archive_get_miptex(archive, "b");
+    g_assert_null(a->palette);
+    g_assert_true(a->palette_bytes == b->palette_bytes);
+    g_assert_cmpuint(a->palette_id, ==, b->palette_id);
+    guint id = a->palette_id;
+
+    // Replacing one user and removing the other drops the palette, so the
+    // same colors come back under a new id.
+    add_miptex(archive, "a", 20);
+    g_assert_cmpuint(
+        wad_texture_archive_get_miptex(archive, "a")->palette_id,
+        !=,
+        id
+    );
+    wad_texture_archive_remove_texture(archive, "b");
+    add_miptex(archive, "c", 10);
+    guint again = wad_texture_archive_get_miptex(archive, "c")->palette_id;
+    g_assert_cmpuint(again, !=, 0);
+    g_assert_cmpuint(again, !=, id);
+}
+
+int main(int argc, char *argv[])
+{
+    g_test_init(&argc, &argv, nullptr);
+    g_test_add_func("/palette/pool/shares", test_pool_shares);
+    g_test_add_func("/palette/pool/release", test_pool_release);
+    g_test_add_func("/palette/archive/release", test_archive_release);
+    return g_test_run();
+}
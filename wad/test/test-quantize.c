@@ -0,0 +1,136 @@
+#include "wad/wad-private.h"
+
+#include <glib.h>
+
+// Fills a width x 16 image with a distinct color per pixel, opaque.
+static guchar *make_image(guint32 width)
+{
+    guchar *rgba = g_new(guchar, (gsize)width * 16 * 4);
+    for (guint32 i = 0; i < width * 16; ++i) {
+        rgba[i * 4 + 0] = (i * 37) & 0xff;
+        rgba[i * 4 + 1] = i & 0xff;
+        rgba[i * 4 + 2] = (i >> 8) * 64;
+        rgba[i * 4 + 3] = 255;
+    }
+    return rgba;
+}
+
+static void test_exact_256(void)
+{
+    g_autofree guchar *rgba = make_image(16);
+    guchar indices[256];
+    WadRgb palette[256];
+
+    wad_quantize(
+        rgba,
+        16,
+        16,
+        16 * 4,
+        false,
+        WAD_DITHER_NONE,
+        indices,
+        palette
+    );
+
+    // Every color fits, so every index is used and maps back exactly.
+    bool used[256] = {};
+    for (guint i = 0; i < 256; ++i) {
+        used[indices[i]] = true;
+        g_assert_cmpmem(palette[indices[i]].rgb, 3, rgba + i * 4, 3);
+    }
+    for (guint i = 0; i < 256; ++i) {
+        g_assert_true(used[i]);
+    }
+}
+
+static void test_keyed_keeps_index(void)
+{
+    // 256 opaque colors are one too many for a keyed palette.
+    g_autofree guchar *rgba = make_image(16);
+    rgba[0 * 4 + 3] = 127;
+    rgba[1 * 4 + 3] = 128;
+    guchar indices[256];
+    WadRgb palette[256];
+
+    wad_quantize(
+        rgba,
+        16,
+        16,
+        16 * 4,
+        true,
+        WAD_DITHER_FLOYD_STEINBERG,
+        indices,
+        palette
+    );
+
+    g_assert_cmpuint(indices[0], ==, WAD_MIPTEX_TRANSPARENT_INDEX);
+    for (guint i = 1; i < 256; ++i) {
+        g_assert_cmpuint(indices[i], <, WAD_MIPTEX_TRANSPARENT_INDEX);
+    }
+    WadRgb const *key = &palette[WAD_MIPTEX_TRANSPARENT_INDEX];
+    g_assert_cmpuint(key->rgb[0], ==, 0);
+    g_assert_cmpuint(key->rgb[1], ==, 0);
+    g_assert_cmpuint(key->rgb[2], ==, 255);
+}
+
+static void test_keyed_exact(void)
+{
+    // 255 opaque colors and one transparent pixel fit exactly.
+    g_autofree guchar *rgba = make_image(16);
+    rgba[255 * 4 + 3] = 0;
+    guchar indices[256];
+    WadRgb palette[256];
+
+    wad_quantize(
+        rgba,
+        16,
+        16,
+        16 * 4,
+        true,
+        WAD_DITHER_NONE,
+        indices,
+        palette
+    );
+
+    g_assert_cmpuint(indices[255], ==, WAD_MIPTEX_TRANSPARENT_INDEX);
+    for (guint i = 0; i < 255; ++i) {
+        g_assert_cmpuint(indices[i], <, WAD_MIPTEX_TRANSPARENT_INDEX);
+        g_assert_cmpmem(palette[indices[i]].rgb, 3, rgba + i * 4, 3);
+    }
+}
+
+static void test_median_cut(void)
+{
+    // 1024 colors must share 256 entries, each near the colors it stands for.
+    g_autofree guchar *rgba = make_image(64);
+    guchar indices[64 * 16];
+    WadRgb palette[256];
+
+    wad_quantize(
+        rgba,
+        64,
+        16,
+        64 * 4,
+        false,
+        WAD_DITHER_NONE,
+        indices,
+        palette
+    );
+
+    for (guint i = 0; i < 64 * 16; ++i) {
+        for (guint c = 0; c < 3; ++c) {
+            gint error = (gint)palette[indices[i]].rgb[c] - rgba[i * 4 + c];
+            g_assert_cmpint(ABS(error), <=, 40);
+        }
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    g_test_init(&argc, &argv, nullptr);
+    g_test_add_func("/quantize/exact-256", test_exact_256);
+    g_test_add_func("/quantize/keyed/keeps-index", test_keyed_keeps_index);
+    g_test_add_func("/quantize/keyed/exact", test_keyed_exact);
+    g_test_add_func("/quantize/median-cut", test_median_cut);
+    return g_test_run();
+}
@@ -0,0 +1,90 @@
+#include "wad/wad-private.h"
+#include "wad/wad-rgbacache.h"
+
+#include <glib.h>
+
+static void
+add_miptex(WadTextureArchive *archive, char const *name, guchar shade)
+{
+    guchar rgba[16 * 16 * 4];
+    for (gsize i = 0; i < sizeof(rgba); i += 4) {
+        rgba[i + 0] = shade;
+        rgba[i + 1] = 0;
+        rgba[i + 2] = 0;
+        rgba[i + 3] = 255;
+    }
+    WadTexture texture = {
+        .type = WAD_TYPE_MIPTEX_FILE,
+        .boxed = wad_miptex_file_new_from_rgba(
+            name,
+            16,
+            16,
+            rgba,
+            16 * 4,
+            WAD_DITHER_NONE,
+            nullptr
+        ),
+    };
+    wad_texture_archive_take_texture(archive, name, &texture);
+}
+
+// Returns the red channel of the first pixel, or -1 if there is no texture.
+static gint lookup_red(WadRgbaCache *cache, char const *name)
+{
+    g_autoptr(GBytes) pixels
+        = wad_rgba_cache_lookup(cache, name, nullptr, nullptr);
+    if (!pixels) {
+        return -1;
+    }
+    return ((guchar const *)g_bytes_get_data(pixels, nullptr))[0];
+}
+
+static void test_lookup(void)
+{
+    g_autoptr(WadTextureArchive) archive = wad_texture_archive_new();
+    add_miptex(archive, "a", 10);
+    g_autoptr(WadRgbaCache) cache = wad_rgba_cache_new(archive, 1024 * 1024);
+
+    guint width = 0;
+    guint height = 0;
+    g_autoptr(GBytes) first
+        = wad_rgba_cache_lookup(cache, "A", &width, &height);
+    g_assert_nonnull(first);
+    g_assert_cmpuint(width, ==, 16);
+    g_assert_cmpuint(height, ==, 16);
+    g_autoptr(GBytes) second
+        = wad_rgba_cache_lookup(cache, "a", nullptr, nullptr);
+    g_assert_true(first == second);
+    g_assert_cmpint(lookup_red(cache, "b"), ==, -1);
+    g_assert_cmpuint(wad_rgba_cache_get_hits(cache), ==, 1);
+    g_assert_cmpuint(wad_rgba_cache_get_misses(cache), ==, 2);
+    g_assert_cmpuint(wad_rgba_cache_get_size(cache), ==, 16 * 16 * 4);
+}
+
+static void test_invalidate(void)
+{
+    g_autoptr(WadTextureArchive) archive = wad_texture_archive_new();
+    add_miptex(archive, "a", 10);
+    add_miptex(archive, "b", 30);
+    g_autoptr(WadRgbaCache) cache = wad_rgba_cache_new(archive, 1024 * 1024);
+    g_assert_cmpint(lookup_red(cache, "a"), ==, 10);
+    g_assert_cmpint(lookup_red(cache, "b"), ==, 30);
+
+    // Replacing a texture drops the stale pixels.
+    add_miptex(archive, "A", 20);
+    g_assert_cmpuint(wad_rgba_cache_get_size(cache), ==, 16 * 16 * 4);
+    g_assert_cmpint(lookup_red(cache, "a"), ==, 20);
+    g_assert_cmpuint(wad_rgba_cache_get_size(cache), ==, 2 * 16 * 16 * 4);
+
+    wad_texture_archive_remove_texture(archive, "b");
+    g_assert_cmpuint(wad_rgba_cache_get_size(cache), ==, 16 * 16 * 4);
+    g_assert_cmpint(lookup_red(cache, "b"), ==, -1);
+}
+
+int main(int argc, char *argv[])
+{
+    g_test_init(&argc, &argv, nullptr);
+    g_test_add_func("/rgbacache/lookup", test_lookup);
+    g_test_add_func("/rgbacache/invalidate", test_invalidate);
+    return g_test_run();
+}
@@ -0,0 +1,217 @@
+#include "wad/wad-loaderror.h"
+#include "wad/wad-outputstream.h"
+#include "wad/wad-private.h"
+#include "wad/wad-rgbacache.h"
+#include "wad/wad-root.h"
+
+#include <gio/gio.h>
+#include <glib.h>
+#include <glib/gstdio.h>
+
+static void add_miptex(
+    WadTextureArchive *archive,
+    char const *name,
+    guint size,
+    guchar shade
+)
+{
+    g_autofree guchar *rgba = g_malloc(size * size * 4);
+    for (gsize i = 0; i < size * size * 4; i += 4) {
+        rgba[i + 0] = shade;
+        rgba[i + 1] = 0;
+        rgba[i + 2] = 0;
+        rgba[i + 3] = 255;
+    }
+    WadTexture texture = {
+        .type = WAD_TYPE_MIPTEX_FILE,
+        .boxed = wad_miptex_file_new_from_rgba(
+            name,
+            size,
+            size,
+            rgba,
+            size * 4,
+            WAD_DITHER_NONE,
+            nullptr
+        ),
+    };
+    wad_texture_archive_take_texture(archive, name, &texture);
+}
+
+// Returns the red channel of the first pixel of `name`, expanded by `cache`.
+static guchar lookup_red(WadRgbaCache *cache, char const *name)
+{
+    g_autoptr(GBytes) pixels
+        = wad_rgba_cache_lookup(cache, name, nullptr, nullptr);
+    g_assert_nonnull(pixels);
+    return ((guchar const *)g_bytes_get_data(pixels, nullptr))[0];
+}
+
+// Writes `archive` to `file` as a WAD3 file, replacing it.
+static void write_archive(GFile *file, WadTextureArchive *archive)
+{
+    GError *e = nullptr;
+    g_autoptr(GFileOutputStream) file_stream = g_file_replace(
+        file,
+        nullptr,
+        FALSE,
+        G_FILE_CREATE_NONE,
+        nullptr,
+        &e
+    );
+    g_assert_no_error(e);
+    g_autoptr(WadOutputStream) stream
+        = wad_output_stream_new(G_OUTPUT_STREAM(file_stream));
+    wad_output_stream_write_archive(stream, archive, nullptr, &e);
+    g_assert_no_error(e);
+    g_output_stream_close(G_OUTPUT_STREAM(stream), nullptr, &e);
+    g_assert_no_error(e);
+}
+
+static void on_texture_signal(WadRoot *, char const *name, gpointer user_data)
+{
+    g_ptr_array_add(user_data, g_strdup(name));
+}
+
+static void
+connect_texture_signal(WadRoot *root, char const *signal, GPtrArray *names)
+{
+    g_signal_connect(root, signal, G_CALLBACK(on_texture_signal), names);
+}
+
+static void assert_names(GPtrArray *names, char const *expected)
+{
+    if (!expected) {
+        g_assert_cmpuint(names->len, ==, 0);
+        return;
+    }
+    g_assert_cmpuint(names->len, ==, 1);
+    g_assert_cmpstr(names->pdata[0], ==, expected);
+}
+
+static void test_watch_reload(void)
+{
+    GError *e = nullptr;
+    g_autofree char *dir = g_dir_make_tmp("test-root-XXXXXX", &e);
+    g_assert_no_error(e);
+    g_autofree char *path = g_build_filename(dir, "watched.wad", nullptr);
+    g_autoptr(GFile) file = g_file_new_for_path(path);
+
+    g_autoptr(WadTextureArchive) source = wad_texture_archive_new();
+    add_miptex(source, "deleted", 32, 30);
+    add_miptex(source, "same", 16, 10);
+    add_miptex(source, "edited", 16, 20);
+    write_archive(file, source);
+
+    g_autoptr(WadRoot) root = wad_root_new();
+    g_autoptr(GPtrArray) added = g_ptr_array_new_with_free_func(g_free);
+    g_autoptr(GPtrArray) changed = g_ptr_array_new_with_free_func(g_free);
+    g_autoptr(GPtrArray) removed = g_ptr_array_new_with_free_func(g_free);
+    connect_texture_signal(root, "texture-added", added);
+    connect_texture_signal(root, "texture-changed", changed);
+    connect_texture_signal(root, "texture-removed", removed);
+    wad_root_watch_file(root, file, &e);
+    g_assert_no_error(e);
+    // The initial load is silent.
+    assert_names(added, nullptr);
+    assert_names(changed, nullptr);
+    assert_names(removed, nullptr);
+
+    WadTextureArchive *archive = wad_root_get_archive(root);
+    g_autoptr(WadRgbaCache) cache = wad_rgba_cache_new(archive, 1024 * 1024);
+    g_assert_cmpuint(lookup_red(cache, "edited"), ==, 20);
+
+    // Nothing changed on disk, so nothing is reported.
+    wad_root_reload(root, &e);
+    g_assert_no_error(e);
+    assert_names(added, nullptr);
+    assert_names(changed, nullptr);
+    assert_names(removed, nullptr);
+
+    // "same" and "edited" both move up in the file as the larger "deleted"
+    // goes, but only "edited" has new content.
+    wad_texture_archive_remove_texture(source, "deleted");
+    add_miptex(source, "edited", 16, 40);
+    add_miptex(source, "new", 16, 50);
+    write_archive(file, source);
+    wad_root_reload(root, &e);
+    g_assert_no_error(e);
+    assert_names(added, "new");
+    assert_names(changed, "edited");
+    assert_names(removed, "deleted");
+
+    // The archive and the caches built on it see the new textures.
+    g_assert_null(wad_texture_archive_get_miptex(archive, "deleted"));
+    g_assert_nonnull(wad_texture_archive_get_miptex(archive, "new"));
+    g_assert_cmpuint(lookup_red(cache, "edited"), ==, 40);
+
+    // A new shade keeps the offset and size of "edited", so only its pixels
+    // tell the change apart.
+    g_ptr_array_set_size(added, 0);
+    g_ptr_array_set_size(changed, 0);
+    g_ptr_array_set_size(removed, 0);
+    add_miptex(source, "edited", 16, 60);
+    write_archive(file, source);
+    wad_root_reload(root, &e);
+    g_assert_no_error(e);
+    assert_names(added, nullptr);
+    assert_names(changed, "edited");
+    assert_names(removed, nullptr);
+    g_assert_cmpuint(lookup_red(cache, "edited"), ==, 60);
+
+    wad_root_unwatch(root);
+    g_file_delete(file, nullptr, &e);
+    g_assert_no_error(e);
+    g_rmdir(dir);
+}
+
+// A header claiming far more directory entries than the file holds.
+static guchar const bogus_header[] = {
+    'W', 'A', 'D', '3', 0xff, 0xff, 0xff, 0xff, 12, 0, 0, 0,
+};
+
+static void test_mapped_truncated(void)
+{
+    GError *e = nullptr;
+    g_autofree char *dir = g_dir_make_tmp("test-root-XXXXXX", &e);
+    g_assert_no_error(e);
+    g_autofree char *path = g_build_filename(dir, "bogus.wad", nullptr);
+    g_file_set_contents(
+        path,
+        (char const *)bogus_header,
+        sizeof(bogus_header),
+        &e
+    );
+    g_assert_no_error(e);
+
+    g_autoptr(GFile) file = g_file_new_for_path(path);
+    g_autoptr(WadRoot) root = wad_root_new();
+    wad_root_load_from_mapped_file(root, file, &e);
+    g_assert_error(e, WAD_LOAD_ERROR, WAD_LOAD_ERROR_TRUNCATED);
+    g_clear_error(&e);
+
+    g_unlink(path);
+    g_rmdir(dir);
+}
+
+static void test_stream_truncated(void)
+{
+    g_autoptr(GInputStream) stream = g_memory_input_stream_new_from_data(
+        bogus_header,
+        sizeof(bogus_header),
+        nullptr
+    );
+    g_autoptr(WadRoot) root = wad_root_new();
+    GError *e = nullptr;
+    wad_root_load_from_stream(root, stream, &e);
+    g_assert_error(e, WAD_LOAD_ERROR, WAD_LOAD_ERROR_TRUNCATED);
+    g_clear_error(&e);
+}
+
+int main(int argc, char *argv[])
+{
+    g_test_init(&argc, &argv, nullptr);
+    g_test_add_func("/root/mapped/truncated", test_mapped_truncated);
+    g_test_add_func("/root/stream/truncated", test_stream_truncated);
+    g_test_add_func("/root/watch/reload", test_watch_reload);
+    return g_test_run();
+}
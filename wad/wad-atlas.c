@@ -0,0 +1,554 @@
+#include "wad-atlas.h"
+
+#include "wad-private.h"
+
+// clang-format skip
+G_DEFINE_QUARK(wad-atlas-error-quark, wad_atlas_error)
+
+// WadAtlasRegion
+
+G_DEFINE_BOXED_TYPE(
+    WadAtlasRegion,
+    wad_atlas_region,
+    wad_atlas_region_copy,
+    wad_atlas_region_free
+)
+
+WadAtlasRegion *wad_atlas_region_copy(WadAtlasRegion const *region)
+{
+    WadAtlasRegion *copy = g_new(WadAtlasRegion, 1);
+    memcpy(copy, region, sizeof(WadAtlasRegion));
+    return copy;
+}
+
+void wad_atlas_region_free(WadAtlasRegion *region)
+{
+    g_free(region);
+}
+
+// WadAtlas
+
+/**
+ * WadAtlas:
+ *
+ * Packs miptex textures into a few large RGBA pages.
+ *
+ * Add textures with wad_atlas_add_miptex() or wad_atlas_add_archive(), then
+ * call wad_atlas_build(). Textures are placed with a skyline bottom-left
+ * packer, tallest first, and opened onto a new page when the current pages
+ * are full. Each texture's edge pixels are repeated into its padding so that
+ * filtering near the edges does not pick up its neighbours.
+ *
+ * Texture names are matched as in [class@WadTextureArchive].
+ */
+struct _WadAtlas {
+    GObject parent_instance;
+    guint max_size;
+    guint padding;
+    bool power_of_two;
+    GArray *items;      // Array<Item>
+    WadNameIndex index; // Folded name -> position in items
+    GArray *pages;      // Array<Page>
+};
+
+G_DEFINE_FINAL_TYPE(WadAtlas, wad_atlas, G_TYPE_OBJECT)
+
+// Private /////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    char *name;
+    WadMiptexFile *miptex;
+    WadAtlasRegion region;
+} Item;
+
+// A horizontal segment of the skyline: the top of everything packed so far.
+typedef struct {
+    guint x, y, width;
+} SkylineNode;
+
+typedef struct {
+    GArray *skyline; // Array<SkylineNode>, left to right
+    guint width, height;
+    GBytes *pixels;
+} Page;
+
+typedef struct {
+    WadAtlas *atlas;
+    WadGammaTable const *gamma;
+    guchar **pixels; // One buffer per page
+} RenderJob;
+
+static void item_clear(Item *item)
+{
+    g_clear_pointer(&item->name, g_free);
+    g_clear_pointer(&item->miptex, wad_miptex_file_free);
+}
+
+static void page_clear(Page *page)
+{
+    g_clear_pointer(&page->skyline, g_array_unref);
+    g_clear_pointer(&page->pixels, g_bytes_unref);
+}
+
+static guint round_up_power_of_two(guint value)
+{
+    guint result = 1;
+    while (result < value) {
+        result <<= 1;
+    }
+    return result;
+}
+
+static guint round_down_power_of_two(guint value)
+{
+    guint result = 1;
+    while (result <= value / 2) {
+        result <<= 1;
+    }
+    return result;
+}
+
+/*
+ * Returns the height at which a `width` x `height` rectangle would rest with
+ * its left edge on node `i`, or G_MAXUINT if it would not fit.
+ */
+static guint skyline_fit(
+    GArray const *skyline,
+    guint i,
+    guint width,
+    guint height,
+    guint size
+)
+{
+    SkylineNode const *nodes = (SkylineNode const *)skyline->data;
+    if (nodes[i].x + width > size) {
+        return G_MAXUINT;
+    }
+    guint y = 0;
+    guint remaining = width;
+    // The skyline spans the whole page, so this stays in bounds.
+    for (guint j = i; remaining > 0; ++j) {
+        y = MAX(y, nodes[j].y);
+        if (y + height > size) {
+            return G_MAXUINT;
+        }
+        remaining -= MIN(remaining, nodes[j].width);
+    }
+    return y;
+}
+
+static bool page_insert(
+    Page *page,
+    guint size,
+    guint width,
+    guint height,
+    guint *x,
+    guint *y
+)
+{
+    GArray *skyline = page->skyline;
+    guint best = G_MAXUINT;
+    guint best_top = G_MAXUINT;
+    guint best_y = 0;
+    for (guint i = 0; i < skyline->len; ++i) {
+        guint fit_y = skyline_fit(skyline, i, width, height, size);
+        if (fit_y != G_MAXUINT && fit_y + height < best_top) {
+            best = i;
+            best_top = fit_y + height;
+            best_y = fit_y;
+        }
+    }
+    if (best == G_MAXUINT) {
+        return false;
+    }
+
+    SkylineNode node = {
+        .x = g_array_index(skyline, SkylineNode, best).x,
+        .y = best_top,
+        .width = width,
+    };
+    g_array_insert_val(skyline, best, node);
+    // Trim the nodes now hidden under the new one.
+    for (guint j = best + 1; j < skyline->len;) {
+        SkylineNode const *prev = &g_array_index(skyline, SkylineNode, j - 1);
+        SkylineNode *next = &g_array_index(skyline, SkylineNode, j);
+        guint prev_end = prev->x + prev->width;
+        if (next->x >= prev_end) {
+            break;
+        }
+        guint overlap = prev_end - next->x;
+        if (next->width <= overlap) {
+            g_array_remove_index(skyline, j);
+            continue;
+        }
+        next->x += overlap;
+        next->width -= overlap;
+        break;
+    }
+    // Merge neighbours at the same height.
+    for (guint j = 0; j + 1 < skyline->len;) {
+        SkylineNode *a = &g_array_index(skyline, SkylineNode, j);
+        SkylineNode const *b = &g_array_index(skyline, SkylineNode, j + 1);
+        if (a->y == b->y) {
+            a->width += b->width;
+            g_array_remove_index(skyline, j + 1);
+        } else {
+            j += 1;
+        }
+    }
+
+    *x = node.x;
+    *y = best_y;
+    page->width = MAX(page->width, node.x + width);
+    page->height = MAX(page->height, best_top);
+    return true;
+}
+
+static gint compare_items(gconstpointer a, gconstpointer b)
+{
+    Item const *x = *(Item const *const *)a;
+    Item const *y = *(Item const *const *)b;
+    if (x->miptex->height != y->miptex->height) {
+        return x->miptex->height > y->miptex->height ? -1 : 1;
+    }
+    if (x->miptex->width != y->miptex->width) {
+        return x->miptex->width > y->miptex->width ? -1 : 1;
+    }
+    return 0;
+}
+
+// Copies an item's image onto its page, repeating its edges into the padding.
+static void render_item(guint index, gpointer user_data)
+{
+    RenderJob const *job = user_data;
+    WadAtlas *self = job->atlas;
+    Item const *item = &g_array_index(self->items, Item, index);
+    WadAtlasRegion const *region = &item->region;
+    if (region->width == 0 || region->height == 0) {
+        return;
+    }
+    Page const *page = &g_array_index(self->pages, Page, region->page);
+    gsize page_stride = (gsize)page->width * 4;
+    gsize row_size = (gsize)region->width * 4;
+    g_autofree guchar *image = g_new(guchar, row_size * region->height);
+    wad_miptex_file_to_rgba(item->miptex, 0, job->gamma, image, row_size);
+
+    guint pad = self->padding;
+    guchar *dest = job->pixels[region->page];
+    for (guint py = 0; py < region->height + 2 * pad; ++py) {
+        guint sy = CLAMP(py, pad, region->height + pad - 1) - pad;
+        guchar const *src = image + sy * row_size;
+        guchar *row = dest + (region->y - pad + py) * page_stride
+                    + (gsize)(region->x - pad) * 4;
+        for (guint px = 0; px < pad; ++px) {
+            memcpy(row + px * 4, src, 4);
+        }
+        memcpy(row + pad * 4, src, row_size);
+        for (guint px = 0; px < pad; ++px) {
+            memcpy(row + pad * 4 + row_size + px * 4, src + row_size - 4, 4);
+        }
+    }
+}
+
+// GObject /////////////////////////////////////////////////////////////////////
+
+static void wad_atlas_finalize(GObject *object)
+{
+    WadAtlas *self = WAD_ATLAS(object);
+    g_clear_pointer(&self->items, g_array_unref);
+    g_clear_pointer(&self->pages, g_array_unref);
+    wad_name_index_clear(&self->index);
+    G_OBJECT_CLASS(wad_atlas_parent_class)->finalize(object);
+}
+
+// WadAtlas ////////////////////////////////////////////////////////////////////
+
+static void wad_atlas_class_init(WadAtlasClass *klass)
+{
+    GObjectClass *oclass = G_OBJECT_CLASS(klass);
+    oclass->finalize = wad_atlas_finalize;
+}
+
+static void wad_atlas_init(WadAtlas *self)
+{
+    self->items = g_array_new(FALSE, TRUE, sizeof(Item));
+    g_array_set_clear_func(self->items, (GDestroyNotify)item_clear);
+    self->pages = g_array_new(FALSE, TRUE, sizeof(Page));
+    g_array_set_clear_func(self->pages, (GDestroyNotify)page_clear);
+    wad_name_index_init(&self->index);
+}
+
+// Public //////////////////////////////////////////////////////////////////////
+
+/**
+ * wad_atlas_new:
+ * @max_size: Maximum width and height of a page, in pixels.
+ * @padding: Pixels of padding around each texture.
+ * @power_of_two: Whether pages must have power-of-two sizes. If set,
+ * @max_size is rounded down to a power of two.
+ *
+ * Creates an empty atlas.
+ *
+ * Returns: A new [class@WadAtlas].
+ */
+WadAtlas *wad_atlas_new(guint max_size, guint padding, gboolean power_of_two)
+{
+    g_return_val_if_fail(max_size > 0, nullptr);
+
+    WadAtlas *self = g_object_new(WAD_TYPE_ATLAS, nullptr);
+    self->max_size
+        = power_of_two ? round_down_power_of_two(max_size) : max_size;
+    self->padding = padding;
+    self->power_of_two = power_of_two;
+    return self;
+}
+
+/**
+ * wad_atlas_add_miptex:
+ * @atlas: A [class@WadAtlas].
+ * @texture_name: Name to look the texture up by.
+ * @miptex: The texture to add. The atlas keeps a copy.
+ *
+ * Adds a texture to be packed by the next call to wad_atlas_build(),
+ * replacing any texture of the same name.
+ */
+void wad_atlas_add_miptex(
+    WadAtlas *self,
+    char const *texture_name,
+    WadMiptexFile const *miptex
+)
+{
+    g_return_if_fail(WAD_IS_ATLAS(self));
+    g_return_if_fail(texture_name != nullptr);
+    g_return_if_fail(miptex != nullptr);
+
+    WadName key;
+    guint i = 0;
+    wad_name_init(&key, texture_name);
+    if (!wad_name_index_lookup(&self->index, &key, &i)) {
+        i = self->items->len;
+        g_array_set_size(self->items, i + 1);
+        wad_name_index_insert(&self->index, &key, i);
+    }
+    Item *item = &g_array_index(self->items, Item, i);
+    item_clear(item);
+    item->name = g_strdup(texture_name);
+    item->miptex = wad_miptex_file_copy(miptex);
+}
+
+/**
+ * wad_atlas_add_archive:
+ * @atlas: A [class@WadAtlas].
+ * @archive: The archive to add textures from.
+ *
+ * Adds every miptex in `archive` with wad_atlas_add_miptex(). Other kinds of
+ * texture are skipped.
+ */
+void wad_atlas_add_archive(WadAtlas *self, WadTextureArchive *archive)
+{
+    g_return_if_fail(WAD_IS_ATLAS(self));
+    g_return_if_fail(WAD_IS_TEXTURE_ARCHIVE(archive));
+
+    g_autofree char const **names = wad_texture_archive_get_names(archive);
+    for (char const **name = names; *name != nullptr; ++name) {
+        WadMiptexFile *miptex = wad_texture_archive_get_miptex(archive, *name);
+        if (miptex) {
+            wad_atlas_add_miptex(self, *name, miptex);
+        }
+    }
+}
+
+/**
+ * wad_atlas_build:
+ * @atlas: A [class@WadAtlas].
+ * @gamma: (nullable): Color correction to apply, or `NULL` for none.
+ * @error: The return location for [struct@GError].
+ *
+ * Packs every added texture and renders the pages, replacing the result of
+ * any previous build.
+ *
+ * Pages are trimmed to the area actually used, then rounded up to powers of
+ * two if the atlas was created with `power_of_two` set.
+ */
+void wad_atlas_build(WadAtlas *self, WadGammaTable const *gamma, GError **error)
+{
+    g_return_if_fail(WAD_IS_ATLAS(self));
+    g_return_if_fail(error == nullptr || *error == nullptr);
+
+    g_array_set_size(self->pages, 0);
+    guint size = self->max_size;
+    guint pad = self->padding;
+
+    g_autoptr(GPtrArray) order = g_ptr_array_sized_new(self->items->len);
+    for (guint i = 0; i < self->items->len; ++i) {
+        Item *item = &g_array_index(self->items, Item, i);
+        item->region = (WadAtlasRegion){};
+        g_ptr_array_add(order, item);
+    }
+    g_ptr_array_sort(order, compare_items);
+
+    for (guint i = 0; i < order->len; ++i) {
+        Item *item = g_ptr_array_index(order, i);
+        guint width = item->miptex->width;
+        guint height = item->miptex->height;
+        if (width == 0 || height == 0) {
+            continue;
+        }
+        if ((guint64)width + 2 * pad > size
+            || (guint64)height + 2 * pad > size) {
+            g_set_error(
+                error,
+                WAD_ATLAS_ERROR,
+                WAD_ATLAS_ERROR_TOO_LARGE,
+                "Texture '%s' (%ux%u) does not fit on a %ux%u page",
+                item->name,
+                width,
+                height,
+                size,
+                size
+            );
+            g_array_set_size(self->pages, 0);
+            return;
+        }
+        guint padded_width = width + 2 * pad;
+        guint padded_height = height + 2 * pad;
+        guint x = 0;
+        guint y = 0;
+        guint page = 0;
+        for (; page < self->pages->len; ++page) {
+            Page *p = &g_array_index(self->pages, Page, page);
+            if (page_insert(p, size, padded_width, padded_height, &x, &y)) {
+                break;
+            }
+        }
+        if (page == self->pages->len) {
+            g_array_set_size(self->pages, page + 1);
+            Page *p = &g_array_index(self->pages, Page, page);
+            p->skyline = g_array_new(FALSE, FALSE, sizeof(SkylineNode));
+            SkylineNode ground = {.x = 0, .y = 0, .width = size};
+            g_array_append_val(p->skyline, ground);
+            page_insert(p, size, padded_width, padded_height, &x, &y);
+        }
+        item->region = (WadAtlasRegion){
+            .page = page,
+            .x = x + pad,
+            .y = y + pad,
+            .width = width,
+            .height = height,
+        };
+    }
+
+    g_autofree guchar **pixels = g_new0(guchar *, self->pages->len);
+    for (guint i = 0; i < self->pages->len; ++i) {
+        Page *page = &g_array_index(self->pages, Page, i);
+        if (self->power_of_two) {
+            page->width = round_up_power_of_two(page->width);
+            page->height = round_up_power_of_two(page->height);
+        }
+        pixels[i] = g_new0(guchar, (gsize)page->width * page->height * 4);
+    }
+    for (guint i = 0; i < self->items->len; ++i) {
+        WadAtlasRegion *region = &g_array_index(self->items, Item, i).region;
+        if (region->width == 0) {
+            continue;
+        }
+        Page const *page = &g_array_index(self->pages, Page, region->page);
+        region->u0 = (gfloat)region->x / page->width;
+        region->v0 = (gfloat)region->y / page->height;
+        region->u1 = (gfloat)(region->x + region->width) / page->width;
+        region->v1 = (gfloat)(region->y + region->height) / page->height;
+    }
+
+    // Items cover disjoint parts of the pages, so they can be drawn at once.
+    RenderJob job = {
+        .atlas = self,
+        .gamma = gamma,
+        .pixels = pixels,
+    };
+    wad_parallel_for(self->items->len, 0, render_item, &job);
+
+    for (guint i = 0; i < self->pages->len; ++i) {
+        Page *page = &g_array_index(self->pages, Page, i);
+        page->pixels = g_bytes_new_take(
+            pixels[i],
+            (gsize)page->width * page->height * 4
+        );
+        g_clear_pointer(&page->skyline, g_array_unref);
+    }
+}
+
+/**
+ * wad_atlas_get_n_pages:
+ * @atlas: A [class@WadAtlas].
+ *
+ * Gets the number of pages produced by the last wad_atlas_build().
+ *
+ * Returns: The number of pages.
+ */
+guint wad_atlas_get_n_pages(WadAtlas *self)
+{
+    g_return_val_if_fail(WAD_IS_ATLAS(self), 0);
+    return self->pages->len;
+}
+
+/**
+ * wad_atlas_get_page:
+ * @atlas: A [class@WadAtlas].
+ * @page: Index of the page.
+ * @width: (out) (optional): Return location for the width of the page.
+ * @height: (out) (optional): Return location for the height of the page.
+ *
+ * Gets the pixels of a page, as tightly-packed 8-bit RGBA rows.
+ *
+ * Returns: (transfer full): The pixels.
+ */
+GBytes *
+wad_atlas_get_page(WadAtlas *self, guint page, guint *width, guint *height)
+{
+    g_return_val_if_fail(WAD_IS_ATLAS(self), nullptr);
+    g_return_val_if_fail(page < self->pages->len, nullptr);
+
+    Page const *p = &g_array_index(self->pages, Page, page);
+    if (width) {
+        *width = p->width;
+    }
+    if (height) {
+        *height = p->height;
+    }
+    return g_bytes_ref(p->pixels);
+}
+
+/**
+ * wad_atlas_get_region:
+ * @atlas: A [class@WadAtlas].
+ * @texture_name: Name of the texture.
+ * @region: (out caller-allocates): Return location for the texture's region.
+ *
+ * Looks up where a texture was placed by the last wad_atlas_build().
+ *
+ * Returns: Whether the texture was placed.
+ */
+gboolean wad_atlas_get_region(
+    WadAtlas *self,
+    char const *texture_name,
+    WadAtlasRegion *region
+)
+{
+    g_return_val_if_fail(WAD_IS_ATLAS(self), FALSE);
+    g_return_val_if_fail(texture_name != nullptr, FALSE);
+    g_return_val_if_fail(region != nullptr, FALSE);
+
+    WadName key;
+    guint i = 0;
+    wad_name_init(&key, texture_name);
+    if (self->pages->len == 0
+        || !wad_name_index_lookup(&self->index, &key, &i)) {
+        return FALSE;
+    }
+    Item const *item = &g_array_index(self->items, Item, i);
+    if (item->region.width == 0) {
+        return FALSE;
+    }
+    *region = item->region;
+    return TRUE;
+}
@@ -0,0 +1,90 @@
+#pragma once
+
+#include "wad/wad-gammatable.h"
+#include "wad/wad-miptexfile.h"
+#include "wad/wad-texturearchive.h"
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+/**
+ * WAD_ATLAS_ERROR:
+ *
+ * Error domain for [class@WadAtlas].
+ */
+#define WAD_ATLAS_ERROR wad_atlas_error_quark()
+
+/**
+ * WadAtlasError:
+ * @WAD_ATLAS_ERROR_TOO_LARGE: A texture does not fit on a page.
+ *
+ * Error codes for `WAD_ATLAS_ERROR`.
+ */
+typedef enum {
+    WAD_ATLAS_ERROR_TOO_LARGE,
+} WadAtlasError;
+
+GQuark wad_atlas_error_quark(void);
+
+// WadAtlasRegion
+
+#define WAD_TYPE_ATLAS_REGION wad_atlas_region_get_type()
+
+/**
+ * WadAtlasRegion:
+ * @page: Index of the page holding the texture.
+ * @x: Left edge of the texture on the page, in pixels.
+ * @y: Top edge of the texture on the page, in pixels.
+ * @width: Width of the texture, in pixels.
+ * @height: Height of the texture, in pixels.
+ * @u0: Left edge of the texture, in texture coordinates.
+ * @v0: Top edge of the texture, in texture coordinates.
+ * @u1: Right edge of the texture, in texture coordinates.
+ * @v1: Bottom edge of the texture, in texture coordinates.
+ *
+ * Where a texture was placed in a [class@WadAtlas]. Padding is not included.
+ */
+typedef struct {
+    guint page;
+    guint x, y, width, height;
+    gfloat u0, v0, u1, v1;
+} WadAtlasRegion;
+
+GType wad_atlas_region_get_type(void);
+WadAtlasRegion *wad_atlas_region_copy(WadAtlasRegion const *region);
+void wad_atlas_region_free(WadAtlasRegion *region);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(WadAtlasRegion, wad_atlas_region_free)
+
+// WadAtlas
+
+#define WAD_TYPE_ATLAS wad_atlas_get_type()
+
+G_DECLARE_FINAL_TYPE(WadAtlas, wad_atlas, WAD, ATLAS, GObject)
+
+WadAtlas *wad_atlas_new(guint max_size, guint padding, gboolean power_of_two);
+
+void wad_atlas_add_miptex(
+    WadAtlas *atlas,
+    char const *texture_name,
+    WadMiptexFile const *miptex
+);
+
+void wad_atlas_add_archive(WadAtlas *atlas, WadTextureArchive *archive);
+
+void
+wad_atlas_build(WadAtlas *atlas, WadGammaTable const *gamma, GError **error);
+
+guint wad_atlas_get_n_pages(WadAtlas *atlas);
+
+GBytes *
+wad_atlas_get_page(WadAtlas *atlas, guint page, guint *width, guint *height);
+
+gboolean wad_atlas_get_region(
+    WadAtlas *atlas,
+    char const *texture_name,
+    WadAtlasRegion *region
+);
+
+G_END_DECLS
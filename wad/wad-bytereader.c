@@ -0,0 +1,316 @@
+/*
+ * In-memory counterpart to WadInputStream. Reads the same structures, but
+ * image and palette data are returned as GBytes slices of the source instead
+ * of being copied out.
+ */
+#include "wad-loaderror.h"
+#include "wad-private.h"
+
+// Private /////////////////////////////////////////////////////////////////////
+
+static bool check_remaining(WadByteReader *self, gsize n, GError **error)
+{
+    if (n > self->size - self->offset) {
+        g_set_error(
+            error,
+            WAD_LOAD_ERROR,
+            WAD_LOAD_ERROR_TRUNCATED,
+            "Unexpected end of data reading %" G_GSIZE_FORMAT
+            " bytes at offset %#" G_GSIZE_MODIFIER "x",
+            n,
+            self->offset
+        );
+        return false;
+    }
+    return true;
+}
+
+// Internal ////////////////////////////////////////////////////////////////////
+
+void wad_byte_reader_init(WadByteReader *self, GBytes *bytes)
+{
+    self->bytes = g_bytes_ref(bytes);
+    self->data = g_bytes_get_data(bytes, &self->size);
+    self->offset = 0;
+}
+
+void wad_byte_reader_clear(WadByteReader *self)
+{
+    g_clear_pointer(&self->bytes, g_bytes_unref);
+    self->data = nullptr;
+    self->size = 0;
+    self->offset = 0;
+}
+
+void wad_byte_reader_seek(WadByteReader *self, gsize offset, GError **error)
+{
+    if (offset > self->size) {
+        g_set_error(
+            error,
+            WAD_LOAD_ERROR,
+            WAD_LOAD_ERROR_TRUNCATED,
+            "Seek to %#" G_GSIZE_MODIFIER "x is past the end of the data",
+            offset
+        );
+        return;
+    }
+    self->offset = offset;
+}
+
+void wad_byte_reader_read(
+    WadByteReader *restrict self,
+    void *restrict dest,
+    gsize n,
+    GError **error
+)
+{
+    if (!check_remaining(self, n, error)) {
+        return;
+    }
+    memcpy(dest, self->data + self->offset, n);
+    self->offset += n;
+}
+
+guchar wad_byte_reader_read_byte(WadByteReader *self, GError **error)
+{
+    guchar value = 0;
+    wad_byte_reader_read(self, &value, sizeof(value), error);
+    return value;
+}
+
+guint16 wad_byte_reader_read_uint16(WadByteReader *self, GError **error)
+{
+    guint16 value = 0;
+    wad_byte_reader_read(self, &value, sizeof(value), error);
+    return GUINT16_FROM_LE(value);
+}
+
+guint32 wad_byte_reader_read_uint32(WadByteReader *self, GError **error)
+{
+    guint32 value = 0;
+    wad_byte_reader_read(self, &value, sizeof(value), error);
+    return GUINT32_FROM_LE(value);
+}
+
+GBytes *wad_byte_reader_read_bytes(WadByteReader *self, gsize n, GError **error)
+{
+    if (!check_remaining(self, n, error)) {
+        return nullptr;
+    }
+    GBytes *slice = g_bytes_new_from_bytes(self->bytes, self->offset, n);
+    self->offset += n;
+    return slice;
+}
+
+void wad_byte_reader_read_directory(
+    WadByteReader *restrict self,
+    guint32 n_entries,
+    WadDirectoryEntry *restrict entries,
+    GError **error
+)
+{
+    gsize size = (gsize)n_entries * WAD_DIRECTORY_ENTRY_SIZE;
+    if (!check_remaining(self, size, error)) {
+        return;
+    }
+    wad_directory_entry_decode(self->data + self->offset, n_entries, entries);
+    self->offset += size;
+}
+
+WadQpicFile *wad_byte_reader_read_qpic_file(WadByteReader *self, GError **error)
+{
+    GError *e = nullptr;
+    g_autoptr(WadQpicFile) qpic = g_new0(WadQpicFile, 1);
+
+    qpic->width = wad_byte_reader_read_uint32(self, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    qpic->height = wad_byte_reader_read_uint32(self, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    qpic->data_bytes = wad_byte_reader_read_bytes(
+        self,
+        (gsize)qpic->width * qpic->height,
+        &e
+    );
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    guint16 colors_used = wad_byte_reader_read_uint16(self, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    qpic->palette_bytes
+        = wad_byte_reader_read_bytes(self, sizeof(WadRgb) * colors_used, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    return g_steal_pointer(&qpic);
+}
+
+WadMiptexFile *
+wad_byte_reader_read_miptex_file(WadByteReader *self, GError **error)
+{
+    GError *e = nullptr;
+    g_autoptr(WadMiptexFile) miptex = g_new0(WadMiptexFile, 1);
+
+    wad_byte_reader_read(self, miptex->texture_name, 16, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    miptex->width = wad_byte_reader_read_uint32(self, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    miptex->height = wad_byte_reader_read_uint32(self, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    // Mip offsets; the images are stored back-to-back after them.
+    wad_byte_reader_seek(self, self->offset + 4 * sizeof(guint32), &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    constexpr guint32 divisor[4] = {1, 2, 4, 8};
+    for (size_t i = 0; i < 4; ++i) {
+        gsize bufsize
+            = (miptex->width / divisor[i]) * (miptex->height / divisor[i]);
+        miptex->mip_bytes[i] = wad_byte_reader_read_bytes(self, bufsize, &e);
+        if (e) {
+            g_propagate_error(error, e);
+            return nullptr;
+        }
+    }
+    guint16 colors_used = wad_byte_reader_read_uint16(self, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    miptex->palette_bytes
+        = wad_byte_reader_read_bytes(self, sizeof(WadRgb) * colors_used, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    wad_miptex_file_update_alpha(miptex);
+    return g_steal_pointer(&miptex);
+}
+
+WadFontFile *wad_byte_reader_read_font_file(WadByteReader *self, GError **error)
+{
+    GError *e = nullptr;
+    g_autoptr(WadFontFile) font = g_new0(WadFontFile, 1);
+
+    wad_byte_reader_read_uint32(self, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    font->height = wad_byte_reader_read_uint32(self, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    font->row_count = wad_byte_reader_read_uint32(self, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    font->row_height = wad_byte_reader_read_uint32(self, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    // The glyph table is small enough that copying it out is not worth
+    // special-casing.
+    font->font_info = g_array_sized_new(FALSE, FALSE, sizeof(WadCharInfo), 256);
+    font->font_info->len = 256;
+    wad_byte_reader_read(
+        self,
+        font->font_info->data,
+        sizeof(WadCharInfo) * font->font_info->len,
+        &e
+    );
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    font->data_bytes
+        = wad_byte_reader_read_bytes(self, (gsize)font->height * 256, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    guint16 colors_used = wad_byte_reader_read_uint16(self, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    font->palette_bytes
+        = wad_byte_reader_read_bytes(self, sizeof(WadRgb) * colors_used, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    return g_steal_pointer(&font);
+}
+
+/*
+ * Seeks to `entry` and decodes it. The returned texture is empty if an error
+ * occurred.
+ */
+WadTexture wad_byte_reader_read_entry(
+    WadByteReader *self,
+    WadDirectoryEntry const *entry,
+    GError **error
+)
+{
+    GError *e = nullptr;
+
+    wad_byte_reader_seek(self, entry->entry_offset, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return (WadTexture){};
+    }
+    switch (entry->file_type) {
+    case WAD_FILE_TYPE_QPIC: {
+        WadQpicFile *qpic = wad_byte_reader_read_qpic_file(self, &e);
+        if (e) {
+            g_propagate_error(error, e);
+            return (WadTexture){};
+        }
+        return (WadTexture){WAD_TYPE_QPIC_FILE, qpic};
+    }
+    case WAD_FILE_TYPE_SPRAYDECAL:
+    case WAD_FILE_TYPE_MIPTEX: {
+        WadMiptexFile *miptex = wad_byte_reader_read_miptex_file(self, &e);
+        if (e) {
+            g_propagate_error(error, e);
+            return (WadTexture){};
+        }
+        return (WadTexture){WAD_TYPE_MIPTEX_FILE, miptex};
+    }
+    case WAD_FILE_TYPE_FONT: {
+        WadFontFile *font = wad_byte_reader_read_font_file(self, &e);
+        if (e) {
+            g_propagate_error(error, e);
+            return (WadTexture){};
+        }
+        return (WadTexture){WAD_TYPE_FONT_FILE, font};
+    }
+    default:
+        wad_set_file_type_error(error, entry->file_type);
+        return (WadTexture){};
+    }
+}
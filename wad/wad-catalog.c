@@ -0,0 +1,195 @@
+#include "wad-catalog.h"
+
+#include "wad-private.h"
+
+#include <stdlib.h>
+
+G_DEFINE_BOXED_TYPE(
+    WadCatalogEntry,
+    wad_catalog_entry,
+    wad_catalog_entry_copy,
+    wad_catalog_entry_free
+)
+
+// Private /////////////////////////////////////////////////////////////////////
+
+static gint compare_offset(gconstpointer a, gconstpointer b)
+{
+    WadCatalogEntry const *const *x = a;
+    WadCatalogEntry const *const *y = b;
+    guint32 xo = (*x)->directory_entry.entry_offset;
+    guint32 yo = (*y)->directory_entry.entry_offset;
+    return (xo > yo) - (xo < yo);
+}
+
+// Reads the dimensions from the start of an entry, leaving other fields alone.
+static void read_dimensions(
+    WadInputStream *stream,
+    WadCatalogEntry *entry,
+    GCancellable *cancellable,
+    GError **error
+)
+{
+    GDataInputStream *dstream = G_DATA_INPUT_STREAM(stream);
+    GError *e = nullptr;
+    goffset offset = entry->directory_entry.entry_offset;
+
+    switch (entry->directory_entry.file_type) {
+    case WAD_FILE_TYPE_QPIC:
+        break;
+    case WAD_FILE_TYPE_SPRAYDECAL:
+    case WAD_FILE_TYPE_MIPTEX:
+        // Skip texture_name
+        offset += 16;
+        break;
+    case WAD_FILE_TYPE_FONT:
+        return;
+    default:
+        wad_set_file_type_error(error, entry->directory_entry.file_type);
+        return;
+    }
+    g_seekable_seek(G_SEEKABLE(stream), offset, G_SEEK_SET, cancellable, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return;
+    }
+    entry->width = g_data_input_stream_read_uint32(dstream, cancellable, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return;
+    }
+    entry->height = g_data_input_stream_read_uint32(dstream, cancellable, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return;
+    }
+}
+
+// Public //////////////////////////////////////////////////////////////////////
+
+WadCatalogEntry *wad_catalog_entry_copy(WadCatalogEntry const *entry)
+{
+    WadCatalogEntry *copy = g_new(WadCatalogEntry, 1);
+    memcpy(copy, entry, sizeof(WadCatalogEntry));
+    return copy;
+}
+
+void wad_catalog_entry_free(WadCatalogEntry *entry)
+{
+    g_free(entry);
+}
+
+/**
+ * wad_catalog_scan_stream:
+ * @stream: A seekable stream containing WAD data.
+ * @cancellable: (nullable): A [class@Gio.Cancellable].
+ * @error: The return location for [struct@GError].
+ *
+ * Lists the entries of a WAD without decoding them.
+ *
+ * Only the directory and the few header bytes holding each image's dimensions
+ * are read; pixel and palette data are skipped. Entries are visited in file
+ * order so reads only move forward.
+ *
+ * Returns: (transfer full) (element-type WadCatalogEntry): The entries in
+ * directory order, or `NULL` if an error occurred.
+ */
+GArray *wad_catalog_scan_stream(
+    GInputStream *base_stream,
+    GCancellable *cancellable,
+    GError **error
+)
+{
+    g_return_val_if_fail(G_IS_INPUT_STREAM(base_stream), nullptr);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, nullptr);
+
+    g_autoptr(WadInputStream) stream = wad_input_stream_new(base_stream);
+    GError *e = nullptr;
+
+    guint32 num_dirs = 0;
+    guint32 dir_offset = 0;
+    wad_input_stream_read_header(
+        stream,
+        &num_dirs,
+        &dir_offset,
+        cancellable,
+        &e
+    );
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    g_seekable_seek(
+        G_SEEKABLE(stream),
+        dir_offset,
+        G_SEEK_SET,
+        cancellable,
+        &e
+    );
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    g_autoptr(GArray) directory = wad_input_stream_read_directory(
+        stream,
+        num_dirs,
+        cancellable,
+        &e
+    );
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+
+    g_autoptr(GArray) catalog = g_array_sized_new(
+        FALSE,
+        TRUE,
+        sizeof(WadCatalogEntry),
+        directory->len
+    );
+    g_array_set_size(catalog, directory->len);
+    g_autofree WadCatalogEntry **by_offset
+        = g_new(WadCatalogEntry *, directory->len);
+    for (guint i = 0; i < directory->len; ++i) {
+        WadCatalogEntry *entry = &g_array_index(catalog, WadCatalogEntry, i);
+        entry->directory_entry
+            = g_array_index(directory, WadDirectoryEntry, i);
+        by_offset[i] = entry;
+    }
+    qsort(by_offset, directory->len, sizeof(*by_offset), compare_offset);
+    for (guint i = 0; i < directory->len; ++i) {
+        read_dimensions(stream, by_offset[i], cancellable, &e);
+        if (e) {
+            g_propagate_error(error, e);
+            return nullptr;
+        }
+    }
+    return g_steal_pointer(&catalog);
+}
+
+/**
+ * wad_catalog_scan_file:
+ * @file: The file to scan.
+ * @cancellable: (nullable): A [class@Gio.Cancellable].
+ * @error: The return location for [struct@GError].
+ *
+ * Lists the entries of a WAD file without decoding them. See
+ * wad_catalog_scan_stream().
+ *
+ * Returns: (transfer full) (element-type WadCatalogEntry): The entries in
+ * directory order, or `NULL` if an error occurred.
+ */
+GArray *
+wad_catalog_scan_file(GFile *file, GCancellable *cancellable, GError **error)
+{
+    g_return_val_if_fail(G_IS_FILE(file), nullptr);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, nullptr);
+
+    GError *e = nullptr;
+    g_autoptr(GFileInputStream) stream = g_file_read(file, cancellable, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    return wad_catalog_scan_stream(G_INPUT_STREAM(stream), cancellable, error);
+}
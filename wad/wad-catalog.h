@@ -0,0 +1,40 @@
+#pragma once
+
+#include "wad/wad-directoryentry.h"
+
+#include <gio/gio.h>
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define WAD_TYPE_CATALOG_ENTRY wad_catalog_entry_get_type()
+
+/**
+ * WadCatalogEntry:
+ * @directory_entry: The entry's directory record.
+ * @width: Width of the image in pixels, or 0 if it is not a miptex or qpic.
+ * @height: Height of the image in pixels, or 0 if it is not a miptex or qpic.
+ *
+ * Summary of one WAD entry, as returned by wad_catalog_scan_stream().
+ */
+typedef struct {
+    WadDirectoryEntry directory_entry;
+    guint32 width, height;
+} WadCatalogEntry;
+
+GType wad_catalog_entry_get_type(void);
+WadCatalogEntry *wad_catalog_entry_copy(WadCatalogEntry const *entry);
+void wad_catalog_entry_free(WadCatalogEntry *entry);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(WadCatalogEntry, wad_catalog_entry_free)
+
+GArray *wad_catalog_scan_stream(
+    GInputStream *stream,
+    GCancellable *cancellable,
+    GError **error
+);
+
+GArray *
+wad_catalog_scan_file(GFile *file, GCancellable *cancellable, GError **error);
+
+G_END_DECLS
@@ -0,0 +1,122 @@
+/*
+ * Color space conversion and nearest-palette-color search, shared by the
+ * tools that turn RGB back into indexed images.
+ */
+#include "wad-private.h"
+
+#include <math.h>
+
+// Private /////////////////////////////////////////////////////////////////////
+
+// Palette entries past the end of the palette are given this value for each
+// channel, which is further from any 8-bit color than any real entry.
+#define UNUSED_CHANNEL 1024
+
+#define CACHE_EMPTY 0xffff
+
+// Resolution of the linear-to-sRGB table.
+#define LINEAR_STEPS 4096
+
+static float srgb_to_linear[256];
+static guchar linear_to_srgb[LINEAR_STEPS + 1];
+
+static void init_tables(void)
+{
+    static gsize initialized = 0;
+    if (!g_once_init_enter(&initialized)) {
+        return;
+    }
+    for (size_t i = 0; i < 256; ++i) {
+        float c = i / 255.0f;
+        srgb_to_linear[i] = c <= 0.04045f ? c / 12.92f
+                                          : powf((c + 0.055f) / 1.055f, 2.4f);
+    }
+    for (size_t i = 0; i <= LINEAR_STEPS; ++i) {
+        float c = (float)i / LINEAR_STEPS;
+        float s = c <= 0.0031308f ? c * 12.92f
+                                  : 1.055f * powf(c, 1.0f / 2.4f) - 0.055f;
+        linear_to_srgb[i] = (guchar)CLAMP(s * 255.0f + 0.5f, 0.0f, 255.0f);
+    }
+    g_once_init_leave(&initialized, 1);
+}
+
+static guchar search(WadNearestColor const *self, gint r, gint g, gint b)
+{
+    // Fixed trip count over a structure-of-arrays palette, so the compiler
+    // can vectorize the distance computation.
+    gint32 distance[256];
+    for (size_t i = 0; i < 256; ++i) {
+        gint32 dr = self->r[i] - r;
+        gint32 dg = self->g[i] - g;
+        gint32 db = self->b[i] - b;
+        distance[i] = dr * dr + dg * dg + db * db;
+    }
+    guint best = 0;
+    for (size_t i = 1; i < 256; ++i) {
+        if (distance[i] < distance[best]) {
+            best = i;
+        }
+    }
+    return best;
+}
+
+// Internal ////////////////////////////////////////////////////////////////////
+
+float wad_srgb_to_linear(guchar value)
+{
+    init_tables();
+    return srgb_to_linear[value];
+}
+
+guchar wad_linear_to_srgb(float value)
+{
+    init_tables();
+    value = CLAMP(value, 0.0f, 1.0f);
+    return linear_to_srgb[(gsize)(value * LINEAR_STEPS + 0.5f)];
+}
+
+void wad_nearest_color_init(
+    WadNearestColor *self,
+    WadRgb const *palette,
+    gsize n_colors
+)
+{
+    n_colors = MIN(n_colors, 256);
+    for (gsize i = 0; i < 256; ++i) {
+        if (i < n_colors) {
+            self->r[i] = palette[i].rgb[0];
+            self->g[i] = palette[i].rgb[1];
+            self->b[i] = palette[i].rgb[2];
+        } else {
+            self->r[i] = self->g[i] = self->b[i] = UNUSED_CHANNEL;
+        }
+    }
+    self->cache = g_new(guint16, 32 * 32 * 32);
+    memset(self->cache, 0xff, sizeof(guint16) * 32 * 32 * 32);
+}
+
+void wad_nearest_color_clear(WadNearestColor *self)
+{
+    g_clear_pointer(&self->cache, g_free);
+}
+
+/*
+ * Finds the palette index closest to the given color.
+ *
+ * Results are cached per cell of a 32x32x32 grid over RGB space. The first
+ * color to land in a cell decides its entry, so later colors in the same cell
+ * may get a color that is close, but not the closest.
+ */
+guchar wad_nearest_color_lookup(
+    WadNearestColor *self,
+    guchar r,
+    guchar g,
+    guchar b
+)
+{
+    gsize key = ((gsize)(r >> 3) << 10) | ((gsize)(g >> 3) << 5) | (b >> 3);
+    if (self->cache[key] == CACHE_EMPTY) {
+        self->cache[key] = search(self, r, g, b);
+    }
+    return self->cache[key];
+}
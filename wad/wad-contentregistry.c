@@ -0,0 +1,691 @@
+#include "wad-contentregistry.h"
+
+#include "wad-private.h"
+
+// WadDuplicateGroup
+
+G_DEFINE_BOXED_TYPE(
+    WadDuplicateGroup,
+    wad_duplicate_group,
+    wad_duplicate_group_copy,
+    wad_duplicate_group_free
+)
+
+WadDuplicateGroup *wad_duplicate_group_copy(WadDuplicateGroup const *group)
+{
+    WadDuplicateGroup *copy = g_new(WadDuplicateGroup, 1);
+    copy->hash = group->hash;
+    copy->size = group->size;
+    copy->archives = g_ptr_array_ref(group->archives);
+    copy->names = g_ptr_array_ref(group->names);
+    return copy;
+}
+
+void wad_duplicate_group_free(WadDuplicateGroup *group)
+{
+    g_ptr_array_unref(group->archives);
+    g_ptr_array_unref(group->names);
+    g_free(group);
+}
+
+// WadContentRegistry
+
+/**
+ * WadContentRegistry:
+ *
+ * An index of textures by their content, across any number of
+ * [class@WadTextureArchive]s.
+ *
+ * Texture libraries often hold the same image under several names, or in
+ * several WADs. Each texture added to the registry is given a 64-bit hash of
+ * its pixels, palette and dimensions; textures which turn out to be
+ * byte-identical form a group. Use wad_content_registry_lookup_rgba() to
+ * expand a texture once for its whole group, and
+ * wad_content_registry_get_duplicates() to list the groups.
+ *
+ * Textures are hashed as they are added. A texture replaced in or removed
+ * from its archive leaves the registry; add the archive again to hash the new
+ * textures. The registry does not keep its archives alive: an archive's
+ * textures leave the registry when the archive is finalized.
+ */
+struct _WadContentRegistry {
+    GObject parent_instance;
+    GMutex lock;
+    GHashTable *groups;   // guint64 hash -> ContentGroup, chained on collision
+    GHashTable *members;  // Member -> Member
+    GHashTable *archives; // Weakly referenced WadTextureArchive set
+};
+
+G_DEFINE_FINAL_TYPE(WadContentRegistry, wad_content_registry, G_TYPE_OBJECT)
+
+// Private /////////////////////////////////////////////////////////////////////
+
+/*
+ * The parts of a texture which decide how it looks, in a fixed order. Two
+ * textures are duplicates if all of their parts are byte-identical.
+ */
+typedef struct {
+    guint32 header[4]; // Type, dimensions and flags
+    struct {
+        gconstpointer data;
+        gsize size;
+    } parts[6];
+    guint n_parts;
+} Content;
+
+static void content_add(Content *content, gconstpointer data, gsize size)
+{
+    content->parts[content->n_parts].data = data;
+    content->parts[content->n_parts].size = size;
+    content->n_parts += 1;
+}
+
+// Returns false for a texture of unknown type.
+static bool content_init(Content *content, WadTexture const *texture)
+{
+    *content = (Content){};
+    gsize size = 0;
+    gsize n_colors = 0;
+    gconstpointer data;
+
+    if (texture->type == WAD_TYPE_MIPTEX_FILE) {
+        WadMiptexFile const *miptex = texture->boxed;
+        content->header[0] = WAD_FILE_TYPE_MIPTEX;
+        content->header[1] = miptex->width;
+        content->header[2] = miptex->height;
+        // Decides whether the last palette entry is transparent.
+        content->header[3] = miptex->texture_name[0] == '{';
+        for (guint level = 0; level < 4; ++level) {
+            data = wad_miptex_file_get_mip_data(miptex, level, &size);
+            content_add(content, data, size);
+        }
+        data = wad_miptex_file_get_palette_data(miptex, &n_colors);
+    } else if (texture->type == WAD_TYPE_QPIC_FILE) {
+        WadQpicFile const *qpic = texture->boxed;
+        content->header[0] = WAD_FILE_TYPE_QPIC;
+        content->header[1] = qpic->width;
+        content->header[2] = qpic->height;
+        data = wad_qpic_file_get_data(qpic, &size);
+        content_add(content, data, size);
+        data = wad_qpic_file_get_palette_data(qpic, &n_colors);
+    } else if (texture->type == WAD_TYPE_FONT_FILE) {
+        WadFontFile const *font = texture->boxed;
+        content->header[0] = WAD_FILE_TYPE_FONT;
+        content->header[1] = font->height;
+        content->header[2] = font->row_count;
+        content->header[3] = font->row_height;
+        if (font->font_info) {
+            content_add(
+                content,
+                font->font_info->data,
+                (gsize)font->font_info->len * sizeof(WadCharInfo)
+            );
+        }
+        data = wad_font_file_get_data(font, &size);
+        content_add(content, data, size);
+        data = wad_font_file_get_palette_data(font, &n_colors);
+    } else {
+        return false;
+    }
+    content_add(content, data, n_colors * sizeof(WadRgb));
+    return true;
+}
+
+static guint64 content_hash(Content const *content)
+{
+    guint64 h = wad_hash_bytes(0, content->header, sizeof(content->header));
+    for (guint i = 0; i < content->n_parts; ++i) {
+        h = wad_hash_bytes(h, content->parts[i].data, content->parts[i].size);
+    }
+    return h;
+}
+
+static gsize content_size(Content const *content)
+{
+    gsize size = 0;
+    for (guint i = 0; i < content->n_parts; ++i) {
+        size += content->parts[i].size;
+    }
+    return size;
+}
+
+static bool content_equal(Content const *a, Content const *b)
+{
+    if (memcmp(a->header, b->header, sizeof(a->header)) != 0
+        || a->n_parts != b->n_parts) {
+        return false;
+    }
+    for (guint i = 0; i < a->n_parts; ++i) {
+        if (a->parts[i].size != b->parts[i].size
+            || (a->parts[i].size > 0
+                && memcmp(a->parts[i].data, b->parts[i].data, a->parts[i].size)
+                       != 0)) {
+            return false;
+        }
+    }
+    return true;
+}
+
+typedef struct ContentGroup ContentGroup;
+
+/*
+ * Textures with identical content. The first member's texture stands in for
+ * the whole group.
+ */
+struct ContentGroup {
+    guint64 hash;
+    ContentGroup *next; // Next group with the same hash
+    WadTexture texture; // A copy of the first member's texture
+    Content content;    // Parts of `texture`
+    GPtrArray *members; // PtrArray<Member>, not owned
+    GBytes *rgba;       // Expanded on first lookup
+    guint width, height;
+};
+
+typedef struct {
+    WadTextureArchive *archive; // Not owned, see `archives`
+    WadName key;
+    char *name;
+    ContentGroup *group;
+} Member;
+
+static guint member_hash(gconstpointer data)
+{
+    Member const *member = data;
+    return wad_name_hash(&member->key) ^ g_direct_hash(member->archive);
+}
+
+static gboolean member_equal(gconstpointer a, gconstpointer b)
+{
+    Member const *x = a;
+    Member const *y = b;
+    return x->archive == y->archive && wad_name_equal(&x->key, &y->key);
+}
+
+static void member_free(Member *member)
+{
+    g_free(member->name);
+    g_free(member);
+}
+
+static void content_group_free(ContentGroup *group)
+{
+    while (group) {
+        ContentGroup *next = group->next;
+        wad_texture_clear(&group->texture);
+        g_ptr_array_unref(group->members);
+        g_clear_pointer(&group->rgba, g_bytes_unref);
+        g_free(group);
+        group = next;
+    }
+}
+
+// Must hold lock.
+static void detach_member(WadContentRegistry *self, Member *member)
+{
+    ContentGroup *group = member->group;
+    g_ptr_array_remove_fast(group->members, member);
+    if (group->members->len > 0) {
+        return;
+    }
+
+    ContentGroup *head = g_hash_table_lookup(self->groups, &group->hash);
+    if (head == group) {
+        if (group->next) {
+            g_hash_table_steal(self->groups, &group->hash);
+            g_hash_table_insert(self->groups, &group->next->hash, group->next);
+        } else {
+            g_hash_table_steal(self->groups, &group->hash);
+        }
+    } else {
+        while (head->next != group) {
+            head = head->next;
+        }
+        head->next = group->next;
+    }
+    group->next = nullptr;
+    content_group_free(group);
+}
+
+/*
+ * Adds a hashed texture to the group of identical textures, creating the group
+ * if there is none yet. Takes ownership of `texture`. Returns whether the
+ * group already existed. Must hold lock.
+ */
+static bool attach_member(
+    WadContentRegistry *self,
+    Member *member,
+    WadTexture *texture,
+    Content const *content,
+    guint64 hash
+)
+{
+    ContentGroup *head = g_hash_table_lookup(self->groups, &hash);
+    for (ContentGroup *group = head; group; group = group->next) {
+        if (content_equal(&group->content, content)) {
+            member->group = group;
+            g_ptr_array_add(group->members, member);
+            wad_texture_clear(texture);
+            return true;
+        }
+    }
+
+    ContentGroup *group = g_new0(ContentGroup, 1);
+    group->hash = hash;
+    group->texture = *texture;
+    *texture = (WadTexture){};
+    content_init(&group->content, &group->texture);
+    group->members = g_ptr_array_new();
+    g_ptr_array_add(group->members, member);
+    member->group = group;
+    if (head) {
+        group->next = head->next;
+        head->next = group;
+    } else {
+        g_hash_table_insert(self->groups, &group->hash, group);
+    }
+    return false;
+}
+
+// Must hold lock.
+static void remove_archive(WadContentRegistry *self, WadTextureArchive *archive)
+{
+    GHashTableIter iter;
+    Member *member;
+    g_hash_table_iter_init(&iter, self->members);
+    while (g_hash_table_iter_next(&iter, (gpointer *)&member, nullptr)) {
+        if (member->archive == archive) {
+            detach_member(self, member);
+            g_hash_table_iter_remove(&iter);
+        }
+    }
+}
+
+static void on_archive_finalized(gpointer data, GObject *archive)
+{
+    WadContentRegistry *self = data;
+    g_mutex_lock(&self->lock);
+    remove_archive(self, (WadTextureArchive *)archive);
+    g_hash_table_remove(self->archives, archive);
+    g_mutex_unlock(&self->lock);
+}
+
+static void on_texture_invalidated(
+    WadTextureArchive *archive,
+    char const *texture_name,
+    gpointer user_data
+)
+{
+    WadContentRegistry *self = user_data;
+    Member probe = {.archive = archive};
+    wad_name_init(&probe.key, texture_name);
+    g_mutex_lock(&self->lock);
+    Member *member = g_hash_table_lookup(self->members, &probe);
+    if (member) {
+        detach_member(self, member);
+        g_hash_table_remove(self->members, member);
+    }
+    g_mutex_unlock(&self->lock);
+}
+
+// Must hold lock.
+static void watch_archive(WadContentRegistry *self, WadTextureArchive *archive)
+{
+    if (g_hash_table_add(self->archives, archive)) {
+        g_object_weak_ref(G_OBJECT(archive), on_archive_finalized, self);
+        g_signal_connect(
+            archive,
+            "texture-invalidated",
+            G_CALLBACK(on_texture_invalidated),
+            self
+        );
+    }
+}
+
+static void
+unwatch_archive(WadContentRegistry *self, WadTextureArchive *archive)
+{
+    g_signal_handlers_disconnect_by_data(archive, self);
+    g_object_weak_unref(G_OBJECT(archive), on_archive_finalized, self);
+}
+
+// Must hold lock.
+static ContentGroup *find_group(
+    WadContentRegistry *self,
+    WadTextureArchive *archive,
+    char const *texture_name
+)
+{
+    Member probe = {.archive = archive};
+    wad_name_init(&probe.key, texture_name);
+    Member *member = g_hash_table_lookup(self->members, &probe);
+    return member ? member->group : nullptr;
+}
+
+typedef struct {
+    char const *name;
+    WadTexture texture;
+    Content content;
+    guint64 hash;
+} HashJob;
+
+static void hash_texture(guint index, gpointer user_data)
+{
+    HashJob *job = &((HashJob *)user_data)[index];
+    if (job->texture.boxed && content_init(&job->content, &job->texture)) {
+        job->hash = content_hash(&job->content);
+    } else {
+        wad_texture_clear(&job->texture);
+    }
+}
+
+static gint compare_duplicates(gconstpointer a, gconstpointer b)
+{
+    WadDuplicateGroup const *x = *(WadDuplicateGroup *const *)a;
+    WadDuplicateGroup const *y = *(WadDuplicateGroup *const *)b;
+    guint64 wasted_x = (guint64)x->size * (x->names->len - 1);
+    guint64 wasted_y = (guint64)y->size * (y->names->len - 1);
+    return wasted_x < wasted_y ? 1 : wasted_x > wasted_y ? -1 : 0;
+}
+
+// GObject /////////////////////////////////////////////////////////////////////
+
+static void wad_content_registry_finalize(GObject *object)
+{
+    WadContentRegistry *self = WAD_CONTENT_REGISTRY(object);
+    GHashTableIter iter;
+    gpointer archive;
+    g_hash_table_iter_init(&iter, self->archives);
+    while (g_hash_table_iter_next(&iter, &archive, nullptr)) {
+        unwatch_archive(self, archive);
+    }
+    g_clear_pointer(&self->archives, g_hash_table_unref);
+    g_clear_pointer(&self->members, g_hash_table_unref);
+    g_clear_pointer(&self->groups, g_hash_table_unref);
+    g_mutex_clear(&self->lock);
+    G_OBJECT_CLASS(wad_content_registry_parent_class)->finalize(object);
+}
+
+// WadContentRegistry //////////////////////////////////////////////////////////
+
+static void wad_content_registry_class_init(WadContentRegistryClass *klass)
+{
+    GObjectClass *oclass = G_OBJECT_CLASS(klass);
+    oclass->finalize = wad_content_registry_finalize;
+}
+
+static void wad_content_registry_init(WadContentRegistry *self)
+{
+    g_mutex_init(&self->lock);
+    self->groups = g_hash_table_new_full(
+        g_int64_hash,
+        g_int64_equal,
+        nullptr,
+        (GDestroyNotify)content_group_free
+    );
+    self->members = g_hash_table_new_full(
+        member_hash,
+        member_equal,
+        (GDestroyNotify)member_free,
+        nullptr
+    );
+    self->archives = g_hash_table_new(g_direct_hash, g_direct_equal);
+}
+
+// Public //////////////////////////////////////////////////////////////////////
+
+/**
+ * wad_content_registry_new:
+ *
+ * Creates an empty registry.
+ *
+ * Returns: A new [class@WadContentRegistry].
+ */
+WadContentRegistry *wad_content_registry_new(void)
+{
+    return g_object_new(WAD_TYPE_CONTENT_REGISTRY, nullptr);
+}
+
+/**
+ * wad_content_registry_add_archive:
+ * @registry: A [class@WadContentRegistry].
+ * @archive: The archive to add.
+ * @n_threads: Number of threads to hash on, or 0 for one per processor.
+ *
+ * Hashes every texture in @archive and adds it to the registry. Textures of
+ * @archive which were added before are hashed again, so this also picks up
+ * changes to the archive. Textures of a lazily-loaded archive are decoded
+ * first.
+ *
+ * The registry does not take a reference to @archive. Its textures are
+ * removed when it is finalized, or by wad_content_registry_remove_archive().
+ * Textures replaced in or removed from @archive leave the registry until it
+ * is added again.
+ *
+ * Returns: The number of textures whose content was already in the registry.
+ */
+guint wad_content_registry_add_archive(
+    WadContentRegistry *self,
+    WadTextureArchive *archive,
+    guint n_threads
+)
+{
+    g_return_val_if_fail(WAD_IS_CONTENT_REGISTRY(self), 0);
+    g_return_val_if_fail(WAD_IS_TEXTURE_ARCHIVE(archive), 0);
+
+    g_autofree char const **names = wad_texture_archive_get_names(archive);
+    guint n_textures = g_strv_length((char **)names);
+    g_autofree HashJob *jobs = g_new0(HashJob, n_textures);
+    for (guint i = 0; i < n_textures; ++i) {
+        jobs[i].name = names[i];
+        // A copy, which stays alive even if it is replaced in the archive.
+        wad_texture_archive_dup_texture(
+            archive,
+            names[i],
+            &jobs[i].texture,
+            nullptr
+        );
+    }
+    wad_parallel_for(n_textures, n_threads, hash_texture, jobs);
+
+    guint n_duplicates = 0;
+    g_mutex_lock(&self->lock);
+    remove_archive(self, archive);
+    watch_archive(self, archive);
+    for (guint i = 0; i < n_textures; ++i) {
+        HashJob *job = &jobs[i];
+        if (!job->texture.boxed) {
+            continue;
+        }
+        Member *member = g_new0(Member, 1);
+        member->archive = archive;
+        wad_name_init(&member->key, job->name);
+        member->name = g_strdup(job->name);
+        if (attach_member(
+                self,
+                member,
+                &job->texture,
+                &job->content,
+                job->hash
+            )) {
+            n_duplicates += 1;
+        }
+        g_hash_table_add(self->members, member);
+    }
+    g_mutex_unlock(&self->lock);
+    return n_duplicates;
+}
+
+/**
+ * wad_content_registry_remove_archive:
+ * @registry: A [class@WadContentRegistry].
+ * @archive: The archive to remove.
+ *
+ * Removes every texture of @archive from the registry.
+ */
+void wad_content_registry_remove_archive(
+    WadContentRegistry *self,
+    WadTextureArchive *archive
+)
+{
+    g_return_if_fail(WAD_IS_CONTENT_REGISTRY(self));
+    g_return_if_fail(WAD_IS_TEXTURE_ARCHIVE(archive));
+    g_mutex_lock(&self->lock);
+    remove_archive(self, archive);
+    bool watched = g_hash_table_remove(self->archives, archive);
+    g_mutex_unlock(&self->lock);
+    if (watched) {
+        unwatch_archive(self, archive);
+    }
+}
+
+/**
+ * wad_content_registry_get_hash:
+ * @registry: A [class@WadContentRegistry].
+ * @archive: The archive holding the texture.
+ * @texture_name: Name of the texture.
+ * @hash: (out) (optional): Return location for the content hash.
+ *
+ * Gets the content hash of a texture. Textures with equal content have equal
+ * hashes; the reverse is very likely, but not certain.
+ *
+ * Returns: Whether the texture is in the registry.
+ */
+gboolean wad_content_registry_get_hash(
+    WadContentRegistry *self,
+    WadTextureArchive *archive,
+    char const *texture_name,
+    guint64 *hash
+)
+{
+    g_return_val_if_fail(WAD_IS_CONTENT_REGISTRY(self), FALSE);
+    g_return_val_if_fail(texture_name != nullptr, FALSE);
+
+    g_mutex_lock(&self->lock);
+    ContentGroup *group = find_group(self, archive, texture_name);
+    if (group && hash) {
+        *hash = group->hash;
+    }
+    g_mutex_unlock(&self->lock);
+    return group != nullptr;
+}
+
+/**
+ * wad_content_registry_lookup_rgba:
+ * @registry: A [class@WadContentRegistry].
+ * @archive: The archive holding the texture.
+ * @texture_name: Name of the texture.
+ * @width: (out) (optional): Return location for the width of the image.
+ * @height: (out) (optional): Return location for the height of the image.
+ *
+ * Gets a texture as tightly-packed 8-bit RGBA rows, as
+ * wad_rgba_cache_lookup() does. The pixels are expanded once per group of
+ * identical textures and shared by all of them, until the group is emptied.
+ *
+ * Returns: (transfer full) (nullable): The pixels, or `NULL` if the texture is
+ * not in the registry.
+ */
+GBytes *wad_content_registry_lookup_rgba(
+    WadContentRegistry *self,
+    WadTextureArchive *archive,
+    char const *texture_name,
+    guint *width,
+    guint *height
+)
+{
+    g_return_val_if_fail(WAD_IS_CONTENT_REGISTRY(self), nullptr);
+    g_return_val_if_fail(texture_name != nullptr, nullptr);
+
+    GBytes *pixels = nullptr;
+    WadTexture texture = {};
+    guint w = 0;
+    guint h = 0;
+
+    g_mutex_lock(&self->lock);
+    ContentGroup *group = find_group(self, archive, texture_name);
+    if (group && group->rgba) {
+        pixels = g_bytes_ref(group->rgba);
+        w = group->width;
+        h = group->height;
+    } else if (group) {
+        texture.type = group->texture.type;
+        texture.boxed = g_boxed_copy(texture.type, group->texture.boxed);
+    }
+    g_mutex_unlock(&self->lock);
+
+    if (texture.boxed) {
+        // Expanded outside the lock, as in WadRgbaCache.
+        pixels = wad_texture_expand_rgba(&texture, &w, &h);
+        wad_texture_clear(&texture);
+        if (!pixels) {
+            return nullptr;
+        }
+        g_mutex_lock(&self->lock);
+        // The group may have gone, or been expanded by another thread.
+        group = find_group(self, archive, texture_name);
+        if (group && !group->rgba) {
+            group->rgba = g_bytes_ref(pixels);
+            group->width = w;
+            group->height = h;
+        }
+        g_mutex_unlock(&self->lock);
+    }
+    if (!pixels) {
+        return nullptr;
+    }
+    if (width) {
+        *width = w;
+    }
+    if (height) {
+        *height = h;
+    }
+    return pixels;
+}
+
+/**
+ * wad_content_registry_get_duplicates:
+ * @registry: A [class@WadContentRegistry].
+ *
+ * Lists every group of two or more identical textures, with the groups that
+ * waste the most memory first.
+ *
+ * Returns: (transfer full) (element-type WadDuplicateGroup): The groups.
+ */
+GPtrArray *wad_content_registry_get_duplicates(WadContentRegistry *self)
+{
+    g_return_val_if_fail(WAD_IS_CONTENT_REGISTRY(self), nullptr);
+
+    GPtrArray *duplicates = g_ptr_array_new_with_free_func(
+        (GDestroyNotify)wad_duplicate_group_free
+    );
+    g_mutex_lock(&self->lock);
+    GHashTableIter iter;
+    ContentGroup *group;
+    g_hash_table_iter_init(&iter, self->groups);
+    while (g_hash_table_iter_next(&iter, nullptr, (gpointer *)&group)) {
+        for (; group; group = group->next) {
+            guint n_members = group->members->len;
+            if (n_members < 2) {
+                continue;
+            }
+            WadDuplicateGroup *duplicate = g_new(WadDuplicateGroup, 1);
+            duplicate->hash = group->hash;
+            duplicate->size = content_size(&group->content);
+            duplicate->archives
+                = g_ptr_array_new_full(n_members, g_object_unref);
+            duplicate->names = g_ptr_array_new_full(n_members, g_free);
+            for (guint i = 0; i < n_members; ++i) {
+                Member const *member = group->members->pdata[i];
+                g_ptr_array_add(
+                    duplicate->archives,
+                    g_object_ref(member->archive)
+                );
+                g_ptr_array_add(duplicate->names, g_strdup(member->name));
+            }
+            g_ptr_array_add(duplicates, duplicate);
+        }
+    }
+    g_mutex_unlock(&self->lock);
+    g_ptr_array_sort(duplicates, compare_duplicates);
+    return duplicates;
+}
@@ -0,0 +1,79 @@
+#pragma once
+
+#include "wad/wad-texturearchive.h"
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+// WadDuplicateGroup
+
+#define WAD_TYPE_DUPLICATE_GROUP wad_duplicate_group_get_type()
+
+/**
+ * WadDuplicateGroup:
+ * @hash: The content hash shared by the textures.
+ * @size: Size of the pixel and palette data of one copy, in bytes.
+ * @archives: (element-type WadTextureArchive): The archive holding each
+ * texture.
+ * @names: (element-type utf8): The name of each texture, in the same order as
+ * @archives.
+ *
+ * A set of textures with byte-identical content.
+ */
+typedef struct {
+    guint64 hash;
+    gsize size;
+    GPtrArray *archives;
+    GPtrArray *names;
+} WadDuplicateGroup;
+
+GType wad_duplicate_group_get_type(void);
+WadDuplicateGroup *wad_duplicate_group_copy(WadDuplicateGroup const *group);
+void wad_duplicate_group_free(WadDuplicateGroup *group);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(WadDuplicateGroup, wad_duplicate_group_free)
+
+// WadContentRegistry
+
+#define WAD_TYPE_CONTENT_REGISTRY wad_content_registry_get_type()
+
+G_DECLARE_FINAL_TYPE(
+    WadContentRegistry,
+    wad_content_registry,
+    WAD,
+    CONTENT_REGISTRY,
+    GObject
+)
+
+WadContentRegistry *wad_content_registry_new(void);
+
+guint wad_content_registry_add_archive(
+    WadContentRegistry *registry,
+    WadTextureArchive *archive,
+    guint n_threads
+);
+
+void wad_content_registry_remove_archive(
+    WadContentRegistry *registry,
+    WadTextureArchive *archive
+);
+
+gboolean wad_content_registry_get_hash(
+    WadContentRegistry *registry,
+    WadTextureArchive *archive,
+    char const *texture_name,
+    guint64 *hash
+);
+
+GBytes *wad_content_registry_lookup_rgba(
+    WadContentRegistry *registry,
+    WadTextureArchive *archive,
+    char const *texture_name,
+    guint *width,
+    guint *height
+);
+
+GPtrArray *wad_content_registry_get_duplicates(WadContentRegistry *registry);
+
+G_END_DECLS
@@ -1,5 +1,7 @@
 #include "wad-directoryentry.h"
 
+#include "wad-private.h"
+
 // WadFileType
 
 G_DEFINE_ENUM_TYPE(
@@ -31,3 +33,73 @@ void wad_directory_entry_free(WadDirectoryEntry *dir_entry)
 {
     g_free(dir_entry);
 }
+
+// Internal ////////////////////////////////////////////////////////////////////
+
+bool wad_file_type_is_valid(WadFileType file_type)
+{
+    switch (file_type) {
+    case WAD_FILE_TYPE_QPIC:
+    case WAD_FILE_TYPE_MIPTEX:
+    case WAD_FILE_TYPE_FONT:
+    case WAD_FILE_TYPE_SPRAYDECAL:
+        return true;
+    }
+    return false;
+}
+
+/*
+ * Decodes `n_entries` consecutive on-disk directory entries from `data` into
+ * `entries`.
+ */
+void wad_directory_entry_decode(
+    guchar const *restrict data,
+    guint32 n_entries,
+    WadDirectoryEntry *restrict entries
+)
+{
+    for (guint32 i = 0; i < n_entries; ++i) {
+        guchar const *p = data + (gsize)i * WAD_DIRECTORY_ENTRY_SIZE;
+        WadDirectoryEntry *entry = &entries[i];
+        guint32 u32;
+
+        memcpy(&u32, p + 0, 4);
+        entry->entry_offset = GUINT32_FROM_LE(u32);
+        memcpy(&u32, p + 4, 4);
+        entry->disk_size = GUINT32_FROM_LE(u32);
+        memcpy(&u32, p + 8, 4);
+        entry->entry_size = GUINT32_FROM_LE(u32);
+        entry->file_type = p[12];
+        entry->compressed = p[13];
+        memcpy(entry->texture_name, p + 16, 16);
+    }
+}
+
+/*
+ * Encodes `n_entries` directory entries into `data` in their on-disk form.
+ * The inverse of wad_directory_entry_decode().
+ */
+void wad_directory_entry_encode(
+    WadDirectoryEntry const *restrict entries,
+    guint32 n_entries,
+    guchar *restrict data
+)
+{
+    for (guint32 i = 0; i < n_entries; ++i) {
+        guchar *p = data + (gsize)i * WAD_DIRECTORY_ENTRY_SIZE;
+        WadDirectoryEntry const *entry = &entries[i];
+        guint32 u32;
+
+        u32 = GUINT32_TO_LE(entry->entry_offset);
+        memcpy(p + 0, &u32, 4);
+        u32 = GUINT32_TO_LE(entry->disk_size);
+        memcpy(p + 4, &u32, 4);
+        u32 = GUINT32_TO_LE(entry->entry_size);
+        memcpy(p + 8, &u32, 4);
+        p[12] = entry->file_type;
+        p[13] = entry->compressed;
+        p[14] = 0;
+        p[15] = 0;
+        memcpy(p + 16, entry->texture_name, 16);
+    }
+}
@@ -1,5 +1,7 @@
 #include "wad-fontfile.h"
 
+#include "wad-private.h"
+
 #include <gio/gio.h>
 
 // WadCharInfo
@@ -36,13 +38,26 @@ G_DEFINE_BOXED_TYPE(
 
 WadFontFile *wad_font_file_copy(WadFontFile const *font)
 {
-    WadFontFile *copy = g_new(WadFontFile, 1);
+    WadFontFile *copy = g_new0(WadFontFile, 1);
     copy->height = font->height;
     copy->row_count = font->row_count;
     copy->row_height = font->row_height;
-    copy->font_info = g_array_ref(font->font_info);
-    copy->data = g_array_ref(font->data);
-    copy->palette = g_array_ref(font->palette);
+    if (font->font_info) {
+        copy->font_info = g_array_ref(font->font_info);
+    }
+    if (font->data) {
+        copy->data = g_array_ref(font->data);
+    }
+    if (font->palette) {
+        copy->palette = g_array_ref(font->palette);
+    }
+    if (font->data_bytes) {
+        copy->data_bytes = g_bytes_ref(font->data_bytes);
+    }
+    if (font->palette_bytes) {
+        copy->palette_bytes = g_bytes_ref(font->palette_bytes);
+    }
+    copy->palette_id = font->palette_id;
     return copy;
 }
 
@@ -57,5 +72,99 @@ void wad_font_file_free(WadFontFile *font)
     if (font->palette) {
         g_array_unref(font->palette);
     }
+    if (font->data_bytes) {
+        g_bytes_unref(font->data_bytes);
+    }
+    if (font->palette_bytes) {
+        g_bytes_unref(font->palette_bytes);
+    }
     g_free(font);
 }
+
+/**
+ * wad_font_file_get_data:
+ * @font: A [struct@WadFontFile].
+ * @size: (out) (optional): Return location for the size of the image in bytes.
+ *
+ * Gets the indexed fontsheet pixels, from either @data or @data_bytes.
+ * Returns: (transfer none) (nullable) (array length=size): The pixel data.
+ */
+guchar const *wad_font_file_get_data(WadFontFile const *font, gsize *size)
+{
+    g_return_val_if_fail(font != nullptr, nullptr);
+
+    if (font->data_bytes) {
+        return g_bytes_get_data(font->data_bytes, size);
+    }
+    if (size) {
+        *size = font->data ? font->data->len : 0;
+    }
+    return font->data ? (guchar const *)font->data->data : nullptr;
+}
+
+/**
+ * wad_font_file_get_palette_data:
+ * @font: A [struct@WadFontFile].
+ * @n_colors: (out) (optional): Return location for the number of colors.
+ *
+ * Gets the color palette, from either @palette or @palette_bytes.
+ * Returns: (transfer none) (nullable) (array length=n_colors): The palette.
+ */
+WadRgb const *
+wad_font_file_get_palette_data(WadFontFile const *font, gsize *n_colors)
+{
+    g_return_val_if_fail(font != nullptr, nullptr);
+
+    if (font->palette_bytes) {
+        gsize size = 0;
+        gconstpointer data = g_bytes_get_data(font->palette_bytes, &size);
+        if (n_colors) {
+            *n_colors = size / sizeof(WadRgb);
+        }
+        return data;
+    }
+    if (n_colors) {
+        *n_colors = font->palette ? font->palette->len : 0;
+    }
+    return font->palette ? (WadRgb const *)font->palette->data : nullptr;
+}
+
+/**
+ * wad_font_file_to_rgba:
+ * @font: A [struct@WadFontFile].
+ * @gamma: (nullable): Color correction to apply, or `NULL` for none.
+ * @dest: (array): Buffer to write 8-bit RGBA pixels to. Must hold `height`
+ * rows of `dest_stride` bytes.
+ * @dest_stride: Distance between rows of @dest in bytes. Must be at least
+ * 1024, as the fontsheet is 256 pixels wide.
+ *
+ * Converts the fontsheet to RGBA using its palette. Every pixel is fully
+ * opaque.
+ */
+void wad_font_file_to_rgba(
+    WadFontFile const *font,
+    WadGammaTable const *gamma,
+    guchar *dest,
+    gsize dest_stride
+)
+{
+    g_return_if_fail(font != nullptr);
+    g_return_if_fail(dest != nullptr);
+    g_return_if_fail(dest_stride >= 256 * 4);
+
+    gsize n_colors = 0;
+    WadRgb const *palette = wad_font_file_get_palette_data(font, &n_colors);
+    gsize size = 0;
+    guchar const *data = wad_font_file_get_data(font, &size);
+    WadPaletteLut lut;
+    wad_palette_lut_init(&lut, palette, n_colors, gamma);
+    wad_palette_lut_expand(
+        &lut,
+        data,
+        size,
+        256,
+        font->height,
+        dest,
+        dest_stride
+    );
+}
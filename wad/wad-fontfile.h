@@ -2,6 +2,8 @@
 
 #include <gio/gio.h>
 #include <glib-object.h>
+#include <wad/wad-gammatable.h>
+#include <wad/wad-rgb.h>
 
 G_BEGIN_DECLS
 
@@ -39,10 +41,24 @@ G_DEFINE_AUTOPTR_CLEANUP_FUNC(WadCharInfo, wad_char_info_free)
  * @row_height: Height of the glyph rows.
  * @font_info: (array fixed-size=256) (element-type WadCharInfo): Glyph data for
  * codepoints 0-255.
- * @data: (element-type guchar): Image data in indexed format.
- * @palette: (element-type WadRgb): Image color palette.
+ * @data: (element-type guchar) (nullable): Image data in indexed format.
+ * `NULL` when the font holds it in @data_bytes instead.
+ * @palette: (element-type WadRgb) (nullable): Image color palette. `NULL` when
+ * the font holds it in @palette_bytes instead.
+ * @data_bytes: (nullable): The image data as a read-only view of the WAD
+ * image. Set instead of @data by wad_root_load_from_mapped_file() and
+ * wad_root_load_from_sequential_stream().
+ * @palette_bytes: (nullable): The palette, read-only. Set instead of @palette
+ * once the texture is in a [class@WadTextureArchive], which shares one copy
+ * between all of its textures with the same palette.
+ * @palette_id: Identifies the palette among those interned by
+ * [class@WadTextureArchive]; textures with the same non-zero id share one
+ * palette. Zero if the palette was not interned.
  *
  * A font sheet texture.
+ *
+ * Use wad_font_file_get_data() and wad_font_file_get_palette_data() to read
+ * the image regardless of how it was loaded.
  */
 typedef struct {
     guint32 height;
@@ -51,12 +67,26 @@ typedef struct {
     GArray *font_info;
     GArray *data;
     GArray *palette;
+    GBytes *data_bytes;
+    GBytes *palette_bytes;
+    guint palette_id;
 } WadFontFile;
 
 GType wad_font_file_get_type(void);
 WadFontFile *wad_font_file_copy(WadFontFile const *font);
 void wad_font_file_free(WadFontFile *font);
 
+guchar const *wad_font_file_get_data(WadFontFile const *font, gsize *size);
+WadRgb const *
+wad_font_file_get_palette_data(WadFontFile const *font, gsize *n_colors);
+
+void wad_font_file_to_rgba(
+    WadFontFile const *font,
+    WadGammaTable const *gamma,
+    guchar *dest,
+    gsize dest_stride
+);
+
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(WadFontFile, wad_font_file_free)
 
 G_END_DECLS
@@ -0,0 +1,48 @@
+#include "wad-gammatable.h"
+
+#include <math.h>
+
+G_DEFINE_BOXED_TYPE(
+    WadGammaTable,
+    wad_gamma_table,
+    wad_gamma_table_copy,
+    wad_gamma_table_free
+)
+
+/**
+ * wad_gamma_table_new:
+ * @gamma: Gamma of the texture data, like the engine's `texgamma`. Must be
+ * positive; 1.0 leaves values unchanged.
+ * @brightness: Factor applied after the gamma curve. 1.0 leaves values
+ * unchanged.
+ *
+ * Builds a correction table in the way GoldSrc builds its texture gamma
+ * table: each value `v` maps to
+ * `255 * brightness * pow((v + 0.5) / 255.5, 1 / gamma) + 0.5`, clamped to
+ * 0-255.
+ *
+ * Returns: (transfer full): A new [struct@WadGammaTable].
+ */
+WadGammaTable *wad_gamma_table_new(gdouble gamma, gdouble brightness)
+{
+    g_return_val_if_fail(gamma > 0.0, nullptr);
+
+    WadGammaTable *table = g_new(WadGammaTable, 1);
+    for (size_t i = 0; i < 256; ++i) {
+        gdouble v = 255.0 * brightness * pow((i + 0.5) / 255.5, 1.0 / gamma);
+        table->values[i] = (guchar)CLAMP(v + 0.5, 0.0, 255.0);
+    }
+    return table;
+}
+
+WadGammaTable *wad_gamma_table_copy(WadGammaTable const *table)
+{
+    WadGammaTable *copy = g_new(WadGammaTable, 1);
+    memcpy(copy, table, sizeof(WadGammaTable));
+    return copy;
+}
+
+void wad_gamma_table_free(WadGammaTable *table)
+{
+    g_free(table);
+}
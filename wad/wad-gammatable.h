@@ -0,0 +1,29 @@
+#pragma once
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define WAD_TYPE_GAMMA_TABLE wad_gamma_table_get_type()
+
+/**
+ * WadGammaTable:
+ * @values: (array fixed-size=256): Corrected value for each input value.
+ *
+ * A per-channel color correction curve.
+ *
+ * Conversions such as wad_miptex_file_to_rgba() apply it to the palette once,
+ * before expanding the image, so it adds no per-pixel work.
+ */
+typedef struct {
+    guchar values[256];
+} WadGammaTable;
+
+GType wad_gamma_table_get_type(void);
+WadGammaTable *wad_gamma_table_new(gdouble gamma, gdouble brightness);
+WadGammaTable *wad_gamma_table_copy(WadGammaTable const *table);
+void wad_gamma_table_free(WadGammaTable *table);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(WadGammaTable, wad_gamma_table_free)
+
+G_END_DECLS
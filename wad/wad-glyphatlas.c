@@ -0,0 +1,298 @@
+#include "wad-glyphatlas.h"
+
+#include "wad-private.h"
+
+// WadGlyphQuad
+
+G_DEFINE_BOXED_TYPE(
+    WadGlyphQuad,
+    wad_glyph_quad,
+    wad_glyph_quad_copy,
+    wad_glyph_quad_free
+)
+
+WadGlyphQuad *wad_glyph_quad_copy(WadGlyphQuad const *quad)
+{
+    WadGlyphQuad *copy = g_new(WadGlyphQuad, 1);
+    memcpy(copy, quad, sizeof(WadGlyphQuad));
+    return copy;
+}
+
+void wad_glyph_quad_free(WadGlyphQuad *quad)
+{
+    g_free(quad);
+}
+
+// WadGlyphAtlas
+
+/**
+ * WadGlyphAtlas:
+ *
+ * A font sheet expanded to RGBA once, with the rectangle of each glyph worked
+ * out ahead of time, for drawing text repeatedly.
+ *
+ * The atlas is the font sheet itself: 256 pixels wide and as tall as the font.
+ * Palette index 255 is drawn as transparent, as in the engine.
+ */
+struct _WadGlyphAtlas {
+    GObject parent_instance;
+    GBytes *pixels;
+    guint width, height;
+    guint row_height;
+    WadAtlasRegion glyphs[256];
+};
+
+G_DEFINE_FINAL_TYPE(WadGlyphAtlas, wad_glyph_atlas, G_TYPE_OBJECT)
+
+// Private /////////////////////////////////////////////////////////////////////
+
+/* Palette index drawn as transparent in font sheets. */
+#define TRANSPARENT_INDEX 255
+
+// Finds the glyph rectangles, clipped to the sheet.
+static void init_glyphs(WadGlyphAtlas *self, WadFontFile const *font)
+{
+    guint n_chars = font->font_info ? MIN(font->font_info->len, 256) : 0;
+    for (guint c = 0; c < n_chars; ++c) {
+        WadCharInfo const *info
+            = &g_array_index(font->font_info, WadCharInfo, c);
+        WadAtlasRegion *glyph = &self->glyphs[c];
+        glyph->x = (guchar)info->offset_x;
+        glyph->y = (guchar)info->offset_y;
+        if (glyph->x >= self->width || glyph->y >= self->height) {
+            continue;
+        }
+        glyph->width = MIN(info->charwidth, self->width - glyph->x);
+        glyph->height = MIN(self->row_height, self->height - glyph->y);
+        glyph->u0 = (gfloat)glyph->x / self->width;
+        glyph->v0 = (gfloat)glyph->y / self->height;
+        glyph->u1 = (gfloat)(glyph->x + glyph->width) / self->width;
+        glyph->v1 = (gfloat)(glyph->y + glyph->height) / self->height;
+    }
+}
+
+// Decodes one character of @text, advancing @p. Bytes that are not valid
+// UTF-8 are taken as they are, so text in the game's 8-bit encoding also works.
+static guchar next_character(char const **p, char const *end)
+{
+    guchar byte = **p;
+    if (byte < 0x80) {
+        *p += 1;
+        return byte;
+    }
+    gunichar c = g_utf8_get_char_validated(*p, end - *p);
+    if (c == (gunichar)-1 || c == (gunichar)-2) {
+        *p += 1;
+        return byte;
+    }
+    *p = g_utf8_next_char(*p);
+    return c <= 0xFF ? c : '?';
+}
+
+// GObject /////////////////////////////////////////////////////////////////////
+
+static void wad_glyph_atlas_finalize(GObject *object)
+{
+    WadGlyphAtlas *self = WAD_GLYPH_ATLAS(object);
+    g_clear_pointer(&self->pixels, g_bytes_unref);
+    G_OBJECT_CLASS(wad_glyph_atlas_parent_class)->finalize(object);
+}
+
+// WadGlyphAtlas ///////////////////////////////////////////////////////////////
+
+static void wad_glyph_atlas_class_init(WadGlyphAtlasClass *klass)
+{
+    GObjectClass *oclass = G_OBJECT_CLASS(klass);
+    oclass->finalize = wad_glyph_atlas_finalize;
+}
+
+static void wad_glyph_atlas_init(WadGlyphAtlas *)
+{
+}
+
+// Public //////////////////////////////////////////////////////////////////////
+
+/**
+ * wad_glyph_atlas_new:
+ * @font: The font to convert.
+ * @gamma: (nullable): Color correction to apply, or `NULL` for none.
+ *
+ * Expands a font sheet to RGBA and records where each glyph is.
+ *
+ * Returns: A new [class@WadGlyphAtlas].
+ */
+WadGlyphAtlas *
+wad_glyph_atlas_new(WadFontFile const *font, WadGammaTable const *gamma)
+{
+    g_return_val_if_fail(font != nullptr, nullptr);
+
+    WadGlyphAtlas *self = g_object_new(WAD_TYPE_GLYPH_ATLAS, nullptr);
+    self->width = 256;
+    self->height = font->height;
+    self->row_height = font->row_height;
+
+    gsize n_colors = 0;
+    WadRgb const *palette = wad_font_file_get_palette_data(font, &n_colors);
+    gsize size = 0;
+    guchar const *data = wad_font_file_get_data(font, &size);
+    gsize stride = (gsize)self->width * 4;
+    guchar *pixels = g_new(guchar, stride * self->height);
+    WadPaletteLut lut;
+    wad_palette_lut_init(&lut, palette, n_colors, gamma);
+    wad_palette_lut_set_transparent(&lut, TRANSPARENT_INDEX);
+    wad_palette_lut_expand(
+        &lut,
+        data,
+        size,
+        self->width,
+        self->height,
+        pixels,
+        stride
+    );
+    self->pixels = g_bytes_new_take(pixels, stride * self->height);
+
+    init_glyphs(self, font);
+    return self;
+}
+
+/**
+ * wad_glyph_atlas_get_pixels:
+ * @atlas: A [class@WadGlyphAtlas].
+ * @width: (out) (optional): Return location for the width of the image.
+ * @height: (out) (optional): Return location for the height of the image.
+ *
+ * Gets the font sheet as tightly-packed 8-bit RGBA rows.
+ *
+ * Returns: (transfer full): The pixels.
+ */
+GBytes *
+wad_glyph_atlas_get_pixels(WadGlyphAtlas *self, guint *width, guint *height)
+{
+    g_return_val_if_fail(WAD_IS_GLYPH_ATLAS(self), nullptr);
+
+    if (width) {
+        *width = self->width;
+    }
+    if (height) {
+        *height = self->height;
+    }
+    return g_bytes_ref(self->pixels);
+}
+
+/**
+ * wad_glyph_atlas_get_row_height:
+ * @atlas: A [class@WadGlyphAtlas].
+ *
+ * Gets the height of a line of text.
+ *
+ * Returns: The line height, in pixels.
+ */
+guint wad_glyph_atlas_get_row_height(WadGlyphAtlas *self)
+{
+    g_return_val_if_fail(WAD_IS_GLYPH_ATLAS(self), 0);
+    return self->row_height;
+}
+
+/**
+ * wad_glyph_atlas_get_glyph:
+ * @atlas: A [class@WadGlyphAtlas].
+ * @character: The character, in the font's 8-bit encoding.
+ * @region: (out caller-allocates): Return location for the glyph's rectangle.
+ *
+ * Looks up where a glyph is on the font sheet. The region's page is always 0.
+ *
+ * Returns: Whether the font has a glyph for @character.
+ */
+gboolean wad_glyph_atlas_get_glyph(
+    WadGlyphAtlas *self,
+    guchar character,
+    WadAtlasRegion *region
+)
+{
+    g_return_val_if_fail(WAD_IS_GLYPH_ATLAS(self), FALSE);
+    g_return_val_if_fail(region != nullptr, FALSE);
+
+    *region = self->glyphs[character];
+    return region->width != 0;
+}
+
+/**
+ * wad_glyph_atlas_layout:
+ * @atlas: A [class@WadGlyphAtlas].
+ * @text: (array length=length): UTF-8 text to lay out.
+ * @length: Length of @text in bytes, or -1 if it is nul-terminated.
+ * @x: Left edge of the text, in pixels.
+ * @y: Top edge of the first line, in pixels.
+ * @quads: (element-type WadGlyphQuad): Array to append the glyph quads to.
+ * Reusing the same array between calls avoids reallocating it.
+ * @width: (out) (optional): Return location for the width of the widest line.
+ *
+ * Places the glyphs of @text, left to right, starting a new line at each
+ * `\n`. Characters beyond U+00FF are drawn as `?`; bytes that are not valid
+ * UTF-8 are taken to be in the font's own encoding. Spaces and characters
+ * without a glyph advance the pen without adding a quad.
+ *
+ * Returns: The number of quads appended.
+ */
+guint wad_glyph_atlas_layout(
+    WadGlyphAtlas *self,
+    char const *text,
+    gssize length,
+    gfloat x,
+    gfloat y,
+    GArray *quads,
+    gfloat *width
+)
+{
+    g_return_val_if_fail(WAD_IS_GLYPH_ATLAS(self), 0);
+    g_return_val_if_fail(text != nullptr || length == 0, 0);
+    g_return_val_if_fail(quads != nullptr, 0);
+    g_return_val_if_fail(
+        g_array_get_element_size(quads) == sizeof(WadGlyphQuad),
+        0
+    );
+
+    gsize n_bytes = length < 0 ? strlen(text) : (gsize)length;
+    char const *p = text;
+    char const *end = text + n_bytes;
+
+    // Every character takes at least one byte, so this is enough room.
+    guint start = quads->len;
+    g_array_set_size(quads, start + n_bytes);
+    WadGlyphQuad *out = &g_array_index(quads, WadGlyphQuad, start);
+    guint n_quads = 0;
+
+    gfloat pen_x = x;
+    gfloat pen_y = y;
+    gfloat max_width = 0;
+    while (p < end) {
+        guchar c = next_character(&p, end);
+        if (c == '\n') {
+            max_width = MAX(max_width, pen_x - x);
+            pen_x = x;
+            pen_y += self->row_height;
+            continue;
+        }
+        WadAtlasRegion const *glyph = &self->glyphs[c];
+        if (c != ' ' && glyph->width != 0) {
+            WadGlyphQuad *quad = &out[n_quads++];
+            quad->character = c;
+            quad->x0 = pen_x;
+            quad->y0 = pen_y;
+            quad->x1 = pen_x + glyph->width;
+            quad->y1 = pen_y + glyph->height;
+            quad->u0 = glyph->u0;
+            quad->v0 = glyph->v0;
+            quad->u1 = glyph->u1;
+            quad->v1 = glyph->v1;
+        }
+        pen_x += glyph->width;
+    }
+    max_width = MAX(max_width, pen_x - x);
+
+    g_array_set_size(quads, start + n_quads);
+    if (width) {
+        *width = max_width;
+    }
+    return n_quads;
+}
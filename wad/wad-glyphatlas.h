@@ -0,0 +1,71 @@
+#pragma once
+
+#include "wad/wad-atlas.h"
+#include "wad/wad-fontfile.h"
+#include "wad/wad-gammatable.h"
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+// WadGlyphQuad
+
+#define WAD_TYPE_GLYPH_QUAD wad_glyph_quad_get_type()
+
+/**
+ * WadGlyphQuad:
+ * @character: The character drawn.
+ * @x0: Left edge of the quad, in pixels.
+ * @y0: Top edge of the quad, in pixels.
+ * @x1: Right edge of the quad, in pixels.
+ * @y1: Bottom edge of the quad, in pixels.
+ * @u0: Left edge of the glyph, in texture coordinates.
+ * @v0: Top edge of the glyph, in texture coordinates.
+ * @u1: Right edge of the glyph, in texture coordinates.
+ * @v1: Bottom edge of the glyph, in texture coordinates.
+ *
+ * A glyph placed by wad_glyph_atlas_layout().
+ */
+typedef struct {
+    guchar character;
+    gfloat x0, y0, x1, y1;
+    gfloat u0, v0, u1, v1;
+} WadGlyphQuad;
+
+GType wad_glyph_quad_get_type(void);
+WadGlyphQuad *wad_glyph_quad_copy(WadGlyphQuad const *quad);
+void wad_glyph_quad_free(WadGlyphQuad *quad);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(WadGlyphQuad, wad_glyph_quad_free)
+
+// WadGlyphAtlas
+
+#define WAD_TYPE_GLYPH_ATLAS wad_glyph_atlas_get_type()
+
+G_DECLARE_FINAL_TYPE(WadGlyphAtlas, wad_glyph_atlas, WAD, GLYPH_ATLAS, GObject)
+
+WadGlyphAtlas *
+wad_glyph_atlas_new(WadFontFile const *font, WadGammaTable const *gamma);
+
+GBytes *
+wad_glyph_atlas_get_pixels(WadGlyphAtlas *atlas, guint *width, guint *height);
+
+guint wad_glyph_atlas_get_row_height(WadGlyphAtlas *atlas);
+
+gboolean wad_glyph_atlas_get_glyph(
+    WadGlyphAtlas *atlas,
+    guchar character,
+    WadAtlasRegion *region
+);
+
+guint wad_glyph_atlas_layout(
+    WadGlyphAtlas *atlas,
+    char const *text,
+    gssize length,
+    gfloat x,
+    gfloat y,
+    GArray *quads,
+    gfloat *width
+);
+
+G_END_DECLS
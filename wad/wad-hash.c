@@ -0,0 +1,96 @@
+/*
+ * A fast non-cryptographic 64-bit hash, for recognising texture content that
+ * has been seen before.
+ */
+#include "wad-private.h"
+
+// Private /////////////////////////////////////////////////////////////////////
+
+#define PRIME64_1 0x9e3779b185ebca87u
+#define PRIME64_2 0xc2b2ae3d27d4eb4fu
+#define PRIME64_3 0x165667b19e3779f9u
+#define PRIME64_4 0x85ebca77c2b2ae63u
+#define PRIME64_5 0x27d4eb2f165667c5u
+
+static inline guint64 rotl64(guint64 x, int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+static inline guint64 read64(guchar const *p)
+{
+    guint64 value;
+    memcpy(&value, p, 8);
+    return GUINT64_FROM_LE(value);
+}
+
+static inline guint64 hash_round(guint64 acc, guint64 input)
+{
+    acc += input * PRIME64_2;
+    return rotl64(acc, 31) * PRIME64_1;
+}
+
+static inline guint64 hash_merge(guint64 acc, guint64 lane)
+{
+    acc ^= hash_round(0, lane);
+    return acc * PRIME64_1 + PRIME64_4;
+}
+
+// Internal ////////////////////////////////////////////////////////////////////
+
+/*
+ * XXH64 of `data`, continuing from `seed`. Long inputs are consumed in four
+ * independent lanes, so the multiplies of one lane overlap those of the
+ * others.
+ */
+guint64 wad_hash_bytes(guint64 seed, gconstpointer data, gsize size)
+{
+    guchar const *p = data;
+    guchar const *end = p + size;
+    guint64 h;
+
+    if (size >= 32) {
+        guint64 v1 = seed + PRIME64_1 + PRIME64_2;
+        guint64 v2 = seed + PRIME64_2;
+        guint64 v3 = seed;
+        guint64 v4 = seed - PRIME64_1;
+        do {
+            v1 = hash_round(v1, read64(p));
+            v2 = hash_round(v2, read64(p + 8));
+            v3 = hash_round(v3, read64(p + 16));
+            v4 = hash_round(v4, read64(p + 24));
+            p += 32;
+        } while (end - p >= 32);
+        h = rotl64(v1, 1) + rotl64(v2, 7) + rotl64(v3, 12) + rotl64(v4, 18);
+        h = hash_merge(h, v1);
+        h = hash_merge(h, v2);
+        h = hash_merge(h, v3);
+        h = hash_merge(h, v4);
+    } else {
+        h = seed + PRIME64_5;
+    }
+    h += size;
+
+    for (; end - p >= 8; p += 8) {
+        h ^= hash_round(0, read64(p));
+        h = rotl64(h, 27) * PRIME64_1 + PRIME64_4;
+    }
+    if (end - p >= 4) {
+        guint32 value;
+        memcpy(&value, p, 4);
+        h ^= GUINT32_FROM_LE(value) * PRIME64_1;
+        h = rotl64(h, 23) * PRIME64_2 + PRIME64_3;
+        p += 4;
+    }
+    for (; p < end; ++p) {
+        h ^= *p * PRIME64_5;
+        h = rotl64(h, 11) * PRIME64_1;
+    }
+
+    h ^= h >> 33;
+    h *= PRIME64_2;
+    h ^= h >> 29;
+    h *= PRIME64_3;
+    h ^= h >> 32;
+    return h;
+}
@@ -3,6 +3,9 @@
  */
 #include "wad-inputstream.h"
 
+#include "wad-loaderror.h"
+#include "wad-private.h"
+
 #include <gio/gio.h>
 
 /**
@@ -42,6 +45,56 @@ static void wad_input_stream_init(WadInputStream *)
 {
 }
 
+// Private /////////////////////////////////////////////////////////////////////
+
+// Entries read at a time, which bounds the buffer whatever the header claims.
+#define DIRECTORY_CHUNK_ENTRIES 4096
+
+/*
+ * Checks that a directory of `num_dirs` entries starting at the current
+ * position fits in the rest of a seekable stream. Streams which cannot seek
+ * pass, and are bounded by what they actually hold instead.
+ */
+static bool directory_fits(
+    WadInputStream *self,
+    guint32 num_dirs,
+    GCancellable *cancellable,
+    GError **error
+)
+{
+    GSeekable *seekable = G_SEEKABLE(self);
+    if (!g_seekable_can_seek(seekable)) {
+        return true;
+    }
+    GError *e = nullptr;
+    goffset start = g_seekable_tell(seekable);
+    g_seekable_seek(seekable, 0, G_SEEK_END, cancellable, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return false;
+    }
+    goffset end = g_seekable_tell(seekable);
+    g_seekable_seek(seekable, start, G_SEEK_SET, cancellable, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return false;
+    }
+    guint64 size = (guint64)num_dirs * WAD_DIRECTORY_ENTRY_SIZE;
+    if (end < start || size > (guint64)(end - start)) {
+        g_set_error(
+            error,
+            WAD_LOAD_ERROR,
+            WAD_LOAD_ERROR_TRUNCATED,
+            "Directory truncated: expected %" G_GUINT64_FORMAT
+            " bytes, %" G_GOFFSET_FORMAT " left in the stream",
+            size,
+            MAX(end - start, 0)
+        );
+        return false;
+    }
+    return true;
+}
+
 // Public //////////////////////////////////////////////////////////////////////
 
 /**
@@ -77,54 +130,113 @@ wad_input_stream_read_directory_entry(WadInputStream *self, GError **error)
     g_return_val_if_fail(WAD_IS_INPUT_STREAM(self), nullptr);
     g_return_val_if_fail(error == nullptr || *error == nullptr, nullptr);
 
-    GDataInputStream *stream = G_DATA_INPUT_STREAM(self);
+    guchar buffer[WAD_DIRECTORY_ENTRY_SIZE];
+    gsize bytes_read;
     GError *e = nullptr;
-    g_autoptr(WadDirectoryEntry) entry = g_new(WadDirectoryEntry, 1);
 
-    entry->entry_offset = g_data_input_stream_read_uint32(stream, nullptr, &e);
-    if (e) {
-        g_propagate_error(error, e);
-        return nullptr;
-    }
-    entry->disk_size = g_data_input_stream_read_uint32(stream, nullptr, &e);
-    if (e) {
-        g_propagate_error(error, e);
-        return nullptr;
-    }
-    entry->entry_size = g_data_input_stream_read_uint32(stream, nullptr, &e);
-    if (e) {
-        g_propagate_error(error, e);
-        return nullptr;
-    }
-    entry->file_type = g_data_input_stream_read_byte(stream, nullptr, &e);
+    g_input_stream_read_all(
+        G_INPUT_STREAM(self),
+        buffer,
+        sizeof(buffer),
+        &bytes_read,
+        nullptr,
+        &e
+    );
     if (e) {
         g_propagate_error(error, e);
         return nullptr;
     }
-    entry->compressed = g_data_input_stream_read_byte(stream, nullptr, &e);
-    if (e) {
-        g_propagate_error(error, e);
+    if (bytes_read != sizeof(buffer)) {
+        g_set_error_literal(
+            error,
+            WAD_LOAD_ERROR,
+            WAD_LOAD_ERROR_TRUNCATED,
+            "Directory entry truncated"
+        );
         return nullptr;
     }
-    g_data_input_stream_read_uint16(stream, nullptr, &e);
-    if (e) {
-        g_propagate_error(error, e);
+    WadDirectoryEntry *entry = g_new(WadDirectoryEntry, 1);
+    wad_directory_entry_decode(buffer, 1, entry);
+    return entry;
+}
+
+/**
+ * wad_input_stream_read_directory:
+ * @stream: A [class@WadInputStream].
+ * @num_dirs: Number of entries in the directory.
+ * @cancellable: (nullable): A [class@Gio.Cancellable].
+ * @error: The return location for [struct@GError].
+ *
+ * Reads a whole WAD directory of `num_dirs` entries from `stream`, decoding it
+ * into one contiguous array. `num_dirs` is checked against the size of a
+ * seekable stream first, and the array only grows as entries arrive, so a
+ * bogus count fails with %WAD_LOAD_ERROR_TRUNCATED instead of allocating it.
+ * Returns: (transfer full) (element-type WadDirectoryEntry): The directory, or
+ * `NULL` if an error occurred.
+ */
+GArray *wad_input_stream_read_directory(
+    WadInputStream *self,
+    guint32 num_dirs,
+    GCancellable *cancellable,
+    GError **error
+)
+{
+    g_return_val_if_fail(WAD_IS_INPUT_STREAM(self), nullptr);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, nullptr);
+
+    if (!directory_fits(self, num_dirs, cancellable, error)) {
         return nullptr;
     }
-    gsize bytes_read;
-    g_input_stream_read_all(
-        G_INPUT_STREAM(stream),
-        entry->texture_name,
-        16,
-        &bytes_read,
-        nullptr,
-        &e
+    g_autoptr(GArray) directory = g_array_sized_new(
+        FALSE,
+        FALSE,
+        sizeof(WadDirectoryEntry),
+        MIN(num_dirs, DIRECTORY_CHUNK_ENTRIES)
     );
-    if (e) {
-        g_propagate_error(error, e);
-        return nullptr;
+    g_autofree guchar *buffer = g_malloc(
+        (gsize)MIN(num_dirs, DIRECTORY_CHUNK_ENTRIES)
+        * WAD_DIRECTORY_ENTRY_SIZE
+    );
+    GError *e = nullptr;
+
+    while (directory->len < num_dirs) {
+        guint count = MIN(num_dirs - directory->len, DIRECTORY_CHUNK_ENTRIES);
+        gsize size = (gsize)count * WAD_DIRECTORY_ENTRY_SIZE;
+        gsize bytes_read;
+        g_input_stream_read_all(
+            G_INPUT_STREAM(self),
+            buffer,
+            size,
+            &bytes_read,
+            cancellable,
+            &e
+        );
+        if (e) {
+            g_propagate_error(error, e);
+            return nullptr;
+        }
+        if (bytes_read != size) {
+            g_set_error(
+                error,
+                WAD_LOAD_ERROR,
+                WAD_LOAD_ERROR_TRUNCATED,
+                "Directory truncated: expected %" G_GUINT64_FORMAT
+                " bytes, got %" G_GUINT64_FORMAT,
+                (guint64)num_dirs * WAD_DIRECTORY_ENTRY_SIZE,
+                (guint64)directory->len * WAD_DIRECTORY_ENTRY_SIZE
+                    + bytes_read
+            );
+            return nullptr;
+        }
+        guint first = directory->len;
+        g_array_set_size(directory, first + count);
+        wad_directory_entry_decode(
+            buffer,
+            count,
+            &g_array_index(directory, WadDirectoryEntry, first)
+        );
     }
-    return wad_directory_entry_copy(entry);
+    return g_steal_pointer(&directory);
 }
 
 /**
@@ -145,7 +257,7 @@ wad_input_stream_read_qpic_file(WadInputStream *self, GError **error)
     GDataInputStream *stream = G_DATA_INPUT_STREAM(self);
     gsize bytes_read;
     GError *e = nullptr;
-    g_autoptr(WadQpicFile) qpic = g_new(WadQpicFile, 1);
+    g_autoptr(WadQpicFile) qpic = g_new0(WadQpicFile, 1);
 
     qpic->width = g_data_input_stream_read_uint32(stream, nullptr, &e);
     if (e) {
@@ -217,7 +329,7 @@ wad_input_stream_read_miptex_file(WadInputStream *self, GError **error)
     GDataInputStream *stream = G_DATA_INPUT_STREAM(self);
     gsize bytes_read;
     GError *e = nullptr;
-    g_autoptr(WadMiptexFile) miptex = g_new(WadMiptexFile, 1);
+    g_autoptr(WadMiptexFile) miptex = g_new0(WadMiptexFile, 1);
 
     g_input_stream_read_all(
         G_INPUT_STREAM(stream),
@@ -290,6 +402,7 @@ wad_input_stream_read_miptex_file(WadInputStream *self, GError **error)
             return nullptr;
         }
     }
+    wad_miptex_file_update_alpha(miptex);
     return wad_miptex_file_copy(miptex);
 }
 
@@ -311,7 +424,7 @@ wad_input_stream_read_font_file(WadInputStream *self, GError **error)
     GDataInputStream *stream = G_DATA_INPUT_STREAM(self);
     gsize bytes_read;
     GError *e = nullptr;
-    g_autoptr(WadFontFile) font = g_new(WadFontFile, 1);
+    g_autoptr(WadFontFile) font = g_new0(WadFontFile, 1);
 
     g_data_input_stream_read_uint32(stream, nullptr, &e);
     if (e) {
@@ -421,3 +534,122 @@ wad_input_stream_read_char_info(WadInputStream *self, GError **error)
     }
     return wad_char_info_copy(&char_info);
 }
+
+// Internal ////////////////////////////////////////////////////////////////////
+
+/*
+ * Reads and checks the WAD3 header.
+ */
+void wad_input_stream_read_header(
+    WadInputStream *self,
+    guint32 *num_dirs,
+    guint32 *dir_offset,
+    GCancellable *cancellable,
+    GError **error
+)
+{
+    GDataInputStream *stream = G_DATA_INPUT_STREAM(self);
+    GError *e = nullptr;
+
+    char buffer[4];
+    gsize bytes_read;
+    g_input_stream_read_all(
+        G_INPUT_STREAM(stream),
+        buffer,
+        4,
+        &bytes_read,
+        cancellable,
+        &e
+    );
+    if (e) {
+        g_propagate_error(error, e);
+        return;
+    }
+    if (strncmp(buffer, "WAD3", 4) != 0) {
+        g_set_error(
+            error,
+            WAD_LOAD_ERROR,
+            WAD_LOAD_ERROR_MAGIC,
+            "Bad magic number %.4s",
+            buffer
+        );
+        return;
+    }
+    *num_dirs = g_data_input_stream_read_uint32(stream, cancellable, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return;
+    }
+    *dir_offset = g_data_input_stream_read_uint32(stream, cancellable, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return;
+    }
+}
+
+/*
+ * Seeks to `entry` and decodes it. The returned texture is empty if an error
+ * occurred.
+ */
+WadTexture wad_input_stream_read_entry(
+    WadInputStream *self,
+    WadDirectoryEntry const *entry,
+    GError **error
+)
+{
+    GError *e = nullptr;
+
+    g_seekable_seek(
+        G_SEEKABLE(self),
+        entry->entry_offset,
+        G_SEEK_SET,
+        nullptr,
+        &e
+    );
+    if (e) {
+        g_propagate_error(error, e);
+        return (WadTexture){};
+    }
+    switch (entry->file_type) {
+    case WAD_FILE_TYPE_QPIC: {
+        WadQpicFile *qpic = wad_input_stream_read_qpic_file(self, &e);
+        if (e) {
+            g_propagate_error(error, e);
+            return (WadTexture){};
+        }
+        g_info(
+            "%.16s -- Qpic (%" G_GUINT32_FORMAT " x %" G_GUINT32_FORMAT ")",
+            entry->texture_name,
+            qpic->width,
+            qpic->height
+        );
+        return (WadTexture){WAD_TYPE_QPIC_FILE, qpic};
+    }
+    case WAD_FILE_TYPE_SPRAYDECAL:
+    case WAD_FILE_TYPE_MIPTEX: {
+        WadMiptexFile *miptex = wad_input_stream_read_miptex_file(self, &e);
+        if (e) {
+            g_propagate_error(error, e);
+            return (WadTexture){};
+        }
+        g_info("%.16s -- miptex/spraydecal", entry->texture_name);
+        return (WadTexture){WAD_TYPE_MIPTEX_FILE, miptex};
+    }
+    case WAD_FILE_TYPE_FONT: {
+        WadFontFile *font = wad_input_stream_read_font_file(self, &e);
+        if (e) {
+            g_propagate_error(error, e);
+            return (WadTexture){};
+        }
+        g_info(
+            "%.16s -- font (%" G_GUINT32_FORMAT " rows)",
+            entry->texture_name,
+            font->row_count
+        );
+        return (WadTexture){WAD_TYPE_FONT_FILE, font};
+    }
+    default:
+        wad_set_file_type_error(error, entry->file_type);
+        return (WadTexture){};
+    }
+}
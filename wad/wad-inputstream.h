@@ -25,6 +25,13 @@ WadInputStream *wad_input_stream_new(GInputStream *base_stream);
 WadDirectoryEntry *
 wad_input_stream_read_directory_entry(WadInputStream *stream, GError **error);
 
+GArray *wad_input_stream_read_directory(
+    WadInputStream *stream,
+    guint32 num_dirs,
+    GCancellable *cancellable,
+    GError **error
+);
+
 WadQpicFile *
 wad_input_stream_read_qpic_file(WadInputStream *stream, GError **error);
 
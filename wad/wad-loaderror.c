@@ -1,4 +1,19 @@
 #include "wad-loaderror.h"
 
+#include "wad-private.h"
+
 // clang-format skip
 G_DEFINE_QUARK(wad-load-error-quark, wad_load_error)
+
+// Internal ////////////////////////////////////////////////////////////////////
+
+void wad_set_file_type_error(GError **error, WadFileType file_type)
+{
+    g_set_error(
+        error,
+        WAD_LOAD_ERROR,
+        WAD_LOAD_ERROR_FILE_TYPE,
+        "unknown file type %#hhx",
+        file_type
+    );
+}
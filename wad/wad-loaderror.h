@@ -15,12 +15,14 @@ G_BEGIN_DECLS
  * WadLoadError:
  * @WAD_LOAD_ERROR_MAGIC: Invalid WAD magic number.
  * @WAD_LOAD_ERROR_FILE_TYPE: Invalid file entry type.
+ * @WAD_LOAD_ERROR_TRUNCATED: Data ends before the end of a structure.
  *
  * Error codes for `WAD_LOAD_ERROR`.
  */
 typedef enum {
     WAD_LOAD_ERROR_MAGIC,
     WAD_LOAD_ERROR_FILE_TYPE,
+    WAD_LOAD_ERROR_TRUNCATED,
 } WadLoadError;
 
 GQuark wad_load_error_quark(void);
@@ -1,5 +1,50 @@
 #include "wad-miptexfile.h"
 
+#include "wad-private.h"
+
+// WadAlphaCoverage
+
+G_DEFINE_ENUM_TYPE(
+    WadAlphaCoverage,
+    wad_alpha_coverage,
+    G_DEFINE_ENUM_VALUE(WAD_ALPHA_COVERAGE_OPAQUE, "opaque"),
+    G_DEFINE_ENUM_VALUE(WAD_ALPHA_COVERAGE_TRANSPARENT, "transparent"),
+    G_DEFINE_ENUM_VALUE(WAD_ALPHA_COVERAGE_MIXED, "mixed")
+)
+
+// WadDither
+
+G_DEFINE_ENUM_TYPE(
+    WadDither,
+    wad_dither,
+    G_DEFINE_ENUM_VALUE(WAD_DITHER_NONE, "none"),
+    G_DEFINE_ENUM_VALUE(WAD_DITHER_ORDERED, "ordered"),
+    G_DEFINE_ENUM_VALUE(WAD_DITHER_FLOYD_STEINBERG, "floyd-steinberg")
+)
+
+// WadTextureStats
+
+G_DEFINE_BOXED_TYPE(
+    WadTextureStats,
+    wad_texture_stats,
+    wad_texture_stats_copy,
+    wad_texture_stats_free
+)
+
+WadTextureStats *wad_texture_stats_copy(WadTextureStats const *stats)
+{
+    WadTextureStats *copy = g_new(WadTextureStats, 1);
+    memcpy(copy, stats, sizeof(WadTextureStats));
+    return copy;
+}
+
+void wad_texture_stats_free(WadTextureStats *stats)
+{
+    g_free(stats);
+}
+
+// WadMiptexFile
+
 G_DEFINE_BOXED_TYPE(
     WadMiptexFile,
     wad_miptex_file,
@@ -9,14 +54,32 @@ G_DEFINE_BOXED_TYPE(
 
 WadMiptexFile *wad_miptex_file_copy(WadMiptexFile const *miptex)
 {
-    WadMiptexFile *copy = g_new(WadMiptexFile, 1);
+    WadMiptexFile *copy = g_new0(WadMiptexFile, 1);
     memcpy(copy->texture_name, miptex->texture_name, 16);
     copy->width = miptex->width;
     copy->height = miptex->height;
     for (size_t i = 0; i < 4; ++i) {
-        copy->mip_images[i] = g_array_ref(miptex->mip_images[i]);
+        if (miptex->mip_images[i]) {
+            copy->mip_images[i] = g_array_ref(miptex->mip_images[i]);
+        }
+        if (miptex->mip_bytes[i]) {
+            copy->mip_bytes[i] = g_bytes_ref(miptex->mip_bytes[i]);
+        }
+        if (miptex->alpha_masks[i]) {
+            copy->alpha_masks[i] = g_bytes_ref(miptex->alpha_masks[i]);
+        }
+    }
+    if (miptex->palette) {
+        copy->palette = g_array_ref(miptex->palette);
+    }
+    if (miptex->palette_bytes) {
+        copy->palette_bytes = g_bytes_ref(miptex->palette_bytes);
+    }
+    copy->palette_id = miptex->palette_id;
+    copy->coverage = miptex->coverage;
+    if (miptex->stats) {
+        copy->stats = wad_texture_stats_copy(miptex->stats);
     }
-    copy->palette = g_array_ref(miptex->palette);
     return copy;
 }
 
@@ -26,9 +89,502 @@ void wad_miptex_file_free(WadMiptexFile *miptex)
         if (miptex->mip_images[i]) {
             g_array_unref(miptex->mip_images[i]);
         }
+        if (miptex->mip_bytes[i]) {
+            g_bytes_unref(miptex->mip_bytes[i]);
+        }
+        if (miptex->alpha_masks[i]) {
+            g_bytes_unref(miptex->alpha_masks[i]);
+        }
     }
     if (miptex->palette) {
         g_array_unref(miptex->palette);
     }
+    if (miptex->palette_bytes) {
+        g_bytes_unref(miptex->palette_bytes);
+    }
+    if (miptex->stats) {
+        wad_texture_stats_free(miptex->stats);
+    }
     g_free(miptex);
 }
+
+/**
+ * wad_miptex_file_get_mip_data:
+ * @miptex: A [struct@WadMiptexFile].
+ * @level: The mip level, from 0 to 3.
+ * @size: (out) (optional): Return location for the size of the image in bytes.
+ *
+ * Gets the indexed pixels of a mip level, from either @mip_images or
+ * @mip_bytes.
+ * Returns: (transfer none) (nullable) (array length=size): The pixel data.
+ */
+guchar const *wad_miptex_file_get_mip_data(
+    WadMiptexFile const *miptex,
+    guint level,
+    gsize *size
+)
+{
+    g_return_val_if_fail(miptex != nullptr, nullptr);
+    g_return_val_if_fail(level < 4, nullptr);
+
+    if (miptex->mip_bytes[level]) {
+        return g_bytes_get_data(miptex->mip_bytes[level], size);
+    }
+    GArray const *image = miptex->mip_images[level];
+    if (size) {
+        *size = image ? image->len : 0;
+    }
+    return image ? (guchar const *)image->data : nullptr;
+}
+
+/**
+ * wad_miptex_file_get_palette_data:
+ * @miptex: A [struct@WadMiptexFile].
+ * @n_colors: (out) (optional): Return location for the number of colors.
+ *
+ * Gets the color palette, from either @palette or @palette_bytes.
+ * Returns: (transfer none) (nullable) (array length=n_colors): The palette.
+ */
+WadRgb const *
+wad_miptex_file_get_palette_data(WadMiptexFile const *miptex, gsize *n_colors)
+{
+    g_return_val_if_fail(miptex != nullptr, nullptr);
+
+    if (miptex->palette_bytes) {
+        gsize size = 0;
+        gconstpointer data = g_bytes_get_data(miptex->palette_bytes, &size);
+        if (n_colors) {
+            *n_colors = size / sizeof(WadRgb);
+        }
+        return data;
+    }
+    GArray const *palette = miptex->palette;
+    if (n_colors) {
+        *n_colors = palette ? palette->len : 0;
+    }
+    return palette ? (WadRgb const *)palette->data : nullptr;
+}
+
+/**
+ * wad_miptex_file_is_transparent:
+ * @miptex: A [struct@WadMiptexFile].
+ * @level: The mip level, from 0 to 3.
+ * @x: Column of the pixel.
+ * @y: Row of the pixel.
+ *
+ * Checks whether a pixel is drawn as transparent.
+ *
+ * Returns: Whether the pixel is transparent.
+ */
+gboolean wad_miptex_file_is_transparent(
+    WadMiptexFile const *miptex,
+    guint level,
+    guint32 x,
+    guint32 y
+)
+{
+    g_return_val_if_fail(miptex != nullptr, FALSE);
+    g_return_val_if_fail(level < 4, FALSE);
+
+    switch (miptex->coverage) {
+    case WAD_ALPHA_COVERAGE_OPAQUE:
+        return FALSE;
+    case WAD_ALPHA_COVERAGE_TRANSPARENT:
+        return TRUE;
+    case WAD_ALPHA_COVERAGE_MIXED:
+        break;
+    }
+    guint32 width = miptex->width >> level;
+    g_return_val_if_fail(x < width && y < (miptex->height >> level), FALSE);
+    gsize size = 0;
+    guchar const *mask = g_bytes_get_data(miptex->alpha_masks[level], &size);
+    gsize i = (gsize)y * width + x;
+    return i / 8 < size && (mask[i / 8] >> (i % 8)) & 1;
+}
+
+/**
+ * wad_miptex_file_to_rgba:
+ * @miptex: A [struct@WadMiptexFile].
+ * @level: The mip level, from 0 to 3.
+ * @gamma: (nullable): Color correction to apply, or `NULL` for none.
+ * @dest: (array): Buffer to write 8-bit RGBA pixels to. Must hold `height`
+ * rows of `dest_stride` bytes, where `height` is the height of the mip level.
+ * @dest_stride: Distance between rows of @dest in bytes. Must be at least four
+ * times the width of the mip level.
+ *
+ * Converts a mip level to RGBA using the texture's palette.
+ *
+ * Mip level `n` is `width >> n` by `height >> n` pixels. Transparent pixels
+ * (see wad_miptex_file_is_transparent()) are written as transparent black; all
+ * others are fully opaque.
+ */
+void wad_miptex_file_to_rgba(
+    WadMiptexFile const *miptex,
+    guint level,
+    WadGammaTable const *gamma,
+    guchar *dest,
+    gsize dest_stride
+)
+{
+    g_return_if_fail(miptex != nullptr);
+    g_return_if_fail(level < 4);
+    g_return_if_fail(dest != nullptr);
+
+    guint32 width = miptex->width >> level;
+    guint32 height = miptex->height >> level;
+    g_return_if_fail(dest_stride >= (gsize)width * 4);
+
+    gsize n_colors = 0;
+    WadRgb const *palette = wad_miptex_file_get_palette_data(miptex, &n_colors);
+    gsize size = 0;
+    guchar const *data = wad_miptex_file_get_mip_data(miptex, level, &size);
+    WadPaletteLut lut;
+    wad_palette_lut_init(&lut, palette, n_colors, gamma);
+    if (miptex->texture_name[0] == '{') {
+        wad_palette_lut_set_transparent(&lut, WAD_MIPTEX_TRANSPARENT_INDEX);
+    }
+    wad_palette_lut_expand(&lut, data, size, width, height, dest, dest_stride);
+}
+
+/**
+ * wad_miptex_file_new_from_rgba:
+ * @texture_name: Name of the texture. Only the first 15 bytes are kept.
+ * @width: Width of the image, in pixels. Must be a multiple of 16.
+ * @height: Height of the image, in pixels. Must be a multiple of 16.
+ * @pixels: (array): 8-bit RGBA pixels, `height` rows of `stride` bytes.
+ * @stride: Distance between rows of @pixels in bytes.
+ * @dither: How to dither the image.
+ * @error: The return location for [struct@GError].
+ *
+ * Creates a texture from a truecolor image, choosing a palette of up to 256
+ * colors for it. Images with no more than 256 colors are converted exactly.
+ * Mip levels 1 to 3 are generated as by wad_miptex_file_generate_mips().
+ *
+ * If @texture_name starts with `{`, pixels with alpha below 128 become
+ * %WAD_MIPTEX_TRANSPARENT_INDEX and the image gets at most 255 colors of its
+ * own. Otherwise alpha is ignored.
+ *
+ * Returns: (transfer full): A new [struct@WadMiptexFile], or `NULL` if the
+ * dimensions are invalid.
+ */
+WadMiptexFile *wad_miptex_file_new_from_rgba(
+    char const *texture_name,
+    guint32 width,
+    guint32 height,
+    guchar const *pixels,
+    gsize stride,
+    WadDither dither,
+    GError **error
+)
+{
+    g_return_val_if_fail(texture_name != nullptr, nullptr);
+    g_return_val_if_fail(pixels != nullptr, nullptr);
+    g_return_val_if_fail(stride >= (gsize)width * 4, nullptr);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, nullptr);
+
+    if (width == 0 || height == 0 || width % 16 != 0 || height % 16 != 0) {
+        g_set_error(
+            error,
+            G_IO_ERROR,
+            G_IO_ERROR_INVALID_ARGUMENT,
+            "Texture size %" G_GUINT32_FORMAT "x%" G_GUINT32_FORMAT
+            " is not a multiple of 16",
+            width,
+            height
+        );
+        return nullptr;
+    }
+
+    WadMiptexFile *miptex = g_new0(WadMiptexFile, 1);
+    g_strlcpy(miptex->texture_name, texture_name, 16);
+    miptex->width = width;
+    miptex->height = height;
+    miptex->mip_images[0] = g_array_sized_new(FALSE, FALSE, 1, width * height);
+    g_array_set_size(miptex->mip_images[0], width * height);
+    miptex->palette = g_array_sized_new(FALSE, FALSE, sizeof(WadRgb), 256);
+    g_array_set_size(miptex->palette, 256);
+    wad_quantize(
+        pixels,
+        width,
+        height,
+        stride,
+        texture_name[0] == '{',
+        dither,
+        (guchar *)miptex->mip_images[0]->data,
+        (WadRgb *)miptex->palette->data
+    );
+    wad_miptex_file_generate_mips(miptex);
+    return miptex;
+}
+
+/**
+ * wad_miptex_file_generate_mips:
+ * @miptex: A [struct@WadMiptexFile].
+ *
+ * Rebuilds mip levels 1 to 3 from level 0.
+ *
+ * Each pixel of a smaller level is the average of the level 0 pixels it
+ * covers, computed in linear RGB and mapped back to the nearest color of the
+ * texture's palette. The new levels are stored in @mip_images, replacing any
+ * previous levels in @mip_images or @mip_bytes.
+ *
+ * For textures whose name starts with `{`, %WAD_MIPTEX_TRANSPARENT_INDEX
+ * pixels are left out of the average, and a pixel becomes transparent when
+ * more than half of the pixels it covers are. Opaque pixels are never mapped
+ * to %WAD_MIPTEX_TRANSPARENT_INDEX.
+ */
+void wad_miptex_file_generate_mips(WadMiptexFile *miptex)
+{
+    g_return_if_fail(miptex != nullptr);
+
+    gsize size = 0;
+    guchar const *image = wad_miptex_file_get_mip_data(miptex, 0, &size);
+    g_return_if_fail(size >= (gsize)miptex->width * miptex->height);
+    gsize n_colors = 0;
+    WadRgb const *palette = wad_miptex_file_get_palette_data(miptex, &n_colors);
+    n_colors = MIN(n_colors, 256);
+    bool keyed = miptex->texture_name[0] == '{';
+
+    float linear[256][3] = {};
+    for (gsize i = 0; i < n_colors; ++i) {
+        for (size_t c = 0; c < 3; ++c) {
+            linear[i][c] = wad_srgb_to_linear(palette[i].rgb[c]);
+        }
+    }
+    g_auto(WadNearestColor) nearest = {};
+    wad_nearest_color_init(
+        &nearest,
+        palette,
+        keyed ? MIN(n_colors, WAD_MIPTEX_TRANSPARENT_INDEX) : n_colors
+    );
+
+    GArray *levels[4] = {};
+    for (guint level = 1; level < 4; ++level) {
+        guint32 block = 1u << level;
+        guint32 width = miptex->width >> level;
+        guint32 height = miptex->height >> level;
+        guint32 area = block * block;
+        GArray *mip = g_array_sized_new(FALSE, FALSE, 1, width * height);
+        g_array_set_size(mip, width * height);
+        guchar *out = (guchar *)mip->data;
+
+        for (guint32 y = 0; y < height; ++y) {
+            for (guint32 x = 0; x < width; ++x) {
+                float sum[3] = {};
+                guint32 n_transparent = 0;
+                for (guint32 by = 0; by < block; ++by) {
+                    guchar const *row = image
+                                      + (gsize)(y * block + by) * miptex->width
+                                      + (gsize)x * block;
+                    for (guint32 bx = 0; bx < block; ++bx) {
+                        if (keyed
+                            && row[bx] == WAD_MIPTEX_TRANSPARENT_INDEX) {
+                            n_transparent += 1;
+                            continue;
+                        }
+                        float const *color = linear[row[bx]];
+                        sum[0] += color[0];
+                        sum[1] += color[1];
+                        sum[2] += color[2];
+                    }
+                }
+                if (n_transparent * 2 > area) {
+                    out[(gsize)y * width + x] = WAD_MIPTEX_TRANSPARENT_INDEX;
+                    continue;
+                }
+                float scale = 1.0f / (area - n_transparent);
+                out[(gsize)y * width + x] = wad_nearest_color_lookup(
+                    &nearest,
+                    wad_linear_to_srgb(sum[0] * scale),
+                    wad_linear_to_srgb(sum[1] * scale),
+                    wad_linear_to_srgb(sum[2] * scale)
+                );
+            }
+        }
+        levels[level] = mip;
+    }
+
+    for (guint level = 1; level < 4; ++level) {
+        g_clear_pointer(&miptex->mip_images[level], g_array_unref);
+        g_clear_pointer(&miptex->mip_bytes[level], g_bytes_unref);
+        miptex->mip_images[level] = levels[level];
+    }
+    wad_miptex_file_update_alpha(miptex);
+}
+
+static WadTextureStats *compute_stats(WadMiptexFile const *miptex)
+{
+    gsize size = 0;
+    guchar const *image = wad_miptex_file_get_mip_data(miptex, 0, &size);
+    size = MIN(size, (gsize)miptex->width * miptex->height);
+
+    // Histogram the indices first, so the palette is only consulted once per
+    // color rather than once per pixel. Four interleaved histograms avoid
+    // stalling on runs of the same index.
+    guint32 histogram[4][256] = {};
+    gsize i = 0;
+    for (; i + 4 <= size; i += 4) {
+        histogram[0][image[i + 0]] += 1;
+        histogram[1][image[i + 1]] += 1;
+        histogram[2][image[i + 2]] += 1;
+        histogram[3][image[i + 3]] += 1;
+    }
+    for (; i < size; ++i) {
+        histogram[0][image[i]] += 1;
+    }
+    guint64 counts[256];
+    for (size_t c = 0; c < 256; ++c) {
+        counts[c] = (guint64)histogram[0][c] + histogram[1][c]
+                  + histogram[2][c] + histogram[3][c];
+    }
+    if (miptex->texture_name[0] == '{') {
+        counts[WAD_MIPTEX_TRANSPARENT_INDEX] = 0;
+    }
+
+    gsize n_colors = 0;
+    WadRgb const *palette = wad_miptex_file_get_palette_data(miptex, &n_colors);
+    n_colors = MIN(n_colors, 256);
+    guint64 n_pixels = 0;
+    guint64 srgb_sum[3] = {};
+    gdouble linear_sum[3] = {};
+    for (size_t c = 0; c < 256; ++c) {
+        n_pixels += counts[c];
+        // Indices past the end of the palette count as black.
+        if (c >= n_colors || counts[c] == 0) {
+            continue;
+        }
+        for (size_t k = 0; k < 3; ++k) {
+            guchar value = palette[c].rgb[k];
+            srgb_sum[k] += counts[c] * value;
+            linear_sum[k] += counts[c] * (gdouble)wad_srgb_to_linear(value);
+        }
+    }
+
+    WadTextureStats *stats = g_new0(WadTextureStats, 1);
+    stats->n_pixels = n_pixels;
+    if (n_pixels != 0) {
+        for (size_t k = 0; k < 3; ++k) {
+            stats->average_color.rgb[k]
+                = (srgb_sum[k] + n_pixels / 2) / n_pixels;
+            stats->reflectivity[k] = linear_sum[k] / n_pixels;
+        }
+    }
+    return stats;
+}
+
+/**
+ * wad_miptex_file_get_stats:
+ * @miptex: A [struct@WadMiptexFile].
+ *
+ * Gets the average color and reflectivity of the texture.
+ *
+ * The statistics are computed from a histogram of the palette indices of mip
+ * level 0 on first use, and cached in @stats. Clear @stats after changing the
+ * image or palette to have them recomputed. Safe to call from several threads
+ * at once.
+ *
+ * Returns: (transfer none): The texture's statistics.
+ */
+WadTextureStats const *wad_miptex_file_get_stats(WadMiptexFile *miptex)
+{
+    g_return_val_if_fail(miptex != nullptr, nullptr);
+
+    WadTextureStats *stats = g_atomic_pointer_get(&miptex->stats);
+    if (stats) {
+        return stats;
+    }
+    stats = compute_stats(miptex);
+    bool installed
+        = g_atomic_pointer_compare_and_exchange(&miptex->stats, nullptr, stats);
+    if (!installed) {
+        // Another thread got there first.
+        wad_texture_stats_free(stats);
+        stats = g_atomic_pointer_get(&miptex->stats);
+    }
+    return stats;
+}
+
+static void generate_one(guint index, gpointer user_data)
+{
+    WadMiptexFile **miptexes = user_data;
+    wad_miptex_file_generate_mips(miptexes[index]);
+}
+
+/**
+ * wad_miptex_file_generate_mips_parallel:
+ * @miptexes: (array length=n_miptexes): Textures to update.
+ * @n_miptexes: Number of textures.
+ * @n_threads: Number of threads to use, or 0 to use one per processor.
+ *
+ * Calls wad_miptex_file_generate_mips() on each texture, spreading the
+ * textures across a thread pool.
+ */
+void wad_miptex_file_generate_mips_parallel(
+    WadMiptexFile **miptexes,
+    guint n_miptexes,
+    guint n_threads
+)
+{
+    g_return_if_fail(miptexes != nullptr || n_miptexes == 0);
+
+    wad_parallel_for(n_miptexes, n_threads, generate_one, miptexes);
+}
+
+// Internal ////////////////////////////////////////////////////////////////////
+
+/*
+ * Recomputes @coverage and @alpha_masks from the image data.
+ */
+void wad_miptex_file_update_alpha(WadMiptexFile *miptex)
+{
+    for (size_t i = 0; i < 4; ++i) {
+        g_clear_pointer(&miptex->alpha_masks[i], g_bytes_unref);
+    }
+    miptex->coverage = WAD_ALPHA_COVERAGE_OPAQUE;
+    if (miptex->texture_name[0] != '{') {
+        return;
+    }
+
+    GBytes *masks[4] = {};
+    gsize n_transparent[4] = {};
+    gsize n_pixels[4] = {};
+    for (guint level = 0; level < 4; ++level) {
+        gsize size = 0;
+        guchar const *image
+            = wad_miptex_file_get_mip_data(miptex, level, &size);
+        size = MIN(
+            size,
+            (gsize)(miptex->width >> level) * (miptex->height >> level)
+        );
+        guchar *mask = g_new0(guchar, (size + 7) / 8);
+        for (gsize i = 0; i < size; ++i) {
+            bool transparent = image[i] == WAD_MIPTEX_TRANSPARENT_INDEX;
+            mask[i / 8] |= transparent << (i % 8);
+            n_transparent[level] += transparent;
+        }
+        masks[level] = g_bytes_new_take(mask, (size + 7) / 8);
+        n_pixels[level] = size;
+    }
+
+    bool all_opaque = true;
+    bool all_transparent = true;
+    for (guint level = 0; level < 4; ++level) {
+        all_opaque = all_opaque && n_transparent[level] == 0;
+        all_transparent
+            = all_transparent && n_transparent[level] == n_pixels[level];
+    }
+    if (all_opaque) {
+        miptex->coverage = WAD_ALPHA_COVERAGE_OPAQUE;
+    } else if (all_transparent) {
+        miptex->coverage = WAD_ALPHA_COVERAGE_TRANSPARENT;
+    } else {
+        miptex->coverage = WAD_ALPHA_COVERAGE_MIXED;
+    }
+    for (guint level = 0; level < 4; ++level) {
+        if (miptex->coverage == WAD_ALPHA_COVERAGE_MIXED) {
+            miptex->alpha_masks[level] = masks[level];
+        } else {
+            g_bytes_unref(masks[level]);
+        }
+    }
+}
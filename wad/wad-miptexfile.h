@@ -2,9 +2,86 @@
 
 #include <gio/gio.h>
 #include <glib-object.h>
+#include <wad/wad-gammatable.h>
+#include <wad/wad-rgb.h>
 
 G_BEGIN_DECLS
 
+// WadAlphaCoverage
+
+#define WAD_TYPE_ALPHA_COVERAGE wad_alpha_coverage_get_type()
+
+/**
+ * WadAlphaCoverage:
+ * @WAD_ALPHA_COVERAGE_OPAQUE: No pixel is transparent.
+ * @WAD_ALPHA_COVERAGE_TRANSPARENT: Every pixel is transparent.
+ * @WAD_ALPHA_COVERAGE_MIXED: Some pixels are transparent.
+ *
+ * How much of a texture is see-through.
+ */
+typedef enum {
+    WAD_ALPHA_COVERAGE_OPAQUE,
+    WAD_ALPHA_COVERAGE_TRANSPARENT,
+    WAD_ALPHA_COVERAGE_MIXED,
+} WadAlphaCoverage;
+
+GType wad_alpha_coverage_get_type(void);
+
+// WadDither
+
+#define WAD_TYPE_DITHER wad_dither_get_type()
+
+/**
+ * WadDither:
+ * @WAD_DITHER_NONE: Map each pixel to its nearest palette color.
+ * @WAD_DITHER_ORDERED: Add a 4x4 Bayer pattern before mapping.
+ * @WAD_DITHER_FLOYD_STEINBERG: Spread each pixel's error to its neighbours.
+ *
+ * How to hide banding when reducing an image to a palette.
+ */
+typedef enum {
+    WAD_DITHER_NONE,
+    WAD_DITHER_ORDERED,
+    WAD_DITHER_FLOYD_STEINBERG,
+} WadDither;
+
+GType wad_dither_get_type(void);
+
+// WadTextureStats
+
+#define WAD_TYPE_TEXTURE_STATS wad_texture_stats_get_type()
+
+/**
+ * WadTextureStats:
+ * @average_color: Mean color of the texture.
+ * @reflectivity: (array fixed-size=3): Mean color in linear RGB, from 0 to 1,
+ * as used for light bounces by lighting compilers.
+ * @n_pixels: Number of pixels counted.
+ *
+ * Summary statistics of a texture's full-size image. Transparent pixels are
+ * not counted.
+ */
+typedef struct {
+    WadRgb average_color;
+    gfloat reflectivity[3];
+    guint64 n_pixels;
+} WadTextureStats;
+
+GType wad_texture_stats_get_type(void);
+WadTextureStats *wad_texture_stats_copy(WadTextureStats const *stats);
+void wad_texture_stats_free(WadTextureStats *stats);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(WadTextureStats, wad_texture_stats_free)
+
+// WadMiptexFile
+
+/**
+ * WAD_MIPTEX_TRANSPARENT_INDEX:
+ *
+ * Palette index drawn as transparent in textures whose names start with `{`.
+ */
+#define WAD_MIPTEX_TRANSPARENT_INDEX 255
+
 #define WAD_TYPE_MIPTEX_FILE wad_miptex_file_get_type()
 
 /**
@@ -12,24 +89,96 @@ G_BEGIN_DECLS
  * @texture_name: Name of the texture.
  * @width: Width of the image, in pixels.
  * @height: Height of the image, in pixels.
- * @mip_images: An array of mipmaps. The first is full size (ie. width*height
- * pixels), the second is half size (width/2 * height/2), the third is quarter
- * size, and the fourth is eighth size.
- * @palette: (element-type WadRgb): Image color palette.
+ * @mip_images: (nullable): An array of mipmaps. The first is full size (ie.
+ * width*height pixels), the second is half size (width/2 * height/2), the
+ * third is quarter size, and the fourth is eighth size. Each is `NULL` when
+ * the texture holds the level in @mip_bytes instead.
+ * @palette: (element-type WadRgb) (nullable): Image color palette. `NULL` when
+ * the texture holds it in @palette_bytes instead.
+ * @mip_bytes: (nullable): The mipmaps as read-only views of the WAD image. Set
+ * instead of @mip_images by wad_root_load_from_mapped_file() and
+ * wad_root_load_from_sequential_stream().
+ * @palette_bytes: (nullable): The palette, read-only. Set instead of @palette
+ * once the texture is in a [class@WadTextureArchive], which shares one copy
+ * between all of its textures with the same palette.
+ * @coverage: Transparency of the texture, across all mip levels.
+ * @alpha_masks: (nullable): One bit per pixel for each mip level, set where
+ * the pixel is transparent. Only present for textures with a mix of
+ * transparent and opaque pixels.
+ * @stats: (nullable): Cached result of wad_miptex_file_get_stats().
+ * @palette_id: Identifies the palette among those interned by
+ * [class@WadTextureArchive]; textures with the same non-zero id share one
+ * palette. Zero if the palette was not interned.
  *
  * A mipmapped texture.
+ *
+ * Use wad_miptex_file_get_mip_data() and wad_miptex_file_get_palette_data() to
+ * read the image regardless of how it was loaded.
+ *
+ * Textures whose names start with `{` draw palette index
+ * %WAD_MIPTEX_TRANSPARENT_INDEX as transparent. @coverage and @alpha_masks
+ * are filled in when the texture is decoded, so this does not need to be
+ * checked per pixel; use wad_miptex_file_is_transparent() to test a pixel.
  */
 typedef struct {
     char texture_name[16];
     guint32 width, height;
     GArray *mip_images[4];
     GArray *palette;
+    GBytes *mip_bytes[4];
+    GBytes *palette_bytes;
+    WadAlphaCoverage coverage;
+    GBytes *alpha_masks[4];
+    WadTextureStats *stats;
+    guint palette_id;
 } WadMiptexFile;
 
 GType wad_miptex_file_get_type(void);
 WadMiptexFile *wad_miptex_file_copy(WadMiptexFile const *miptex);
 void wad_miptex_file_free(WadMiptexFile *miptex);
 
+guchar const *wad_miptex_file_get_mip_data(
+    WadMiptexFile const *miptex,
+    guint level,
+    gsize *size
+);
+WadRgb const *
+wad_miptex_file_get_palette_data(WadMiptexFile const *miptex, gsize *n_colors);
+
+gboolean wad_miptex_file_is_transparent(
+    WadMiptexFile const *miptex,
+    guint level,
+    guint32 x,
+    guint32 y
+);
+
+void wad_miptex_file_to_rgba(
+    WadMiptexFile const *miptex,
+    guint level,
+    WadGammaTable const *gamma,
+    guchar *dest,
+    gsize dest_stride
+);
+
+WadTextureStats const *wad_miptex_file_get_stats(WadMiptexFile *miptex);
+
+WadMiptexFile *wad_miptex_file_new_from_rgba(
+    char const *texture_name,
+    guint32 width,
+    guint32 height,
+    guchar const *pixels,
+    gsize stride,
+    WadDither dither,
+    GError **error
+);
+
+void wad_miptex_file_generate_mips(WadMiptexFile *miptex);
+void wad_miptex_file_generate_mips_parallel(
+    WadMiptexFile **miptexes,
+    guint n_miptexes,
+    guint n_threads
+);
+
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(WadMiptexFile, wad_miptex_file_free)
 
 G_END_DECLS
@@ -0,0 +1,180 @@
+/*
+ * Texture names as GoldSrc compares them: case-insensitively, and only up to
+ * the 16 bytes of a directory entry's name field. A name is folded once into a
+ * WadName, after which hashing and comparison work on two 64-bit words.
+ */
+#include "wad-private.h"
+
+// Private /////////////////////////////////////////////////////////////////////
+
+// Slot marker for an empty table entry.
+#define EMPTY 0
+
+static guint32 hash_words(WadName const *name)
+{
+    guint64 h = name->words[0] ^ (name->words[1] * 0x9e3779b97f4a7c15u);
+    h ^= h >> 32;
+    h *= 0xff51afd7ed558ccdu;
+    h ^= h >> 29;
+    return (guint32)h;
+}
+
+// Returns the slot holding `name`, or the empty slot where it would go.
+static guint find_slot(
+    WadNameIndex const *self,
+    WadName const *name,
+    guint32 hash
+)
+{
+    guint mask = self->capacity - 1;
+    guint i = hash & mask;
+    while (self->slots[i].value != EMPTY) {
+        if (self->slots[i].hash == hash
+            && wad_name_equal(&self->slots[i].name, name)) {
+            break;
+        }
+        i = (i + 1) & mask;
+    }
+    return i;
+}
+
+static void resize(WadNameIndex *self, guint capacity)
+{
+    WadNameIndexSlot *old_slots = self->slots;
+    guint old_capacity = self->capacity;
+
+    self->slots = g_new0(WadNameIndexSlot, capacity);
+    self->capacity = capacity;
+    for (guint i = 0; i < old_capacity; ++i) {
+        WadNameIndexSlot const *slot = &old_slots[i];
+        if (slot->value != EMPTY) {
+            self->slots[find_slot(self, &slot->name, slot->hash)] = *slot;
+        }
+    }
+    g_free(old_slots);
+}
+
+// Internal ////////////////////////////////////////////////////////////////////
+
+/*
+ * Folds the first 16 bytes of `str`, or up to its NUL terminator, to lower
+ * case.
+ */
+void wad_name_init(WadName *name, char const *str)
+{
+    char *bytes = (char *)name->words;
+    gsize i = 0;
+    for (; i < 16 && str[i] != '\0'; ++i) {
+        bytes[i] = g_ascii_tolower(str[i]);
+    }
+    memset(bytes + i, 0, 16 - i);
+}
+
+// GHashFunc for WadName keys.
+guint wad_name_hash(gconstpointer name)
+{
+    return hash_words(name);
+}
+
+// GEqualFunc for WadName keys.
+gboolean wad_name_equal_func(gconstpointer a, gconstpointer b)
+{
+    return wad_name_equal(a, b);
+}
+
+void wad_name_index_init(WadNameIndex *self)
+{
+    self->slots = nullptr;
+    self->capacity = 0;
+    self->size = 0;
+}
+
+void wad_name_index_clear(WadNameIndex *self)
+{
+    g_clear_pointer(&self->slots, g_free);
+    self->capacity = 0;
+    self->size = 0;
+}
+
+void wad_name_index_remove_all(WadNameIndex *self)
+{
+    if (self->slots) {
+        memset(self->slots, 0, sizeof(WadNameIndexSlot) * self->capacity);
+    }
+    self->size = 0;
+}
+
+/*
+ * Looks up `name`, storing its value in `value`. Returns whether it was found.
+ */
+bool wad_name_index_lookup(
+    WadNameIndex const *self,
+    WadName const *name,
+    guint *value
+)
+{
+    if (self->size == 0) {
+        return false;
+    }
+    WadNameIndexSlot const *slot
+        = &self->slots[find_slot(self, name, hash_words(name))];
+    if (slot->value == EMPTY) {
+        return false;
+    }
+    if (value) {
+        *value = slot->value - 1;
+    }
+    return true;
+}
+
+/*
+ * Maps `name` to `value`, replacing any existing value.
+ */
+void wad_name_index_insert(
+    WadNameIndex *self,
+    WadName const *name,
+    guint value
+)
+{
+    g_return_if_fail(value < G_MAXUINT);
+
+    // Keep the load factor under 3/4.
+    if ((self->size + 1) * 4 > self->capacity * 3) {
+        resize(self, MAX(self->capacity * 2, 16));
+    }
+    guint32 hash = hash_words(name);
+    WadNameIndexSlot *slot = &self->slots[find_slot(self, name, hash)];
+    if (slot->value == EMPTY) {
+        slot->name = *name;
+        slot->hash = hash;
+        self->size += 1;
+    }
+    slot->value = value + 1;
+}
+
+/*
+ * Removes `name` from the index. Returns whether it was present.
+ */
+bool wad_name_index_remove(WadNameIndex *self, WadName const *name)
+{
+    if (self->size == 0) {
+        return false;
+    }
+    guint mask = self->capacity - 1;
+    guint i = find_slot(self, name, hash_words(name));
+    if (self->slots[i].value == EMPTY) {
+        return false;
+    }
+    // Shift the rest of the probe run back so lookups never stop early.
+    for (guint j = (i + 1) & mask; self->slots[j].value != EMPTY;
+         j = (j + 1) & mask) {
+        guint home = self->slots[j].hash & mask;
+        if (((j - home) & mask) >= ((j - i) & mask)) {
+            self->slots[i] = self->slots[j];
+            i = j;
+        }
+    }
+    self->slots[i] = (WadNameIndexSlot){};
+    self->size -= 1;
+    return true;
+}
@@ -0,0 +1,887 @@
+/*
+ * https://twhl.info/wiki/page/Specification:_WAD3 has more info on the format.
+ */
+#include "wad-outputstream.h"
+
+#include "wad-loaderror.h"
+#include "wad-private.h"
+
+#include <gio/gio.h>
+
+/**
+ * WadOutputStream:
+ *
+ * An output stream with functions for writing WAD structs to a binary output
+ * stream.
+ *
+ * Each texture is written with a single vectored write, straight from its
+ * image and palette buffers, so pixel data is never copied on the way out.
+ */
+struct _WadOutputStream {
+    GDataOutputStream parent_instance;
+};
+
+G_DEFINE_FINAL_TYPE(
+    WadOutputStream,
+    wad_output_stream,
+    G_TYPE_DATA_OUTPUT_STREAM
+)
+
+// Private /////////////////////////////////////////////////////////////////////
+
+/* Size of the WAD header: magic, number of entries and directory offset. */
+#define HEADER_SIZE 12
+
+/* Entries are padded to a multiple of this, as the original tools do. */
+#define ENTRY_ALIGNMENT 4
+
+static guchar const zeros[ENTRY_ALIGNMENT];
+
+/*
+ * A texture broken into the pieces to be written, in order. Small fields are
+ * packed into `header` and `trailer`; image data is referenced in place.
+ * Must not be moved once filled in, as `vectors` may point into itself.
+ */
+typedef struct {
+    guchar header[40];
+    guchar trailer[2];
+    GOutputVector vectors[8];
+    guint n_vectors;
+    gsize size;
+} Payload;
+
+static void put_uint32(guchar *dest, guint32 value)
+{
+    value = GUINT32_TO_LE(value);
+    memcpy(dest, &value, 4);
+}
+
+static void payload_add(Payload *payload, gconstpointer data, gsize size)
+{
+    if (size == 0) {
+        return;
+    }
+    g_assert(payload->n_vectors < G_N_ELEMENTS(payload->vectors));
+    payload->vectors[payload->n_vectors++] = (GOutputVector){data, size};
+    payload->size += size;
+}
+
+static bool check_size(
+    char const *what,
+    gsize size,
+    gsize expected,
+    GError **error
+)
+{
+    if (size == expected) {
+        return true;
+    }
+    g_set_error(
+        error,
+        G_IO_ERROR,
+        G_IO_ERROR_INVALID_DATA,
+        "%s is %" G_GSIZE_FORMAT " bytes, expected %" G_GSIZE_FORMAT,
+        what,
+        size,
+        expected
+    );
+    return false;
+}
+
+// Adds the palette and padding that end every texture.
+static bool payload_add_palette(
+    Payload *payload,
+    WadRgb const *palette,
+    gsize n_colors,
+    GError **error
+)
+{
+    if (n_colors > G_MAXUINT16) {
+        g_set_error(
+            error,
+            G_IO_ERROR,
+            G_IO_ERROR_INVALID_DATA,
+            "Palette has too many colors (%" G_GSIZE_FORMAT ")",
+            n_colors
+        );
+        return false;
+    }
+    guint16 count = GUINT16_TO_LE((guint16)n_colors);
+    memcpy(payload->trailer, &count, 2);
+    payload_add(payload, payload->trailer, 2);
+    payload_add(payload, palette, n_colors * sizeof(WadRgb));
+    gsize remainder = payload->size % ENTRY_ALIGNMENT;
+    if (remainder != 0) {
+        payload_add(payload, zeros, ENTRY_ALIGNMENT - remainder);
+    }
+    return true;
+}
+
+static bool
+payload_init_qpic(Payload *payload, WadQpicFile const *qpic, GError **error)
+{
+    gsize size = 0;
+    guchar const *data = wad_qpic_file_get_data(qpic, &size);
+    if (!check_size(
+            "Image data",
+            size,
+            (gsize)qpic->width * qpic->height,
+            error
+        )) {
+        return false;
+    }
+    put_uint32(payload->header + 0, qpic->width);
+    put_uint32(payload->header + 4, qpic->height);
+    payload_add(payload, payload->header, 8);
+    payload_add(payload, data, size);
+
+    gsize n_colors = 0;
+    WadRgb const *palette = wad_qpic_file_get_palette_data(qpic, &n_colors);
+    return payload_add_palette(payload, palette, n_colors, error);
+}
+
+static bool payload_init_miptex(
+    Payload *payload,
+    WadMiptexFile const *miptex,
+    GError **error
+)
+{
+    memcpy(payload->header, miptex->texture_name, 16);
+    put_uint32(payload->header + 16, miptex->width);
+    put_uint32(payload->header + 20, miptex->height);
+    payload_add(payload, payload->header, 40);
+
+    // Mip offsets are from the start of the miptex.
+    for (guint i = 0; i < 4; ++i) {
+        gsize size = 0;
+        guchar const *data = wad_miptex_file_get_mip_data(miptex, i, &size);
+        gsize expected
+            = (gsize)(miptex->width >> i) * (gsize)(miptex->height >> i);
+        if (!check_size("Mip level data", size, expected, error)) {
+            return false;
+        }
+        put_uint32(payload->header + 24 + i * 4, payload->size);
+        payload_add(payload, data, size);
+    }
+
+    gsize n_colors = 0;
+    WadRgb const *palette
+        = wad_miptex_file_get_palette_data(miptex, &n_colors);
+    return payload_add_palette(payload, palette, n_colors, error);
+}
+
+static bool
+payload_init_font(Payload *payload, WadFontFile const *font, GError **error)
+{
+    if (!font->font_info) {
+        g_set_error_literal(
+            error,
+            G_IO_ERROR,
+            G_IO_ERROR_INVALID_DATA,
+            "Font has no glyph table"
+        );
+        return false;
+    }
+    if (!check_size(
+            "Glyph table",
+            font->font_info->len * sizeof(WadCharInfo),
+            256 * sizeof(WadCharInfo),
+            error
+        )) {
+        return false;
+    }
+    gsize size = 0;
+    guchar const *data = wad_font_file_get_data(font, &size);
+    if (!check_size("Image data", size, (gsize)font->height * 256, error)) {
+        return false;
+    }
+    put_uint32(payload->header + 0, 256);
+    put_uint32(payload->header + 4, font->height);
+    put_uint32(payload->header + 8, font->row_count);
+    put_uint32(payload->header + 12, font->row_height);
+    payload_add(payload, payload->header, 16);
+    payload_add(payload, font->font_info->data, 256 * sizeof(WadCharInfo));
+    payload_add(payload, data, size);
+
+    gsize n_colors = 0;
+    WadRgb const *palette = wad_font_file_get_palette_data(font, &n_colors);
+    return payload_add_palette(payload, palette, n_colors, error);
+}
+
+static bool
+payload_init(Payload *payload, WadTexture const *texture, GError **error)
+{
+    if (texture->type == WAD_TYPE_MIPTEX_FILE) {
+        return payload_init_miptex(payload, texture->boxed, error);
+    }
+    if (texture->type == WAD_TYPE_QPIC_FILE) {
+        return payload_init_qpic(payload, texture->boxed, error);
+    }
+    if (texture->type == WAD_TYPE_FONT_FILE) {
+        return payload_init_font(payload, texture->boxed, error);
+    }
+    g_set_error(
+        error,
+        G_IO_ERROR,
+        G_IO_ERROR_INVALID_DATA,
+        "Cannot write textures of type %s",
+        g_type_name(texture->type)
+    );
+    return false;
+}
+
+static bool write_payload(
+    WadOutputStream *self,
+    Payload const *payload,
+    GCancellable *cancellable,
+    GError **error
+)
+{
+    // Go straight to the base stream, which may support real vectored writes.
+    GOutputStream *base
+        = g_filter_output_stream_get_base_stream(G_FILTER_OUTPUT_STREAM(self));
+    return g_output_stream_writev_all(
+        base,
+        (GOutputVector *)payload->vectors,
+        payload->n_vectors,
+        nullptr,
+        cancellable,
+        error
+    );
+}
+
+/* Size of the buffer entries are copied through by write_subset. */
+#define COPY_CHUNK_SIZE 65536
+
+/*
+ * Gets the name shared by every frame of an animated (`+N`) or random (`-N`)
+ * texture: the sign followed by the name without its frame character.
+ * Returns false for other names.
+ */
+static bool get_family_name(char const *name, WadName *family)
+{
+    if ((name[0] != '+' && name[0] != '-') || name[1] == '\0') {
+        return false;
+    }
+    char buffer[16] = {name[0]};
+    strncpy(buffer + 1, name + 2, 14);
+    wad_name_init(family, buffer);
+    return true;
+}
+
+/*
+ * A WAD opened as a source for wad_output_stream_write_subset().
+ */
+typedef struct {
+    WadInputStream *stream;
+    GArray *directory; // GArray<WadDirectoryEntry>
+} SubsetSource;
+
+/*
+ * Where an entry of the subset comes from.
+ */
+typedef struct {
+    guint source;
+    guint32 offset;
+} SubsetOrigin;
+
+/*
+ * State for wad_output_stream_write_subset().
+ */
+typedef struct {
+    WadNameIndex wanted;   // Requested names, to their index
+    WadNameIndex families; // Family names of requested `+`/`-` textures
+    WadNameIndex chosen;   // Names already in the subset
+    SubsetSource *sources;
+    guint n_sources;
+    GArray *origins;   // GArray<SubsetOrigin>, parallel to `directory`
+    GArray *directory; // GArray<WadDirectoryEntry>
+} Subset;
+
+static void subset_init(Subset *subset, guint n_sources)
+{
+    wad_name_index_init(&subset->wanted);
+    wad_name_index_init(&subset->families);
+    wad_name_index_init(&subset->chosen);
+    subset->sources = g_new0(SubsetSource, n_sources);
+    subset->n_sources = n_sources;
+    subset->origins = g_array_new(FALSE, FALSE, sizeof(SubsetOrigin));
+    subset->directory = g_array_new(FALSE, FALSE, sizeof(WadDirectoryEntry));
+}
+
+static void subset_clear(Subset *subset)
+{
+    wad_name_index_clear(&subset->wanted);
+    wad_name_index_clear(&subset->families);
+    wad_name_index_clear(&subset->chosen);
+    for (guint i = 0; i < subset->n_sources; ++i) {
+        g_clear_object(&subset->sources[i].stream);
+        g_clear_pointer(&subset->sources[i].directory, g_array_unref);
+    }
+    g_clear_pointer(&subset->sources, g_free);
+    g_clear_pointer(&subset->origins, g_array_unref);
+    g_clear_pointer(&subset->directory, g_array_unref);
+}
+
+G_DEFINE_AUTO_CLEANUP_CLEAR_FUNC(Subset, subset_clear)
+
+static bool subset_source_open(
+    SubsetSource *source,
+    GFile *file,
+    GCancellable *cancellable,
+    GError **error
+)
+{
+    g_autoptr(GFileInputStream) file_stream = g_file_read(
+        file,
+        cancellable,
+        error
+    );
+    if (!file_stream) {
+        return false;
+    }
+    source->stream = wad_input_stream_new(G_INPUT_STREAM(file_stream));
+
+    guint32 num_dirs = 0;
+    guint32 dir_offset = 0;
+    GError *e = nullptr;
+    wad_input_stream_read_header(
+        source->stream,
+        &num_dirs,
+        &dir_offset,
+        cancellable,
+        &e
+    );
+    if (e) {
+        g_propagate_error(error, e);
+        return false;
+    }
+    g_seekable_seek(
+        G_SEEKABLE(source->stream),
+        dir_offset,
+        G_SEEK_SET,
+        cancellable,
+        &e
+    );
+    if (e) {
+        g_propagate_error(error, e);
+        return false;
+    }
+    source->directory = wad_input_stream_read_directory(
+        source->stream,
+        num_dirs,
+        cancellable,
+        error
+    );
+    return source->directory != nullptr;
+}
+
+/*
+ * Adds the entries of source `index` which are wanted and not yet chosen,
+ * laying them out from `*offset`.
+ */
+static bool subset_add_source(
+    Subset *subset,
+    guint index,
+    bool *found,
+    guint64 *offset,
+    GError **error
+)
+{
+    GArray *directory = subset->sources[index].directory;
+    for (guint i = 0; i < directory->len; ++i) {
+        WadDirectoryEntry entry
+            = g_array_index(directory, WadDirectoryEntry, i);
+        char name[17] = {};
+        memcpy(name, entry.texture_name, 16);
+        WadName key;
+        WadName family;
+        guint wanted;
+        wad_name_init(&key, name);
+        if (wad_name_index_lookup(&subset->chosen, &key, nullptr)) {
+            continue;
+        }
+        if (wad_name_index_lookup(&subset->wanted, &key, &wanted)) {
+            found[wanted] = true;
+        } else if (!get_family_name(name, &family)
+                   || !wad_name_index_lookup(
+                       &subset->families,
+                       &family,
+                       nullptr
+                   )) {
+            continue;
+        }
+        wad_name_index_insert(&subset->chosen, &key, subset->directory->len);
+
+        SubsetOrigin origin = {index, entry.entry_offset};
+        g_array_append_val(subset->origins, origin);
+        entry.entry_offset = *offset;
+        g_array_append_val(subset->directory, entry);
+        *offset += entry.disk_size;
+        *offset += (ENTRY_ALIGNMENT - *offset % ENTRY_ALIGNMENT)
+            % ENTRY_ALIGNMENT;
+        if (*offset > G_MAXUINT32) {
+            g_set_error_literal(
+                error,
+                G_IO_ERROR,
+                G_IO_ERROR_INVALID_DATA,
+                "Archive is too large for the WAD format"
+            );
+            return false;
+        }
+    }
+    return true;
+}
+
+/*
+ * Copies `size` bytes at `offset` in `source` to `self` unchanged, through
+ * `buffer` of COPY_CHUNK_SIZE bytes.
+ */
+static bool copy_entry(
+    WadOutputStream *self,
+    GInputStream *source,
+    guint32 offset,
+    guint32 size,
+    guchar *buffer,
+    GCancellable *cancellable,
+    GError **error
+)
+{
+    GError *e = nullptr;
+    g_seekable_seek(G_SEEKABLE(source), offset, G_SEEK_SET, cancellable, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return false;
+    }
+    while (size > 0) {
+        gsize chunk = MIN(size, COPY_CHUNK_SIZE);
+        gsize bytes_read = 0;
+        if (!g_input_stream_read_all(
+                source,
+                buffer,
+                chunk,
+                &bytes_read,
+                cancellable,
+                error
+            )) {
+            return false;
+        }
+        if (bytes_read != chunk) {
+            g_set_error_literal(
+                error,
+                WAD_LOAD_ERROR,
+                WAD_LOAD_ERROR_TRUNCATED,
+                "Entry data truncated"
+            );
+            return false;
+        }
+        if (!g_output_stream_write_all(
+                G_OUTPUT_STREAM(self),
+                buffer,
+                chunk,
+                nullptr,
+                cancellable,
+                error
+            )) {
+            return false;
+        }
+        size -= chunk;
+    }
+    return true;
+}
+
+// GObject /////////////////////////////////////////////////////////////////////
+
+static void wad_output_stream_constructed(GObject *object)
+{
+    g_object_set(
+        object,
+        "byte-order",
+        G_DATA_STREAM_BYTE_ORDER_LITTLE_ENDIAN,
+        nullptr
+    );
+    G_OBJECT_CLASS(wad_output_stream_parent_class)->constructed(object);
+}
+
+// WadOutputStream /////////////////////////////////////////////////////////////
+
+static void wad_output_stream_class_init(WadOutputStreamClass *klass)
+{
+    GObjectClass *oclass = G_OBJECT_CLASS(klass);
+    oclass->constructed = wad_output_stream_constructed;
+}
+
+static void wad_output_stream_init(WadOutputStream *)
+{
+}
+
+// Public //////////////////////////////////////////////////////////////////////
+
+/**
+ * wad_output_stream_new:
+ * @base_stream: A [class@Gio.OutputStream].
+ *
+ * Creates a new wad output stream for the @base_stream.
+ *
+ * Returns: A new [class@WadOutputStream].
+ */
+WadOutputStream *wad_output_stream_new(GOutputStream *base_stream)
+{
+    return g_object_new(
+        WAD_TYPE_OUTPUT_STREAM,
+        "base-stream",
+        base_stream,
+        nullptr
+    );
+}
+
+/**
+ * wad_output_stream_write_directory:
+ * @stream: A [class@WadOutputStream].
+ * @directory: (element-type WadDirectoryEntry): The entries to write.
+ * @error: The return location for [struct@GError].
+ *
+ * Writes a whole WAD directory to `stream` with a single write.
+ * Returns: Whether the directory was written.
+ */
+gboolean wad_output_stream_write_directory(
+    WadOutputStream *self,
+    GArray *directory,
+    GError **error
+)
+{
+    g_return_val_if_fail(WAD_IS_OUTPUT_STREAM(self), FALSE);
+    g_return_val_if_fail(directory != nullptr, FALSE);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
+
+    gsize size = (gsize)directory->len * WAD_DIRECTORY_ENTRY_SIZE;
+    g_autofree guchar *buffer = g_malloc(size);
+    wad_directory_entry_encode(
+        (WadDirectoryEntry const *)directory->data,
+        directory->len,
+        buffer
+    );
+    return g_output_stream_write_all(
+        G_OUTPUT_STREAM(self),
+        buffer,
+        size,
+        nullptr,
+        nullptr,
+        error
+    );
+}
+
+/**
+ * wad_output_stream_write_qpic_file:
+ * @stream: A [class@WadOutputStream].
+ * @qpic: The image to write.
+ * @error: The return location for [struct@GError].
+ *
+ * Writes a [struct@WadQpicFile] to `stream`, padded to a multiple of 4 bytes.
+ * Returns: Whether the image was written.
+ */
+gboolean wad_output_stream_write_qpic_file(
+    WadOutputStream *self,
+    WadQpicFile const *qpic,
+    GError **error
+)
+{
+    g_return_val_if_fail(WAD_IS_OUTPUT_STREAM(self), FALSE);
+    g_return_val_if_fail(qpic != nullptr, FALSE);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
+
+    Payload payload = {};
+    return payload_init_qpic(&payload, qpic, error)
+        && write_payload(self, &payload, nullptr, error);
+}
+
+/**
+ * wad_output_stream_write_miptex_file:
+ * @stream: A [class@WadOutputStream].
+ * @miptex: The texture to write.
+ * @error: The return location for [struct@GError].
+ *
+ * Writes a [struct@WadMiptexFile] to `stream`, padded to a multiple of 4
+ * bytes. All four mip levels must be present.
+ * Returns: Whether the texture was written.
+ */
+gboolean wad_output_stream_write_miptex_file(
+    WadOutputStream *self,
+    WadMiptexFile const *miptex,
+    GError **error
+)
+{
+    g_return_val_if_fail(WAD_IS_OUTPUT_STREAM(self), FALSE);
+    g_return_val_if_fail(miptex != nullptr, FALSE);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
+
+    Payload payload = {};
+    return payload_init_miptex(&payload, miptex, error)
+        && write_payload(self, &payload, nullptr, error);
+}
+
+/**
+ * wad_output_stream_write_font_file:
+ * @stream: A [class@WadOutputStream].
+ * @font: The font to write.
+ * @error: The return location for [struct@GError].
+ *
+ * Writes a [struct@WadFontFile] to `stream`, padded to a multiple of 4 bytes.
+ * Returns: Whether the font was written.
+ */
+gboolean wad_output_stream_write_font_file(
+    WadOutputStream *self,
+    WadFontFile const *font,
+    GError **error
+)
+{
+    g_return_val_if_fail(WAD_IS_OUTPUT_STREAM(self), FALSE);
+    g_return_val_if_fail(font != nullptr, FALSE);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
+
+    Payload payload = {};
+    return payload_init_font(&payload, font, error)
+        && write_payload(self, &payload, nullptr, error);
+}
+
+/**
+ * wad_output_stream_write_archive:
+ * @stream: A [class@WadOutputStream].
+ * @archive: The archive to write.
+ * @cancellable: (nullable): A [class@Gio.Cancellable].
+ * @error: The return location for [struct@GError].
+ *
+ * Writes `archive` as a complete WAD3 file, in a single forward pass: the
+ * header, then every texture in the order they were added, then the
+ * directory. Entry sizes are worked out before anything is written, so the
+ * stream does not need to be seekable.
+ *
+ * Textures of a lazily-loaded archive are decoded as they are reached.
+ * Returns: Whether the archive was written.
+ */
+gboolean wad_output_stream_write_archive(
+    WadOutputStream *self,
+    WadTextureArchive *archive,
+    GCancellable *cancellable,
+    GError **error
+)
+{
+    g_return_val_if_fail(WAD_IS_OUTPUT_STREAM(self), FALSE);
+    g_return_val_if_fail(WAD_IS_TEXTURE_ARCHIVE(archive), FALSE);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
+
+    g_autofree char const **names = wad_texture_archive_get_names(archive);
+    // Copies of the textures, so that both passes see the same data even if
+    // the archive changes in between.
+    g_autoptr(GArray) textures = g_array_new(FALSE, FALSE, sizeof(WadTexture));
+    g_array_set_clear_func(textures, (GDestroyNotify)wad_texture_clear);
+    g_autoptr(GArray) directory
+        = g_array_new(FALSE, TRUE, sizeof(WadDirectoryEntry));
+    guint64 offset = HEADER_SIZE;
+    GError *e = nullptr;
+
+    for (char const **name = names; *name; ++name) {
+        WadTexture texture = {};
+        WadDirectoryEntry entry = {};
+        if (!wad_texture_archive_dup_texture(
+                archive,
+                *name,
+                &texture,
+                &entry.file_type
+            )) {
+            // Failed to decode and already reported, or removed meanwhile.
+            continue;
+        }
+        g_array_append_val(textures, texture);
+        Payload payload = {};
+        if (!payload_init(&payload, &texture, &e)) {
+            g_propagate_prefixed_error(error, e, "Texture '%s': ", *name);
+            return FALSE;
+        }
+        entry.entry_offset = offset;
+        entry.disk_size = payload.size;
+        entry.entry_size = payload.size;
+        strncpy(entry.texture_name, *name, sizeof(entry.texture_name));
+        offset += payload.size;
+        if (offset > G_MAXUINT32) {
+            g_set_error_literal(
+                error,
+                G_IO_ERROR,
+                G_IO_ERROR_INVALID_DATA,
+                "Archive is too large for the WAD format"
+            );
+            return FALSE;
+        }
+        g_array_append_val(directory, entry);
+    }
+
+    guchar header[HEADER_SIZE];
+    memcpy(header, "WAD3", 4);
+    put_uint32(header + 4, directory->len);
+    put_uint32(header + 8, offset);
+    g_output_stream_write_all(
+        G_OUTPUT_STREAM(self),
+        header,
+        sizeof(header),
+        nullptr,
+        cancellable,
+        &e
+    );
+    if (e) {
+        g_propagate_error(error, e);
+        return FALSE;
+    }
+    for (guint i = 0; i < textures->len; ++i) {
+        Payload payload = {};
+        if (!payload_init(
+                &payload,
+                &g_array_index(textures, WadTexture, i),
+                &e
+            )
+            || !write_payload(self, &payload, cancellable, &e)) {
+            g_propagate_error(error, e);
+            return FALSE;
+        }
+    }
+    return wad_output_stream_write_directory(self, directory, error);
+}
+
+/**
+ * wad_output_stream_write_subset:
+ * @stream: A [class@WadOutputStream].
+ * @sources: (array length=n_sources): The WAD files to take textures from, in
+ * order of priority.
+ * @n_sources: Number of files in @sources.
+ * @texture_names: (array zero-terminated=1): The textures to include, such as
+ * those returned by `rmf_root_get_texture_names()`.
+ * @missing: (out) (optional) (transfer full) (array zero-terminated=1):
+ * Return location for the names in @texture_names which no source provides.
+ * @cancellable: (nullable): A [class@Gio.Cancellable].
+ * @error: The return location for [struct@GError].
+ *
+ * Writes a WAD3 file holding only the named textures, for shipping with a map.
+ * Each name is taken from the first source which has it. Every frame of an
+ * animated (`+0name`) or random (`-0name`) texture is included along with the
+ * named one, as the engine loads them together.
+ *
+ * Entries are copied byte-for-byte from the sources rather than decoded, and
+ * are written in a single forward pass, as in
+ * [method@WadOutputStream.write_archive]. The sources must be seekable.
+ * Returns: Whether the file was written.
+ */
+gboolean wad_output_stream_write_subset(
+    WadOutputStream *self,
+    GFile *const *sources,
+    guint n_sources,
+    char const *const *texture_names,
+    char ***missing,
+    GCancellable *cancellable,
+    GError **error
+)
+{
+    g_return_val_if_fail(WAD_IS_OUTPUT_STREAM(self), FALSE);
+    g_return_val_if_fail(sources != nullptr || n_sources == 0, FALSE);
+    g_return_val_if_fail(texture_names != nullptr, FALSE);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
+
+    g_auto(Subset) subset;
+    subset_init(&subset, n_sources);
+    guint n_names = g_strv_length((char **)texture_names);
+    g_autofree bool *found = g_new0(bool, n_names);
+    for (guint i = 0; i < n_names; ++i) {
+        WadName key;
+        wad_name_init(&key, texture_names[i]);
+        if (!wad_name_index_lookup(&subset.wanted, &key, nullptr)) {
+            wad_name_index_insert(&subset.wanted, &key, i);
+        }
+        if (get_family_name(texture_names[i], &key)) {
+            wad_name_index_insert(&subset.families, &key, i);
+        }
+    }
+
+    guint64 offset = HEADER_SIZE;
+    GError *e = nullptr;
+    for (guint i = 0; i < n_sources; ++i) {
+        if (!subset_source_open(
+                &subset.sources[i],
+                sources[i],
+                cancellable,
+                &e
+            )) {
+            g_autofree char *name = g_file_get_parse_name(sources[i]);
+            g_propagate_prefixed_error(error, e, "%s: ", name);
+            return FALSE;
+        }
+        if (!subset_add_source(&subset, i, found, &offset, error)) {
+            return FALSE;
+        }
+    }
+
+    guchar header[HEADER_SIZE];
+    memcpy(header, "WAD3", 4);
+    put_uint32(header + 4, subset.directory->len);
+    put_uint32(header + 8, offset);
+    if (!g_output_stream_write_all(
+            G_OUTPUT_STREAM(self),
+            header,
+            sizeof(header),
+            nullptr,
+            cancellable,
+            error
+        )) {
+        return FALSE;
+    }
+    g_autofree guchar *buffer = g_malloc(COPY_CHUNK_SIZE);
+    for (guint i = 0; i < subset.directory->len; ++i) {
+        WadDirectoryEntry const *entry
+            = &g_array_index(subset.directory, WadDirectoryEntry, i);
+        SubsetOrigin const *origin
+            = &g_array_index(subset.origins, SubsetOrigin, i);
+        gsize padding = (ENTRY_ALIGNMENT - entry->disk_size % ENTRY_ALIGNMENT)
+            % ENTRY_ALIGNMENT;
+        if (!copy_entry(
+                self,
+                G_INPUT_STREAM(subset.sources[origin->source].stream),
+                origin->offset,
+                entry->disk_size,
+                buffer,
+                cancellable,
+                &e
+            )
+            || !g_output_stream_write_all(
+                G_OUTPUT_STREAM(self),
+                zeros,
+                padding,
+                nullptr,
+                cancellable,
+                &e
+            )) {
+            g_propagate_prefixed_error(
+                error,
+                e,
+                "Texture '%.16s': ",
+                entry->texture_name
+            );
+            return FALSE;
+        }
+    }
+    if (!wad_output_stream_write_directory(self, subset.directory, error)) {
+        return FALSE;
+    }
+
+    if (missing) {
+        GPtrArray *names = g_ptr_array_new();
+        for (guint i = 0; i < n_names; ++i) {
+            WadName key;
+            guint index = 0;
+            wad_name_init(&key, texture_names[i]);
+            wad_name_index_lookup(&subset.wanted, &key, &index);
+            if (!found[index]) {
+                g_ptr_array_add(names, g_strdup(texture_names[i]));
+            }
+        }
+        g_ptr_array_add(names, nullptr);
+        *missing = (char **)g_ptr_array_free(names, FALSE);
+    }
+    return TRUE;
+}
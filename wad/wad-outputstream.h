@@ -0,0 +1,66 @@
+#pragma once
+
+#include "wad/wad-fontfile.h"
+#include "wad/wad-miptexfile.h"
+#include "wad/wad-qpicfile.h"
+#include "wad/wad-texturearchive.h"
+
+#include <gio/gio.h>
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define WAD_TYPE_OUTPUT_STREAM wad_output_stream_get_type()
+
+G_DECLARE_FINAL_TYPE(
+    WadOutputStream,
+    wad_output_stream,
+    WAD,
+    OUTPUT_STREAM,
+    GDataOutputStream
+)
+
+WadOutputStream *wad_output_stream_new(GOutputStream *base_stream);
+
+gboolean wad_output_stream_write_directory(
+    WadOutputStream *stream,
+    GArray *directory,
+    GError **error
+);
+
+gboolean wad_output_stream_write_qpic_file(
+    WadOutputStream *stream,
+    WadQpicFile const *qpic,
+    GError **error
+);
+
+gboolean wad_output_stream_write_miptex_file(
+    WadOutputStream *stream,
+    WadMiptexFile const *miptex,
+    GError **error
+);
+
+gboolean wad_output_stream_write_font_file(
+    WadOutputStream *stream,
+    WadFontFile const *font,
+    GError **error
+);
+
+gboolean wad_output_stream_write_archive(
+    WadOutputStream *stream,
+    WadTextureArchive *archive,
+    GCancellable *cancellable,
+    GError **error
+);
+
+gboolean wad_output_stream_write_subset(
+    WadOutputStream *stream,
+    GFile *const *sources,
+    guint n_sources,
+    char const *const *texture_names,
+    char ***missing,
+    GCancellable *cancellable,
+    GError **error
+);
+
+G_END_DECLS
@@ -0,0 +1,139 @@
+/*
+ * Palette interning. Large WADs often repeat a handful of palettes across
+ * hundreds of textures; a pool hands out one shared, read-only copy of each
+ * distinct palette along with an id, so the copies can be dropped and
+ * conversion code can build one lookup table per id. Each palette is counted
+ * by its users and dropped along with the last of them.
+ */
+#include "wad-private.h"
+
+// Private /////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    gconstpointer data; // Owned by bytes
+    gsize size;
+    guint hash;
+    guint id;
+    guint n_users;
+    GBytes *bytes;
+} Interned;
+
+static gint next_id; // Atomic
+
+static guint hash_data(gconstpointer data, gsize size)
+{
+    // FNV-1a
+    guchar const *p = data;
+    guint32 hash = 2166136261u;
+    for (gsize i = 0; i < size; ++i) {
+        hash = (hash ^ p[i]) * 16777619u;
+    }
+    return hash;
+}
+
+static guint interned_hash(gconstpointer key)
+{
+    return ((Interned const *)key)->hash;
+}
+
+static gboolean interned_equal(gconstpointer a, gconstpointer b)
+{
+    Interned const *x = a;
+    Interned const *y = b;
+    return x->hash == y->hash && x->size == y->size
+        && memcmp(x->data, y->data, x->size) == 0;
+}
+
+static void interned_free(Interned *interned)
+{
+    g_bytes_unref(interned->bytes);
+    g_free(interned);
+}
+
+// Internal ////////////////////////////////////////////////////////////////////
+
+void wad_palette_pool_init(WadPalettePool *pool)
+{
+    pool->palettes = g_hash_table_new_full(
+        interned_hash,
+        interned_equal,
+        (GDestroyNotify)interned_free,
+        nullptr
+    );
+    pool->by_id = g_hash_table_new(nullptr, nullptr);
+}
+
+void wad_palette_pool_clear(WadPalettePool *pool)
+{
+    g_clear_pointer(&pool->by_id, g_hash_table_unref);
+    g_clear_pointer(&pool->palettes, g_hash_table_unref);
+}
+
+/*
+ * Replaces the palette in `*palette` or `*palette_bytes`, whichever is set,
+ * with the pool's read-only copy of an identical palette, and returns its id.
+ * A palette in `*palette` is moved to `*palette_bytes`, leaving `*palette`
+ * NULL, so that no texture can change a palette other textures share.
+ *
+ * Ids are unique within the process, so textures with the same id have the
+ * same palette. Each call takes a use of the palette, to be given back with
+ * wad_palette_pool_release(). Returns 0 if neither is set.
+ */
+guint wad_palette_pool_intern(
+    WadPalettePool *pool,
+    GArray **palette,
+    GBytes **palette_bytes
+)
+{
+    Interned probe = {};
+    if (*palette_bytes) {
+        probe.data = g_bytes_get_data(*palette_bytes, &probe.size);
+    } else if (*palette) {
+        probe.data = (*palette)->data;
+        probe.size = (gsize)(*palette)->len * sizeof(WadRgb);
+    } else {
+        return 0;
+    }
+    probe.hash = hash_data(probe.data, probe.size);
+
+    Interned *interned = g_hash_table_lookup(pool->palettes, &probe);
+    if (!interned) {
+        interned = g_new0(Interned, 1);
+        *interned = probe;
+        interned->id = (guint)g_atomic_int_add(&next_id, 1) + 1;
+        interned->bytes = *palette_bytes
+                            ? g_bytes_ref(*palette_bytes)
+                            : g_bytes_new(probe.data, probe.size);
+        interned->data = g_bytes_get_data(interned->bytes, nullptr);
+        g_hash_table_add(pool->palettes, interned);
+        g_hash_table_insert(
+            pool->by_id,
+            GUINT_TO_POINTER(interned->id),
+            interned
+        );
+    }
+    interned->n_users += 1;
+
+    g_clear_pointer(palette, g_array_unref);
+    if (*palette_bytes != interned->bytes) {
+        g_clear_pointer(palette_bytes, g_bytes_unref);
+        *palette_bytes = g_bytes_ref(interned->bytes);
+    }
+    return interned->id;
+}
+
+/*
+ * Gives back a use of the palette `id` taken by wad_palette_pool_intern(),
+ * dropping the palette from the pool if it was the last. Ids the pool did not
+ * hand out, including 0, are ignored.
+ */
+void wad_palette_pool_release(WadPalettePool *pool, guint id)
+{
+    Interned *interned
+        = g_hash_table_lookup(pool->by_id, GUINT_TO_POINTER(id));
+    if (!interned || --interned->n_users > 0) {
+        return;
+    }
+    g_hash_table_remove(pool->by_id, GUINT_TO_POINTER(id));
+    g_hash_table_remove(pool->palettes, interned);
+}
@@ -0,0 +1,69 @@
+/*
+ * A minimal parallel-for over a GThreadPool, for batch operations on many
+ * independent textures.
+ */
+#include "wad-private.h"
+
+// Private /////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    WadParallelFunc func;
+    gpointer user_data;
+    guint n;
+    gint next; // Next index to claim, atomic
+} ParallelJob;
+
+static void parallel_worker(gpointer data, gpointer)
+{
+    ParallelJob *job = data;
+    for (;;) {
+        guint i = (guint)g_atomic_int_add(&job->next, 1);
+        if (i >= job->n) {
+            break;
+        }
+        job->func(i, job->user_data);
+    }
+}
+
+// Internal ////////////////////////////////////////////////////////////////////
+
+/*
+ * Calls `func` once for each index below `n`, on up to `n_threads` threads,
+ * and waits for every call to finish. `n_threads` of 0 means one thread per
+ * processor. Falls back to the calling thread if a pool cannot be created.
+ */
+void wad_parallel_for(
+    guint n,
+    guint n_threads,
+    WadParallelFunc func,
+    gpointer user_data
+)
+{
+    ParallelJob job = {
+        .func = func,
+        .user_data = user_data,
+        .n = n,
+    };
+    if (n_threads == 0) {
+        n_threads = g_get_num_processors();
+    }
+    n_threads = MIN(n_threads, MAX(n, 1));
+    GThreadPool *pool = nullptr;
+    if (n_threads > 1) {
+        pool = g_thread_pool_new(
+            parallel_worker,
+            nullptr,
+            n_threads,
+            FALSE,
+            nullptr
+        );
+    }
+    if (!pool) {
+        parallel_worker(&job, nullptr);
+        return;
+    }
+    for (guint i = 0; i < n_threads; ++i) {
+        g_thread_pool_push(pool, &job, nullptr);
+    }
+    g_thread_pool_free(pool, FALSE, TRUE);
+}
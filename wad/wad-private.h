@@ -0,0 +1,326 @@
+#pragma once
+
+#include "wad/wad-directoryentry.h"
+#include "wad/wad-fontfile.h"
+#include "wad/wad-gammatable.h"
+#include "wad/wad-inputstream.h"
+#include "wad/wad-miptexfile.h"
+#include "wad/wad-qpicfile.h"
+#include "wad/wad-texturearchive.h"
+
+#include <glib.h>
+
+G_BEGIN_DECLS
+
+// wad-loaderror
+void wad_set_file_type_error(GError **error, WadFileType file_type);
+
+// wad-directoryentry
+bool wad_file_type_is_valid(WadFileType file_type);
+
+/* Size of a directory entry in the file. */
+#define WAD_DIRECTORY_ENTRY_SIZE 32
+
+void wad_directory_entry_decode(
+    guchar const *restrict data,
+    guint32 n_entries,
+    WadDirectoryEntry *restrict entries
+);
+void wad_directory_entry_encode(
+    WadDirectoryEntry const *restrict entries,
+    guint32 n_entries,
+    guchar *restrict data
+);
+
+// wad-miptexfile
+void wad_miptex_file_update_alpha(WadMiptexFile *miptex);
+
+// wad-name
+
+/*
+ * WadName:
+ * @words: The name, folded to lower case and zero-padded to 16 bytes.
+ *
+ * A texture name in canonical form.
+ */
+typedef struct {
+    guint64 words[2];
+} WadName;
+
+void wad_name_init(WadName *name, char const *str);
+guint wad_name_hash(gconstpointer name);
+gboolean wad_name_equal_func(gconstpointer a, gconstpointer b);
+
+static inline bool wad_name_equal(WadName const *a, WadName const *b)
+{
+    return ((a->words[0] ^ b->words[0]) | (a->words[1] ^ b->words[1])) == 0;
+}
+
+typedef struct {
+    WadName name;
+    guint32 hash;
+    guint value; // Plus one; zero marks an empty slot
+} WadNameIndexSlot;
+
+/*
+ * WadNameIndex:
+ *
+ * An open-addressed hash table from WadName to an index, with the names stored
+ * inline.
+ */
+typedef struct {
+    WadNameIndexSlot *slots;
+    guint capacity; // Zero or a power of two
+    guint size;
+} WadNameIndex;
+
+void wad_name_index_init(WadNameIndex *index);
+void wad_name_index_clear(WadNameIndex *index);
+void wad_name_index_remove_all(WadNameIndex *index);
+bool wad_name_index_lookup(
+    WadNameIndex const *index,
+    WadName const *name,
+    guint *value
+);
+void
+wad_name_index_insert(WadNameIndex *index, WadName const *name, guint value);
+bool wad_name_index_remove(WadNameIndex *index, WadName const *name);
+
+// wad-texturearchive
+
+/*
+ * WadTexture:
+ * @type: The boxed type of @boxed.
+ * @boxed: (nullable): The texture.
+ *
+ * A texture tagged with its type.
+ */
+typedef struct {
+    GType type;
+    gpointer boxed;
+} WadTexture;
+
+void wad_texture_clear(WadTexture *texture);
+
+G_DEFINE_AUTO_CLEANUP_CLEAR_FUNC(WadTexture, wad_texture_clear)
+
+bool wad_texture_archive_dup_texture(
+    WadTextureArchive *archive,
+    char const *texture_name,
+    WadTexture *texture,
+    WadFileType *file_type
+);
+void wad_texture_archive_take_texture(
+    WadTextureArchive *archive,
+    char const *texture_name,
+    WadTexture *texture
+);
+void wad_texture_archive_take_entry(
+    WadTextureArchive *archive,
+    WadDirectoryEntry const *entry,
+    WadTexture *texture
+);
+void wad_texture_archive_set_pending(
+    WadTextureArchive *archive,
+    GArray *directory,
+    WadInputStream *stream,
+    GBytes *bytes
+);
+
+// wad-rgbacache
+GBytes *wad_texture_expand_rgba(
+    WadTexture const *texture,
+    guint *width,
+    guint *height
+);
+
+// wad-inputstream
+void wad_input_stream_read_header(
+    WadInputStream *stream,
+    guint32 *num_dirs,
+    guint32 *dir_offset,
+    GCancellable *cancellable,
+    GError **error
+);
+WadTexture wad_input_stream_read_entry(
+    WadInputStream *stream,
+    WadDirectoryEntry const *entry,
+    GError **error
+);
+
+// wad-palette
+
+/*
+ * WadPalettePool:
+ * @palettes: The distinct palettes, each counting the textures that use it.
+ * @by_id: The same palettes, keyed by id.
+ *
+ * A set of distinct palettes, for sharing one copy between textures.
+ */
+typedef struct {
+    GHashTable *palettes;
+    GHashTable *by_id;
+} WadPalettePool;
+
+void wad_palette_pool_init(WadPalettePool *pool);
+void wad_palette_pool_clear(WadPalettePool *pool);
+guint wad_palette_pool_intern(
+    WadPalettePool *pool,
+    GArray **palette,
+    GBytes **palette_bytes
+);
+void wad_palette_pool_release(WadPalettePool *pool, guint id);
+
+// wad-quantize
+void wad_quantize(
+    guchar const *rgba,
+    guint32 width,
+    guint32 height,
+    gsize stride,
+    bool transparent,
+    WadDither dither,
+    guchar *indices,
+    WadRgb *palette
+);
+
+// wad-hash
+guint64 wad_hash_bytes(guint64 seed, gconstpointer data, gsize size);
+
+// wad-parallel
+typedef void (*WadParallelFunc)(guint index, gpointer user_data);
+
+void wad_parallel_for(
+    guint n,
+    guint n_threads,
+    WadParallelFunc func,
+    gpointer user_data
+);
+
+// wad-rgba
+
+/*
+ * WadPaletteLut:
+ * @rgba: Each palette entry packed in memory order R, G, B, A.
+ * @channel: The same entries, with one table per channel.
+ *
+ * A palette expanded to all 256 indices, for use by wad_palette_lut_expand().
+ */
+typedef struct {
+    guint32 rgba[256];
+    guchar channel[4][256];
+} WadPaletteLut;
+
+void wad_palette_lut_init(
+    WadPaletteLut *lut,
+    WadRgb const *palette,
+    gsize n_colors,
+    WadGammaTable const *gamma
+);
+void wad_palette_lut_set_transparent(WadPaletteLut *lut, guchar index);
+void wad_palette_lut_expand(
+    WadPaletteLut const *restrict lut,
+    guchar const *restrict src,
+    gsize src_size,
+    guint32 width,
+    guint32 height,
+    guchar *restrict dest,
+    gsize dest_stride
+);
+void wad_palette_lut_expand_scaled(
+    WadPaletteLut const *restrict lut,
+    guchar const *restrict src,
+    gsize src_size,
+    guint32 width,
+    guint32 height,
+    guint scale,
+    guchar *restrict dest,
+    gsize dest_stride
+);
+
+// wad-colormap
+float wad_srgb_to_linear(guchar value);
+guchar wad_linear_to_srgb(float value);
+
+/*
+ * WadNearestColor:
+ *
+ * Maps RGB colors to the closest entry of a palette, with a cache.
+ */
+typedef struct {
+    gint16 r[256], g[256], b[256];
+    guint16 *cache;
+} WadNearestColor;
+
+void wad_nearest_color_init(
+    WadNearestColor *nearest,
+    WadRgb const *palette,
+    gsize n_colors
+);
+void wad_nearest_color_clear(WadNearestColor *nearest);
+
+G_DEFINE_AUTO_CLEANUP_CLEAR_FUNC(WadNearestColor, wad_nearest_color_clear)
+
+guchar wad_nearest_color_lookup(
+    WadNearestColor *nearest,
+    guchar r,
+    guchar g,
+    guchar b
+);
+
+// wad-bytereader
+
+/*
+ * WadByteReader:
+ * @bytes: The data being read.
+ * @data: Start of @bytes.
+ * @size: Size of @bytes.
+ * @offset: Current read position.
+ *
+ * A cursor over an in-memory WAD image. Image and palette data are returned as
+ * slices of @bytes rather than being copied.
+ */
+typedef struct {
+    GBytes *bytes;
+    guchar const *data;
+    gsize size;
+    gsize offset;
+} WadByteReader;
+
+void wad_byte_reader_init(WadByteReader *reader, GBytes *bytes);
+void wad_byte_reader_clear(WadByteReader *reader);
+
+G_DEFINE_AUTO_CLEANUP_CLEAR_FUNC(WadByteReader, wad_byte_reader_clear)
+
+void wad_byte_reader_seek(WadByteReader *reader, gsize offset, GError **error);
+
+void wad_byte_reader_read(
+    WadByteReader *restrict reader,
+    void *restrict dest,
+    gsize n,
+    GError **error
+);
+guchar wad_byte_reader_read_byte(WadByteReader *reader, GError **error);
+guint16 wad_byte_reader_read_uint16(WadByteReader *reader, GError **error);
+guint32 wad_byte_reader_read_uint32(WadByteReader *reader, GError **error);
+GBytes *
+wad_byte_reader_read_bytes(WadByteReader *reader, gsize n, GError **error);
+
+void wad_byte_reader_read_directory(
+    WadByteReader *restrict reader,
+    guint32 n_entries,
+    WadDirectoryEntry *restrict entries,
+    GError **error
+);
+WadQpicFile *
+wad_byte_reader_read_qpic_file(WadByteReader *reader, GError **error);
+WadMiptexFile *
+wad_byte_reader_read_miptex_file(WadByteReader *reader, GError **error);
+WadFontFile *
+wad_byte_reader_read_font_file(WadByteReader *reader, GError **error);
+WadTexture wad_byte_reader_read_entry(
+    WadByteReader *reader,
+    WadDirectoryEntry const *entry,
+    GError **error
+);
+
+G_END_DECLS
@@ -1,5 +1,7 @@
 #include "wad-qpicfile.h"
 
+#include "wad-private.h"
+
 #include <gio/gio.h>
 
 G_DEFINE_BOXED_TYPE(
@@ -11,11 +13,22 @@ G_DEFINE_BOXED_TYPE(
 
 WadQpicFile *wad_qpic_file_copy(WadQpicFile const *qpic)
 {
-    WadQpicFile *copy = g_new(WadQpicFile, 1);
+    WadQpicFile *copy = g_new0(WadQpicFile, 1);
     copy->width = qpic->width;
     copy->height = qpic->height;
-    copy->data = g_array_ref(qpic->data);
-    copy->palette = g_array_ref(qpic->palette);
+    if (qpic->data) {
+        copy->data = g_array_ref(qpic->data);
+    }
+    if (qpic->palette) {
+        copy->palette = g_array_ref(qpic->palette);
+    }
+    if (qpic->data_bytes) {
+        copy->data_bytes = g_bytes_ref(qpic->data_bytes);
+    }
+    if (qpic->palette_bytes) {
+        copy->palette_bytes = g_bytes_ref(qpic->palette_bytes);
+    }
+    copy->palette_id = qpic->palette_id;
     return copy;
 }
 
@@ -27,5 +40,142 @@ void wad_qpic_file_free(WadQpicFile *qpic)
     if (qpic->palette) {
         g_array_unref(qpic->palette);
     }
+    if (qpic->data_bytes) {
+        g_bytes_unref(qpic->data_bytes);
+    }
+    if (qpic->palette_bytes) {
+        g_bytes_unref(qpic->palette_bytes);
+    }
     g_free(qpic);
 }
+
+/**
+ * wad_qpic_file_get_data:
+ * @qpic: A [struct@WadQpicFile].
+ * @size: (out) (optional): Return location for the size of the image in bytes.
+ *
+ * Gets the indexed pixels, from either @data or @data_bytes.
+ * Returns: (transfer none) (nullable) (array length=size): The pixel data.
+ */
+guchar const *wad_qpic_file_get_data(WadQpicFile const *qpic, gsize *size)
+{
+    g_return_val_if_fail(qpic != nullptr, nullptr);
+
+    if (qpic->data_bytes) {
+        return g_bytes_get_data(qpic->data_bytes, size);
+    }
+    if (size) {
+        *size = qpic->data ? qpic->data->len : 0;
+    }
+    return qpic->data ? (guchar const *)qpic->data->data : nullptr;
+}
+
+/**
+ * wad_qpic_file_get_palette_data:
+ * @qpic: A [struct@WadQpicFile].
+ * @n_colors: (out) (optional): Return location for the number of colors.
+ *
+ * Gets the color palette, from either @palette or @palette_bytes.
+ * Returns: (transfer none) (nullable) (array length=n_colors): The palette.
+ */
+WadRgb const *
+wad_qpic_file_get_palette_data(WadQpicFile const *qpic, gsize *n_colors)
+{
+    g_return_val_if_fail(qpic != nullptr, nullptr);
+
+    if (qpic->palette_bytes) {
+        gsize size = 0;
+        gconstpointer data = g_bytes_get_data(qpic->palette_bytes, &size);
+        if (n_colors) {
+            *n_colors = size / sizeof(WadRgb);
+        }
+        return data;
+    }
+    if (n_colors) {
+        *n_colors = qpic->palette ? qpic->palette->len : 0;
+    }
+    return qpic->palette ? (WadRgb const *)qpic->palette->data : nullptr;
+}
+
+/**
+ * wad_qpic_file_to_rgba:
+ * @qpic: A [struct@WadQpicFile].
+ * @gamma: (nullable): Color correction to apply, or `NULL` for none.
+ * @dest: (array): Buffer to write 8-bit RGBA pixels to. Must hold `height`
+ * rows of `dest_stride` bytes.
+ * @dest_stride: Distance between rows of @dest in bytes. Must be at least
+ * `width * 4`.
+ *
+ * Converts the image to RGBA using its palette. Every pixel is fully opaque.
+ */
+void wad_qpic_file_to_rgba(
+    WadQpicFile const *qpic,
+    WadGammaTable const *gamma,
+    guchar *dest,
+    gsize dest_stride
+)
+{
+    g_return_if_fail(qpic != nullptr);
+    g_return_if_fail(dest != nullptr);
+    g_return_if_fail(dest_stride >= (gsize)qpic->width * 4);
+
+    gsize n_colors = 0;
+    WadRgb const *palette = wad_qpic_file_get_palette_data(qpic, &n_colors);
+    gsize size = 0;
+    guchar const *data = wad_qpic_file_get_data(qpic, &size);
+    WadPaletteLut lut;
+    wad_palette_lut_init(&lut, palette, n_colors, gamma);
+    wad_palette_lut_expand(
+        &lut,
+        data,
+        size,
+        qpic->width,
+        qpic->height,
+        dest,
+        dest_stride
+    );
+}
+
+/**
+ * wad_qpic_file_to_rgba_scaled:
+ * @qpic: A [struct@WadQpicFile].
+ * @gamma: (nullable): Color correction to apply, or `NULL` for none.
+ * @scale: How many times to enlarge the image in each direction, from 1.
+ * @dest: (array): Buffer to write 8-bit RGBA pixels to. Must hold
+ * `height * scale` rows of `dest_stride` bytes.
+ * @dest_stride: Distance between rows of @dest in bytes. Must be at least
+ * `width * scale * 4`.
+ *
+ * Converts the image to RGBA as wad_qpic_file_to_rgba() does, enlarging it
+ * with nearest-neighbour sampling in the same pass.
+ */
+void wad_qpic_file_to_rgba_scaled(
+    WadQpicFile const *qpic,
+    WadGammaTable const *gamma,
+    guint scale,
+    guchar *dest,
+    gsize dest_stride
+)
+{
+    g_return_if_fail(qpic != nullptr);
+    g_return_if_fail(scale >= 1);
+    g_return_if_fail(dest != nullptr);
+    g_return_if_fail(dest_stride >= (gsize)qpic->width * scale * 4);
+
+    gsize n_colors = 0;
+    WadRgb const *palette = wad_qpic_file_get_palette_data(qpic, &n_colors);
+    gsize size = 0;
+    guchar const *data = wad_qpic_file_get_data(qpic, &size);
+    WadPaletteLut lut;
+    wad_palette_lut_init(&lut, palette, n_colors, gamma);
+    wad_palette_lut_expand_scaled(
+        &lut,
+        data,
+        size,
+        qpic->width,
+        qpic->height,
+        scale,
+        dest,
+        dest_stride
+    );
+}
@@ -2,6 +2,7 @@
 
 #include <gio/gio.h>
 #include <glib-object.h>
+#include <wad/wad-gammatable.h>
 #include <wad/wad-rgb.h>
 
 G_BEGIN_DECLS
@@ -12,22 +13,57 @@ G_BEGIN_DECLS
  * WadQpicFile:
  * @width: Width of the image, in pixels.
  * @height: Height of the image, in pixels.
- * @data: (element-type guchar): Pixel data in indexed format. Must have `width
- * * height` elements.
- * @palette: (element-type WadRgb): Image color palette.
+ * @data: (element-type guchar) (nullable): Pixel data in indexed format. Must
+ * have `width * height` elements. `NULL` when the image holds it in
+ * @data_bytes instead.
+ * @palette: (element-type WadRgb) (nullable): Image color palette. `NULL` when
+ * the image holds it in @palette_bytes instead.
+ * @data_bytes: (nullable): The pixel data as a read-only view of the WAD
+ * image. Set instead of @data by wad_root_load_from_mapped_file() and
+ * wad_root_load_from_sequential_stream().
+ * @palette_bytes: (nullable): The palette, read-only. Set instead of @palette
+ * once the texture is in a [class@WadTextureArchive], which shares one copy
+ * between all of its textures with the same palette.
+ * @palette_id: Identifies the palette among those interned by
+ * [class@WadTextureArchive]; textures with the same non-zero id share one
+ * palette. Zero if the palette was not interned.
  *
  * A simple image.
+ *
+ * Use wad_qpic_file_get_data() and wad_qpic_file_get_palette_data() to read
+ * the image regardless of how it was loaded.
  */
 typedef struct {
     guint32 width, height;
     GArray *data;
     GArray *palette;
+    GBytes *data_bytes;
+    GBytes *palette_bytes;
+    guint palette_id;
 } WadQpicFile;
 
 GType wad_qpic_file_get_type(void);
 WadQpicFile *wad_qpic_file_copy(WadQpicFile const *qpic);
 void wad_qpic_file_free(WadQpicFile *qpic);
 
+guchar const *wad_qpic_file_get_data(WadQpicFile const *qpic, gsize *size);
+WadRgb const *
+wad_qpic_file_get_palette_data(WadQpicFile const *qpic, gsize *n_colors);
+
+void wad_qpic_file_to_rgba(
+    WadQpicFile const *qpic,
+    WadGammaTable const *gamma,
+    guchar *dest,
+    gsize dest_stride
+);
+void wad_qpic_file_to_rgba_scaled(
+    WadQpicFile const *qpic,
+    WadGammaTable const *gamma,
+    guint scale,
+    guchar *dest,
+    gsize dest_stride
+);
+
 G_DEFINE_AUTOPTR_CLEANUP_FUNC(WadQpicFile, wad_qpic_file_free)
 
 G_END_DECLS
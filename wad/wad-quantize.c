@@ -0,0 +1,465 @@
+/*
+ * Color quantization of RGBA images to 8-bit indexed images, for importing
+ * truecolor art as miptex textures.
+ *
+ * Colors are first counted into a 32x32x32 histogram, while also collecting
+ * the image's distinct colors for as long as there are few enough of them to
+ * fit in the palette. If there are, the palette is exactly those colors.
+ * Otherwise the palette is found by median cut
+ * over the histogram cells, splitting at each step the box with the most
+ * pixels times its widest extent, and each pixel is mapped to its nearest
+ * palette color, optionally with dithering.
+ */
+#include "wad-private.h"
+
+// Private /////////////////////////////////////////////////////////////////////
+
+#define N_CELLS (32 * 32 * 32)
+
+/* Slots in a ColorSet; a power of two, comfortably above 256 colors. */
+#define COLOR_SET_SIZE 1024
+
+/* Marks a ColorSet slot as used, so that black can be told from empty. */
+#define COLOR_USED 0x1000000
+
+/* Color given to the transparent index, as in the original tools. */
+static WadRgb const TRANSPARENT_COLOR = {{0, 0, 255}};
+
+typedef struct {
+    guint32 count;
+    guint64 sum[3];
+} Cell;
+
+// The distinct colors of an image, as 0xRRGGBB, until there are too many.
+typedef struct {
+    guint32 slots[COLOR_SET_SIZE]; // Color | COLOR_USED, or 0
+    guchar index[COLOR_SET_SIZE];  // Palette index of each color
+    guint n_colors;
+    bool overflow;
+} ColorSet;
+
+typedef struct {
+    guint start, end; // Range of Histogram.keys
+    guint64 count;
+    guchar lo[3], hi[3];
+} Box;
+
+typedef struct {
+    Cell *cells;
+    guint16 *keys; // Non-empty cells
+    guint n_keys;
+    ColorSet *colors;
+} Histogram;
+
+static inline guint cell_key(guchar r, guchar g, guchar b)
+{
+    return ((guint)(r >> 3) << 10) | ((guint)(g >> 3) << 5) | (b >> 3);
+}
+
+static inline guchar key_channel(guint key, guint channel)
+{
+    return (key >> (10 - 5 * channel)) & 31;
+}
+
+static inline guint32 pixel_color(guchar const *p)
+{
+    return (guint32)p[0] << 16 | (guint32)p[1] << 8 | p[2];
+}
+
+// Finds the slot holding `color`, or the empty slot where it would go.
+static guint color_set_find(ColorSet const *set, guint32 color)
+{
+    guint32 value = color | COLOR_USED;
+    guint i = (color * 2654435761u) >> 22;
+    while (set->slots[i] != 0 && set->slots[i] != value) {
+        i = (i + 1) & (COLOR_SET_SIZE - 1);
+    }
+    return i;
+}
+
+static void color_set_add(ColorSet *set, guint32 color, guint max_colors)
+{
+    guint i = color_set_find(set, color);
+    if (set->slots[i] != 0) {
+        return;
+    }
+    if (set->n_colors == max_colors) {
+        set->overflow = true;
+        return;
+    }
+    set->slots[i] = color | COLOR_USED;
+    set->index[i] = set->n_colors++;
+}
+
+static inline bool is_transparent(guchar const *pixel, bool transparent)
+{
+    return transparent && pixel[3] < 128;
+}
+
+static void histogram_init(
+    Histogram *hist,
+    guchar const *rgba,
+    guint32 width,
+    guint32 height,
+    gsize stride,
+    bool transparent,
+    guint max_colors
+)
+{
+    hist->cells = g_new0(Cell, N_CELLS);
+    hist->keys = g_new(guint16, N_CELLS);
+    hist->n_keys = 0;
+    hist->colors = g_new0(ColorSet, 1);
+    guint32 last_color = G_MAXUINT32;
+    for (guint32 y = 0; y < height; ++y) {
+        guchar const *row = rgba + y * stride;
+        for (guint32 x = 0; x < width; ++x) {
+            guchar const *p = row + x * 4;
+            if (is_transparent(p, transparent)) {
+                continue;
+            }
+            guint key = cell_key(p[0], p[1], p[2]);
+            Cell *cell = &hist->cells[key];
+            if (cell->count == 0) {
+                hist->keys[hist->n_keys++] = key;
+            }
+            cell->count += 1;
+            cell->sum[0] += p[0];
+            cell->sum[1] += p[1];
+            cell->sum[2] += p[2];
+            guint32 color = pixel_color(p);
+            if (color != last_color && !hist->colors->overflow) {
+                color_set_add(hist->colors, color, max_colors);
+                last_color = color;
+            }
+        }
+    }
+}
+
+static void histogram_clear(Histogram *hist)
+{
+    g_clear_pointer(&hist->cells, g_free);
+    g_clear_pointer(&hist->keys, g_free);
+    g_clear_pointer(&hist->colors, g_free);
+}
+
+static void box_shrink(Box *box, Histogram const *hist)
+{
+    box->count = 0;
+    for (guint c = 0; c < 3; ++c) {
+        box->lo[c] = 31;
+        box->hi[c] = 0;
+    }
+    for (guint i = box->start; i < box->end; ++i) {
+        guint key = hist->keys[i];
+        box->count += hist->cells[key].count;
+        for (guint c = 0; c < 3; ++c) {
+            guchar v = key_channel(key, c);
+            box->lo[c] = MIN(box->lo[c], v);
+            box->hi[c] = MAX(box->hi[c], v);
+        }
+    }
+}
+
+static guint box_longest_axis(Box const *box)
+{
+    guint axis = 0;
+    for (guint c = 1; c < 3; ++c) {
+        if (box->hi[c] - box->lo[c] > box->hi[axis] - box->lo[axis]) {
+            axis = c;
+        }
+    }
+    return axis;
+}
+
+// Splits `box` at the median of its longest axis, filling in `other`.
+static void box_split(Box *box, Box *other, Histogram *hist)
+{
+    guint axis = box_longest_axis(box);
+    guint64 counts[32] = {};
+    for (guint i = box->start; i < box->end; ++i) {
+        guint key = hist->keys[i];
+        counts[key_channel(key, axis)] += hist->cells[key].count;
+    }
+    // Both halves must be non-empty, so the split is below hi.
+    guint split = box->lo[axis];
+    guint64 below = counts[split];
+    while (split + 1 < box->hi[axis] && below * 2 < box->count) {
+        split += 1;
+        below += counts[split];
+    }
+
+    guint mid = box->start;
+    for (guint i = box->start; i < box->end; ++i) {
+        guint16 key = hist->keys[i];
+        if (key_channel(key, axis) <= split) {
+            hist->keys[i] = hist->keys[mid];
+            hist->keys[mid] = key;
+            mid += 1;
+        }
+    }
+    other->start = mid;
+    other->end = box->end;
+    box->end = mid;
+    box_shrink(box, hist);
+    box_shrink(other, hist);
+}
+
+static guint median_cut(Histogram *hist, guint max_colors, Box *boxes)
+{
+    guint n_boxes = 1;
+    boxes[0] = (Box){.start = 0, .end = hist->n_keys};
+    box_shrink(&boxes[0], hist);
+
+    while (n_boxes < max_colors) {
+        guint best = G_MAXUINT;
+        guint64 best_score = 0;
+        for (guint i = 0; i < n_boxes; ++i) {
+            Box const *box = &boxes[i];
+            guint axis = box_longest_axis(box);
+            guint64 score = box->count * (box->hi[axis] - box->lo[axis]);
+            if (score > best_score) {
+                best = i;
+                best_score = score;
+            }
+        }
+        if (best == G_MAXUINT) {
+            break;
+        }
+        box_split(&boxes[best], &boxes[n_boxes], hist);
+        n_boxes += 1;
+    }
+    return n_boxes;
+}
+
+static void box_mean(Box const *box, Histogram const *hist, WadRgb *color)
+{
+    guint64 sum[3] = {};
+    for (guint i = box->start; i < box->end; ++i) {
+        Cell const *cell = &hist->cells[hist->keys[i]];
+        for (guint c = 0; c < 3; ++c) {
+            sum[c] += cell->sum[c];
+        }
+    }
+    for (guint c = 0; c < 3; ++c) {
+        color->rgb[c] = (sum[c] + box->count / 2) / MAX(box->count, 1);
+    }
+}
+
+// Uses the image's own colors if there are few enough of them.
+static bool exact_palette(ColorSet const *set, WadRgb *palette)
+{
+    if (set->overflow) {
+        return false;
+    }
+    for (guint i = 0; i < COLOR_SET_SIZE; ++i) {
+        if (set->slots[i] != 0) {
+            guint32 color = set->slots[i];
+            palette[set->index[i]] = (WadRgb){{
+                (guchar)(color >> 16),
+                (guchar)(color >> 8),
+                (guchar)color,
+            }};
+        }
+    }
+    return true;
+}
+
+static void map_exact(
+    guchar const *rgba,
+    guint32 width,
+    guint32 height,
+    gsize stride,
+    bool transparent,
+    ColorSet const *set,
+    guchar *indices
+)
+{
+    for (guint32 y = 0; y < height; ++y) {
+        guchar const *row = rgba + y * stride;
+        guchar *out = indices + (gsize)y * width;
+        for (guint32 x = 0; x < width; ++x) {
+            guchar const *p = row + x * 4;
+            out[x] = is_transparent(p, transparent)
+                       ? WAD_MIPTEX_TRANSPARENT_INDEX
+                       : set->index[color_set_find(set, pixel_color(p))];
+        }
+    }
+}
+
+// 4x4 Bayer matrix, centred on zero, in steps of one histogram cell.
+static gint8 const bayer[4][4] = {
+    {-8, 0, -6, 2},
+    {4, -4, 6, -2},
+    {-5, 3, -7, 1},
+    {7, -1, 5, -3},
+};
+
+static void map_nearest(
+    guchar const *rgba,
+    guint32 width,
+    guint32 height,
+    gsize stride,
+    bool transparent,
+    bool ordered,
+    WadNearestColor *nearest,
+    guchar *indices
+)
+{
+    for (guint32 y = 0; y < height; ++y) {
+        guchar const *row = rgba + y * stride;
+        guchar *out = indices + (gsize)y * width;
+        for (guint32 x = 0; x < width; ++x) {
+            guchar const *p = row + x * 4;
+            if (is_transparent(p, transparent)) {
+                out[x] = WAD_MIPTEX_TRANSPARENT_INDEX;
+                continue;
+            }
+            gint offset = ordered ? bayer[y & 3][x & 3] : 0;
+            out[x] = wad_nearest_color_lookup(
+                nearest,
+                CLAMP(p[0] + offset, 0, 255),
+                CLAMP(p[1] + offset, 0, 255),
+                CLAMP(p[2] + offset, 0, 255)
+            );
+        }
+    }
+}
+
+/*
+ * Floyd-Steinberg error diffusion, in serpentine order. Errors are carried in
+ * sixteenths; transparent pixels neither take nor pass on error.
+ */
+static void map_floyd_steinberg(
+    guchar const *rgba,
+    guint32 width,
+    guint32 height,
+    gsize stride,
+    bool transparent,
+    WadRgb const *palette,
+    WadNearestColor *nearest,
+    guchar *indices
+)
+{
+    // One pixel of margin on each side, so neighbours need no bounds checks.
+    gsize n = ((gsize)width + 2) * 3;
+    g_autofree gint32 *errors = g_new0(gint32, n * 2);
+    gint32 *cur = errors;
+    gint32 *next = errors + n;
+
+    for (guint32 y = 0; y < height; ++y) {
+        guchar const *row = rgba + y * stride;
+        guchar *out = indices + (gsize)y * width;
+        bool reverse = y & 1;
+        gint dir = reverse ? -1 : 1;
+        memset(next, 0, n * sizeof(gint32));
+
+        for (guint32 i = 0; i < width; ++i) {
+            guint32 x = reverse ? width - 1 - i : i;
+            guchar const *p = row + x * 4;
+            if (is_transparent(p, transparent)) {
+                out[x] = WAD_MIPTEX_TRANSPARENT_INDEX;
+                continue;
+            }
+            gint32 *e = cur + (x + 1) * 3;
+            gint value[3];
+            for (guint c = 0; c < 3; ++c) {
+                value[c] = CLAMP(p[c] + ((e[c] + 8) >> 4), 0, 255);
+            }
+            guchar index = wad_nearest_color_lookup(
+                nearest,
+                value[0],
+                value[1],
+                value[2]
+            );
+            out[x] = index;
+            for (guint c = 0; c < 3; ++c) {
+                gint32 error = value[c] - palette[index].rgb[c];
+                cur[(x + 1 + dir) * 3 + c] += error * 7;
+                next[(x + 1 - dir) * 3 + c] += error * 3;
+                next[(x + 1) * 3 + c] += error * 5;
+                next[(x + 1 + dir) * 3 + c] += error;
+            }
+        }
+        gint32 *swap = cur;
+        cur = next;
+        next = swap;
+    }
+}
+
+// Internal ////////////////////////////////////////////////////////////////////
+
+/*
+ * Quantizes an RGBA image to at most 256 colors, writing one palette index per
+ * pixel to `indices` (tightly packed) and 256 colors to `palette`. If
+ * `transparent` is set, pixels with alpha below 128 are given
+ * WAD_MIPTEX_TRANSPARENT_INDEX, whose color is pure blue, and the image gets
+ * at most 255 colors of its own.
+ */
+void wad_quantize(
+    guchar const *rgba,
+    guint32 width,
+    guint32 height,
+    gsize stride,
+    bool transparent,
+    WadDither dither,
+    guchar *indices,
+    WadRgb *palette
+)
+{
+    guint max_colors = transparent ? 255 : 256;
+    memset(palette, 0, 256 * sizeof(WadRgb));
+    if (transparent) {
+        palette[WAD_MIPTEX_TRANSPARENT_INDEX] = TRANSPARENT_COLOR;
+    }
+
+    Histogram hist = {};
+    histogram_init(&hist, rgba, width, height, stride, transparent, max_colors);
+
+    if (exact_palette(hist.colors, palette)) {
+        map_exact(
+            rgba,
+            width,
+            height,
+            stride,
+            transparent,
+            hist.colors,
+            indices
+        );
+        histogram_clear(&hist);
+        return;
+    }
+
+    g_autofree Box *boxes = g_new(Box, max_colors);
+    guint n_colors = median_cut(&hist, max_colors, boxes);
+    for (guint i = 0; i < n_colors; ++i) {
+        box_mean(&boxes[i], &hist, &palette[i]);
+    }
+    histogram_clear(&hist);
+
+    g_auto(WadNearestColor) nearest = {};
+    wad_nearest_color_init(&nearest, palette, n_colors);
+    if (dither == WAD_DITHER_FLOYD_STEINBERG) {
+        map_floyd_steinberg(
+            rgba,
+            width,
+            height,
+            stride,
+            transparent,
+            palette,
+            &nearest,
+            indices
+        );
+    } else {
+        map_nearest(
+            rgba,
+            width,
+            height,
+            stride,
+            transparent,
+            dither == WAD_DITHER_ORDERED,
+            &nearest,
+            indices
+        );
+    }
+}
@@ -0,0 +1,277 @@
+/*
+ * Palette expansion from 8-bit indexed images to RGBA.
+ *
+ * The palette is first turned into a 256-entry lookup table so that every
+ * index is valid, then rows are expanded with the widest kernel available:
+ * AVX2 gathers on x86-64 (chosen at runtime), NEON table lookups on AArch64,
+ * and a scalar loop otherwise. SSE2 has neither a gather nor a byte shuffle,
+ * so it would be no faster than the scalar loop and has no kernel of its own.
+ */
+#include "wad-private.h"
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#define HAVE_AVX2_KERNEL 1
+#include <immintrin.h>
+#endif
+
+#if defined(__aarch64__) && defined(__ARM_NEON)
+#define HAVE_NEON_KERNEL 1
+#include <arm_neon.h>
+#endif
+
+// Private /////////////////////////////////////////////////////////////////////
+
+static void expand_scalar(
+    WadPaletteLut const *restrict lut,
+    guchar const *restrict src,
+    gsize n,
+    guchar *restrict dest
+)
+{
+    for (gsize i = 0; i < n; ++i) {
+        memcpy(dest + i * 4, &lut->rgba[src[i]], 4);
+    }
+}
+
+#ifdef HAVE_AVX2_KERNEL
+__attribute__((target("avx2"))) static void expand_avx2(
+    WadPaletteLut const *restrict lut,
+    guchar const *restrict src,
+    gsize n,
+    guchar *restrict dest
+)
+{
+    int const *table = (int const *)lut->rgba;
+    gsize i = 0;
+    for (; i + 16 <= n; i += 16) {
+        __m128i idx = _mm_loadu_si128((__m128i const *)(src + i));
+        __m256i lo
+            = _mm256_i32gather_epi32(table, _mm256_cvtepu8_epi32(idx), 4);
+        __m256i hi = _mm256_i32gather_epi32(
+            table,
+            _mm256_cvtepu8_epi32(_mm_srli_si128(idx, 8)),
+            4
+        );
+        _mm256_storeu_si256((__m256i *)(dest + i * 4), lo);
+        _mm256_storeu_si256((__m256i *)(dest + i * 4 + 32), hi);
+    }
+    expand_scalar(lut, src + i, n - i, dest + i * 4);
+}
+#endif
+
+#ifdef HAVE_NEON_KERNEL
+// Looks up each byte of `idx` in a 256-byte table split into four quarters.
+static inline uint8x16_t lookup256(uint8x16x4_t const table[4], uint8x16_t idx)
+{
+    // Indices outside a quarter's range leave the previous result in place.
+    uint8x16_t r = vqtbl4q_u8(table[0], idx);
+    r = vqtbx4q_u8(r, table[1], vsubq_u8(idx, vdupq_n_u8(64)));
+    r = vqtbx4q_u8(r, table[2], vsubq_u8(idx, vdupq_n_u8(128)));
+    r = vqtbx4q_u8(r, table[3], vsubq_u8(idx, vdupq_n_u8(192)));
+    return r;
+}
+
+static void expand_neon(
+    WadPaletteLut const *restrict lut,
+    guchar const *restrict src,
+    gsize n,
+    guchar *restrict dest
+)
+{
+    uint8x16x4_t table[4][4];
+    for (size_t c = 0; c < 4; ++c) {
+        for (size_t q = 0; q < 4; ++q) {
+            table[c][q] = vld1q_u8_x4(lut->channel[c] + q * 64);
+        }
+    }
+    gsize i = 0;
+    for (; i + 16 <= n; i += 16) {
+        uint8x16_t idx = vld1q_u8(src + i);
+        uint8x16x4_t rgba = {{
+            lookup256(table[0], idx),
+            lookup256(table[1], idx),
+            lookup256(table[2], idx),
+            lookup256(table[3], idx),
+        }};
+        vst4q_u8(dest + i * 4, rgba);
+    }
+    expand_scalar(lut, src + i, n - i, dest + i * 4);
+}
+#endif
+
+static void expand(
+    WadPaletteLut const *restrict lut,
+    guchar const *restrict src,
+    gsize n,
+    guchar *restrict dest
+)
+{
+#if defined(HAVE_NEON_KERNEL)
+    expand_neon(lut, src, n, dest);
+#else
+#if defined(HAVE_AVX2_KERNEL)
+    if (__builtin_cpu_supports("avx2")) {
+        expand_avx2(lut, src, n, dest);
+        return;
+    }
+#endif
+    expand_scalar(lut, src, n, dest);
+#endif
+}
+
+// Writes each pixel `scale` times across. Inlined with constant scales so the
+// inner loop unrolls.
+static inline void expand_scaled(
+    WadPaletteLut const *restrict lut,
+    guchar const *restrict src,
+    gsize n,
+    guint scale,
+    guchar *restrict dest
+)
+{
+    for (gsize i = 0; i < n; ++i) {
+        guint32 color = lut->rgba[src[i]];
+        for (guint k = 0; k < scale; ++k) {
+            memcpy(dest + (i * scale + k) * 4, &color, 4);
+        }
+    }
+}
+
+static void expand_row_scaled(
+    WadPaletteLut const *restrict lut,
+    guchar const *restrict src,
+    gsize n,
+    guint scale,
+    guchar *restrict dest
+)
+{
+    switch (scale) {
+    case 2:
+        expand_scaled(lut, src, n, 2, dest);
+        break;
+    case 3:
+        expand_scaled(lut, src, n, 3, dest);
+        break;
+    case 4:
+        expand_scaled(lut, src, n, 4, dest);
+        break;
+    default:
+        expand_scaled(lut, src, n, scale, dest);
+    }
+}
+
+// Internal ////////////////////////////////////////////////////////////////////
+
+/*
+ * Builds a lookup table from `palette`, with `gamma` (if any) applied to each
+ * color channel. Indices past the end of the palette map to opaque black.
+ */
+void wad_palette_lut_init(
+    WadPaletteLut *lut,
+    WadRgb const *palette,
+    gsize n_colors,
+    WadGammaTable const *gamma
+)
+{
+    n_colors = MIN(n_colors, 256);
+    for (gsize i = 0; i < 256; ++i) {
+        guchar rgba[4] = {0, 0, 0, 0xff};
+        if (i < n_colors) {
+            memcpy(rgba, palette[i].rgb, 3);
+        }
+        if (gamma) {
+            for (size_t c = 0; c < 3; ++c) {
+                rgba[c] = gamma->values[rgba[c]];
+            }
+        }
+        memcpy(&lut->rgba[i], rgba, 4);
+        for (size_t c = 0; c < 4; ++c) {
+            lut->channel[c][i] = rgba[c];
+        }
+    }
+}
+
+/*
+ * Makes palette index `index` transparent black.
+ */
+void wad_palette_lut_set_transparent(WadPaletteLut *lut, guchar index)
+{
+    lut->rgba[index] = 0;
+    for (size_t c = 0; c < 4; ++c) {
+        lut->channel[c][index] = 0;
+    }
+}
+
+/*
+ * Expands a `width` x `height` indexed image into `dest`, whose rows are
+ * `dest_stride` bytes apart. Rows missing from `src` are filled with zeros.
+ */
+void wad_palette_lut_expand(
+    WadPaletteLut const *restrict lut,
+    guchar const *restrict src,
+    gsize src_size,
+    guint32 width,
+    guint32 height,
+    guchar *restrict dest,
+    gsize dest_stride
+)
+{
+    gsize row_size = (gsize)width * 4;
+    gsize n_rows = width == 0 ? 0 : MIN(height, src_size / width);
+
+    if (dest_stride == row_size) {
+        expand(lut, src, n_rows * width, dest);
+    } else {
+        for (gsize y = 0; y < n_rows; ++y) {
+            expand(lut, src + y * width, width, dest + y * dest_stride);
+        }
+    }
+    for (gsize y = n_rows; y < height; ++y) {
+        memset(dest + y * dest_stride, 0, row_size);
+    }
+}
+
+/*
+ * As wad_palette_lut_expand(), but enlarges the image `scale` times in each
+ * direction with nearest-neighbour sampling while expanding it. `dest` must
+ * hold `height * scale` rows of `width * scale` pixels. Each source row is
+ * expanded once and then copied down.
+ */
+void wad_palette_lut_expand_scaled(
+    WadPaletteLut const *restrict lut,
+    guchar const *restrict src,
+    gsize src_size,
+    guint32 width,
+    guint32 height,
+    guint scale,
+    guchar *restrict dest,
+    gsize dest_stride
+)
+{
+    if (scale <= 1) {
+        wad_palette_lut_expand(
+            lut,
+            src,
+            src_size,
+            width,
+            height,
+            dest,
+            dest_stride
+        );
+        return;
+    }
+
+    gsize row_size = (gsize)width * scale * 4;
+    gsize n_rows = width == 0 ? 0 : MIN(height, src_size / width);
+
+    for (gsize y = 0; y < n_rows; ++y) {
+        guchar *row = dest + y * scale * dest_stride;
+        expand_row_scaled(lut, src + y * width, width, scale, row);
+        for (guint k = 1; k < scale; ++k) {
+            memcpy(row + k * dest_stride, row, row_size);
+        }
+    }
+    for (gsize y = n_rows * scale; y < (gsize)height * scale; ++y) {
+        memset(dest + y * dest_stride, 0, row_size);
+    }
+}
@@ -0,0 +1,499 @@
+#include "wad-rgbacache.h"
+
+#include "wad-private.h"
+
+/**
+ * WadRgbaCache:
+ *
+ * A size-limited cache of textures expanded to RGBA.
+ *
+ * Textures are fetched from a [class@WadTextureArchive] and expanded on first
+ * lookup. Once the cached pixels exceed [property@WadRgbaCache:max-bytes], the
+ * least recently used textures are dropped. Lookups may be made from several
+ * threads at once; expansion happens outside the cache's lock, so a slow miss
+ * does not hold up hits on other threads.
+ *
+ * A texture replaced in or removed from the archive is dropped from the cache,
+ * so the next lookup expands the new one.
+ */
+struct _WadRgbaCache {
+    GObject parent_instance;
+    WadTextureArchive *archive;
+    GMutex lock;
+    GHashTable *entries; // WadName -> CacheEntry
+    GQueue lru;          // Most recently used first
+    guint64 max_bytes;
+    guint64 size;
+    guint64 hits;
+    guint64 misses;
+    guint64 n_invalidated; // Lets a miss tell if it expanded a stale texture
+};
+
+G_DEFINE_FINAL_TYPE(WadRgbaCache, wad_rgba_cache, G_TYPE_OBJECT)
+
+enum Property {
+    PROP_ARCHIVE = 1,
+    PROP_MAX_BYTES,
+    N_PROPERTIES,
+};
+
+static GParamSpec *obj_properties[N_PROPERTIES];
+
+// Private /////////////////////////////////////////////////////////////////////
+
+typedef struct {
+    WadName key;
+    GList link; // In lru, data points back to the entry
+    GBytes *pixels;
+    guint width, height;
+} CacheEntry;
+
+static void cache_entry_free(CacheEntry *entry)
+{
+    g_bytes_unref(entry->pixels);
+    g_free(entry);
+}
+
+// Must hold lock.
+static void remove_entry(WadRgbaCache *self, CacheEntry *entry)
+{
+    g_queue_unlink(&self->lru, &entry->link);
+    self->size -= g_bytes_get_size(entry->pixels);
+    g_hash_table_remove(self->entries, &entry->key);
+}
+
+// Must hold lock.
+static void evict(WadRgbaCache *self)
+{
+    while (self->size > self->max_bytes && self->lru.tail) {
+        remove_entry(self, self->lru.tail->data);
+    }
+}
+
+// Expands a texture to RGBA, or returns NULL if there is none of that name.
+static GBytes *expand(
+    WadTextureArchive *archive,
+    char const *texture_name,
+    guint *width,
+    guint *height
+)
+{
+    // Work on a copy, in case the texture is replaced while it is expanded.
+    g_auto(WadTexture) texture = {};
+    if (!wad_texture_archive_dup_texture(
+            archive,
+            texture_name,
+            &texture,
+            nullptr
+        )) {
+        return nullptr;
+    }
+    return wad_texture_expand_rgba(&texture, width, height);
+}
+
+static void on_texture_invalidated(
+    WadTextureArchive *,
+    char const *texture_name,
+    gpointer user_data
+)
+{
+    WadRgbaCache *self = user_data;
+    WadName key;
+    wad_name_init(&key, texture_name);
+    g_mutex_lock(&self->lock);
+    self->n_invalidated += 1;
+    CacheEntry *entry = g_hash_table_lookup(self->entries, &key);
+    if (entry) {
+        remove_entry(self, entry);
+    }
+    g_mutex_unlock(&self->lock);
+}
+
+// GObject /////////////////////////////////////////////////////////////////////
+
+static void wad_rgba_cache_dispose(GObject *object)
+{
+    WadRgbaCache *self = WAD_RGBA_CACHE(object);
+    if (self->archive) {
+        g_signal_handlers_disconnect_by_data(self->archive, self);
+    }
+    g_clear_object(&self->archive);
+    G_OBJECT_CLASS(wad_rgba_cache_parent_class)->dispose(object);
+}
+
+static void wad_rgba_cache_finalize(GObject *object)
+{
+    WadRgbaCache *self = WAD_RGBA_CACHE(object);
+    g_clear_pointer(&self->entries, g_hash_table_unref);
+    g_mutex_clear(&self->lock);
+    G_OBJECT_CLASS(wad_rgba_cache_parent_class)->finalize(object);
+}
+
+static void wad_rgba_cache_set_property(
+    GObject *object,
+    guint property_id,
+    GValue const *value,
+    GParamSpec *pspec
+)
+{
+    WadRgbaCache *self = WAD_RGBA_CACHE(object);
+    switch ((enum Property)property_id) {
+    case PROP_ARCHIVE:
+        self->archive = g_value_dup_object(value);
+        if (self->archive) {
+            g_signal_connect(
+                self->archive,
+                "texture-invalidated",
+                G_CALLBACK(on_texture_invalidated),
+                self
+            );
+        }
+        break;
+    case PROP_MAX_BYTES:
+        wad_rgba_cache_set_max_bytes(self, g_value_get_uint64(value));
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
+    }
+}
+
+static void wad_rgba_cache_get_property(
+    GObject *object,
+    guint property_id,
+    GValue *value,
+    GParamSpec *pspec
+)
+{
+    WadRgbaCache *self = WAD_RGBA_CACHE(object);
+    switch ((enum Property)property_id) {
+    case PROP_ARCHIVE:
+        g_value_set_object(value, self->archive);
+        break;
+    case PROP_MAX_BYTES:
+        g_value_set_uint64(value, wad_rgba_cache_get_max_bytes(self));
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
+    }
+}
+
+// WadRgbaCache ////////////////////////////////////////////////////////////////
+
+static void wad_rgba_cache_class_init(WadRgbaCacheClass *klass)
+{
+    GObjectClass *oclass = G_OBJECT_CLASS(klass);
+    oclass->dispose = wad_rgba_cache_dispose;
+    oclass->finalize = wad_rgba_cache_finalize;
+    oclass->set_property = wad_rgba_cache_set_property;
+    oclass->get_property = wad_rgba_cache_get_property;
+
+    /**
+     * WadRgbaCache:archive
+     * The archive textures are read from.
+     */
+    obj_properties[PROP_ARCHIVE] = g_param_spec_object(
+        "archive",
+        nullptr,
+        nullptr,
+        WAD_TYPE_TEXTURE_ARCHIVE,
+        G_PARAM_READWRITE | G_PARAM_CONSTRUCT_ONLY
+    );
+
+    /**
+     * WadRgbaCache:max-bytes
+     * Number of bytes of pixel data to keep before evicting textures.
+     *
+     * A texture larger than the whole budget is still returned by
+     * wad_rgba_cache_lookup(), but not kept.
+     */
+    obj_properties[PROP_MAX_BYTES] = g_param_spec_uint64(
+        "max-bytes",
+        nullptr,
+        nullptr,
+        0,
+        G_MAXUINT64,
+        64 * 1024 * 1024,
+        G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY
+    );
+
+    g_object_class_install_properties(oclass, N_PROPERTIES, obj_properties);
+}
+
+static void wad_rgba_cache_init(WadRgbaCache *self)
+{
+    g_mutex_init(&self->lock);
+    self->entries = g_hash_table_new_full(
+        wad_name_hash,
+        wad_name_equal_func,
+        nullptr,
+        (GDestroyNotify)cache_entry_free
+    );
+    g_queue_init(&self->lru);
+    self->max_bytes = 64 * 1024 * 1024;
+}
+
+// Public //////////////////////////////////////////////////////////////////////
+
+/**
+ * wad_rgba_cache_new:
+ * @archive: The archive to read textures from.
+ * @max_bytes: Number of bytes of pixel data to keep.
+ *
+ * Creates an empty cache.
+ *
+ * Returns: A new [class@WadRgbaCache].
+ */
+WadRgbaCache *
+wad_rgba_cache_new(WadTextureArchive *archive, guint64 max_bytes)
+{
+    g_return_val_if_fail(WAD_IS_TEXTURE_ARCHIVE(archive), nullptr);
+    return g_object_new(
+        WAD_TYPE_RGBA_CACHE,
+        "archive",
+        archive,
+        "max-bytes",
+        max_bytes,
+        nullptr
+    );
+}
+
+/**
+ * wad_rgba_cache_lookup:
+ * @cache: A [class@WadRgbaCache].
+ * @texture_name: Name of the texture.
+ * @width: (out) (optional): Return location for the width of the image.
+ * @height: (out) (optional): Return location for the height of the image.
+ *
+ * Gets a texture as tightly-packed 8-bit RGBA rows, expanding it if it is not
+ * cached. Miptex textures give their full-size mip level.
+ *
+ * Returns: (transfer full) (nullable): The pixels, or `NULL` if the archive
+ * has no texture of that name.
+ */
+GBytes *wad_rgba_cache_lookup(
+    WadRgbaCache *self,
+    char const *texture_name,
+    guint *width,
+    guint *height
+)
+{
+    g_return_val_if_fail(WAD_IS_RGBA_CACHE(self), nullptr);
+    g_return_val_if_fail(texture_name != nullptr, nullptr);
+
+    WadName key;
+    wad_name_init(&key, texture_name);
+    GBytes *pixels = nullptr;
+    guint w = 0;
+    guint h = 0;
+    guint64 n_invalidated = 0;
+
+    g_mutex_lock(&self->lock);
+    CacheEntry *entry = g_hash_table_lookup(self->entries, &key);
+    if (entry) {
+        self->hits += 1;
+        g_queue_unlink(&self->lru, &entry->link);
+        g_queue_push_head_link(&self->lru, &entry->link);
+        pixels = g_bytes_ref(entry->pixels);
+        w = entry->width;
+        h = entry->height;
+    } else {
+        self->misses += 1;
+        n_invalidated = self->n_invalidated;
+    }
+    g_mutex_unlock(&self->lock);
+
+    if (!pixels) {
+        pixels = expand(self->archive, texture_name, &w, &h);
+        if (!pixels) {
+            return nullptr;
+        }
+        g_mutex_lock(&self->lock);
+        // Another thread may have expanded the same texture meanwhile, or
+        // the archive may have replaced it.
+        if (self->n_invalidated == n_invalidated
+            && !g_hash_table_contains(self->entries, &key)
+            && g_bytes_get_size(pixels) <= self->max_bytes) {
+            entry = g_new0(CacheEntry, 1);
+            entry->key = key;
+            entry->link.data = entry;
+            entry->pixels = g_bytes_ref(pixels);
+            entry->width = w;
+            entry->height = h;
+            g_hash_table_insert(self->entries, &entry->key, entry);
+            g_queue_push_head_link(&self->lru, &entry->link);
+            self->size += g_bytes_get_size(pixels);
+            evict(self);
+        }
+        g_mutex_unlock(&self->lock);
+    }
+    if (width) {
+        *width = w;
+    }
+    if (height) {
+        *height = h;
+    }
+    return pixels;
+}
+
+/**
+ * wad_rgba_cache_clear:
+ * @cache: A [class@WadRgbaCache].
+ *
+ * Drops every cached texture. The hit and miss counters are kept.
+ */
+void wad_rgba_cache_clear(WadRgbaCache *self)
+{
+    g_return_if_fail(WAD_IS_RGBA_CACHE(self));
+    g_mutex_lock(&self->lock);
+    g_queue_init(&self->lru);
+    g_hash_table_remove_all(self->entries);
+    self->size = 0;
+    g_mutex_unlock(&self->lock);
+}
+
+/**
+ * wad_rgba_cache_get_archive:
+ * @cache: A [class@WadRgbaCache].
+ *
+ * Gets the archive textures are read from.
+ *
+ * Returns: (transfer none): The archive.
+ */
+WadTextureArchive *wad_rgba_cache_get_archive(WadRgbaCache *self)
+{
+    g_return_val_if_fail(WAD_IS_RGBA_CACHE(self), nullptr);
+    return self->archive;
+}
+
+/**
+ * wad_rgba_cache_set_max_bytes:
+ * @cache: A [class@WadRgbaCache].
+ * @max_bytes: Number of bytes of pixel data to keep.
+ *
+ * Sets [property@WadRgbaCache:max-bytes], evicting textures if the cache is
+ * now over budget.
+ */
+void wad_rgba_cache_set_max_bytes(WadRgbaCache *self, guint64 max_bytes)
+{
+    g_return_if_fail(WAD_IS_RGBA_CACHE(self));
+    g_mutex_lock(&self->lock);
+    bool changed = self->max_bytes != max_bytes;
+    self->max_bytes = max_bytes;
+    evict(self);
+    g_mutex_unlock(&self->lock);
+    if (changed) {
+        g_object_notify_by_pspec(
+            G_OBJECT(self),
+            obj_properties[PROP_MAX_BYTES]
+        );
+    }
+}
+
+/**
+ * wad_rgba_cache_get_max_bytes:
+ * @cache: A [class@WadRgbaCache].
+ *
+ * Gets [property@WadRgbaCache:max-bytes].
+ *
+ * Returns: The byte budget.
+ */
+guint64 wad_rgba_cache_get_max_bytes(WadRgbaCache *self)
+{
+    g_return_val_if_fail(WAD_IS_RGBA_CACHE(self), 0);
+    g_mutex_lock(&self->lock);
+    guint64 max_bytes = self->max_bytes;
+    g_mutex_unlock(&self->lock);
+    return max_bytes;
+}
+
+/**
+ * wad_rgba_cache_get_size:
+ * @cache: A [class@WadRgbaCache].
+ *
+ * Gets the number of bytes of pixel data currently cached.
+ *
+ * Returns: The cache size in bytes.
+ */
+guint64 wad_rgba_cache_get_size(WadRgbaCache *self)
+{
+    g_return_val_if_fail(WAD_IS_RGBA_CACHE(self), 0);
+    g_mutex_lock(&self->lock);
+    guint64 size = self->size;
+    g_mutex_unlock(&self->lock);
+    return size;
+}
+
+/**
+ * wad_rgba_cache_get_hits:
+ * @cache: A [class@WadRgbaCache].
+ *
+ * Gets the number of lookups answered from the cache.
+ *
+ * Returns: The number of hits.
+ */
+guint64 wad_rgba_cache_get_hits(WadRgbaCache *self)
+{
+    g_return_val_if_fail(WAD_IS_RGBA_CACHE(self), 0);
+    g_mutex_lock(&self->lock);
+    guint64 hits = self->hits;
+    g_mutex_unlock(&self->lock);
+    return hits;
+}
+
+/**
+ * wad_rgba_cache_get_misses:
+ * @cache: A [class@WadRgbaCache].
+ *
+ * Gets the number of lookups that had to expand a texture.
+ *
+ * Returns: The number of misses.
+ */
+guint64 wad_rgba_cache_get_misses(WadRgbaCache *self)
+{
+    g_return_val_if_fail(WAD_IS_RGBA_CACHE(self), 0);
+    g_mutex_lock(&self->lock);
+    guint64 misses = self->misses;
+    g_mutex_unlock(&self->lock);
+    return misses;
+}
+
+// Internal ////////////////////////////////////////////////////////////////////
+
+/*
+ * Expands a texture to tightly-packed RGBA rows, using the full-size level of
+ * a miptex. Returns NULL for a texture of unknown type.
+ */
+GBytes *wad_texture_expand_rgba(
+    WadTexture const *texture,
+    guint *width,
+    guint *height
+)
+{
+    guint w = 0;
+    guint h = 0;
+    guchar *pixels = nullptr;
+    if (texture->type == WAD_TYPE_MIPTEX_FILE) {
+        WadMiptexFile const *miptex = texture->boxed;
+        w = miptex->width;
+        h = miptex->height;
+        pixels = g_new(guchar, (gsize)w * h * 4);
+        wad_miptex_file_to_rgba(miptex, 0, nullptr, pixels, (gsize)w * 4);
+    } else if (texture->type == WAD_TYPE_QPIC_FILE) {
+        WadQpicFile const *qpic = texture->boxed;
+        w = qpic->width;
+        h = qpic->height;
+        pixels = g_new(guchar, (gsize)w * h * 4);
+        wad_qpic_file_to_rgba(qpic, nullptr, pixels, (gsize)w * 4);
+    } else if (texture->type == WAD_TYPE_FONT_FILE) {
+        WadFontFile const *font = texture->boxed;
+        w = 256;
+        h = font->height;
+        pixels = g_new(guchar, (gsize)w * h * 4);
+        wad_font_file_to_rgba(font, nullptr, pixels, (gsize)w * 4);
+    } else {
+        return nullptr;
+    }
+    *width = w;
+    *height = h;
+    return g_bytes_new_take(pixels, (gsize)w * h * 4);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "wad/wad-texturearchive.h"
+
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define WAD_TYPE_RGBA_CACHE wad_rgba_cache_get_type()
+
+G_DECLARE_FINAL_TYPE(WadRgbaCache, wad_rgba_cache, WAD, RGBA_CACHE, GObject)
+
+WadRgbaCache *
+wad_rgba_cache_new(WadTextureArchive *archive, guint64 max_bytes);
+
+GBytes *wad_rgba_cache_lookup(
+    WadRgbaCache *cache,
+    char const *texture_name,
+    guint *width,
+    guint *height
+);
+
+void wad_rgba_cache_clear(WadRgbaCache *cache);
+
+WadTextureArchive *wad_rgba_cache_get_archive(WadRgbaCache *cache);
+
+void wad_rgba_cache_set_max_bytes(WadRgbaCache *cache, guint64 max_bytes);
+guint64 wad_rgba_cache_get_max_bytes(WadRgbaCache *cache);
+
+guint64 wad_rgba_cache_get_size(WadRgbaCache *cache);
+guint64 wad_rgba_cache_get_hits(WadRgbaCache *cache);
+guint64 wad_rgba_cache_get_misses(WadRgbaCache *cache);
+
+G_END_DECLS
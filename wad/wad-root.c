@@ -2,6 +2,8 @@
 
 #include "wad-inputstream.h"
 #include "wad-loaderror.h"
+#include "wad-outputstream.h"
+#include "wad-private.h"
 
 /**
  * WadRoot:
@@ -11,35 +13,350 @@
 struct _WadRoot {
     GObject parent_instance;
     WadTextureArchive *archive;
+    bool lazy;
+    guint n_threads;
+    GFile *watched_file;
+    GFileMonitor *monitor;
+    GHashTable *snapshot; // WadName -> Snapshot, for watched_file
 };
 
 G_DEFINE_FINAL_TYPE(WadRoot, wad_root, G_TYPE_OBJECT)
 
+enum Property {
+    PROP_LAZY = 1,
+    PROP_N_THREADS,
+    N_PROPERTIES,
+};
+
+static GParamSpec *obj_properties[N_PROPERTIES];
+
+enum Signal {
+    SIGNAL_PROGRESS,
+    SIGNAL_TEXTURE_ADDED,
+    SIGNAL_TEXTURE_CHANGED,
+    SIGNAL_TEXTURE_REMOVED,
+    N_SIGNALS,
+};
+
+static guint obj_signals[N_SIGNALS];
+
 // Private /////////////////////////////////////////////////////////////////////
 
-void load_from_stream(WadRoot *self, GInputStream *base_stream, GError **error)
+// Most directory entries a sequentially streamed WAD may declare.
+#define MAX_DIRECTORY_ENTRIES (1u << 20)
+
+// Largest block buffered at once while reading a sequential stream.
+#define READ_CHUNK_SIZE ((gsize)1 << 20)
+
+typedef void (*ProgressFunc)(
+    guint n_decoded,
+    guint n_total,
+    guint64 bytes_read,
+    gpointer user_data
+);
+
+/*
+ * LoadOptions:
+ * @lazy: Defer decoding, see WadRoot:lazy.
+ * @n_threads: Resolved number of decoding threads.
+ * @cancellable: (nullable): Checked between entries.
+ * @progress: (nullable): Called after each entry is decoded, possibly from a
+ * worker thread.
+ * @progress_data: Data for @progress.
+ *
+ * Settings for a single load, snapshotted from the WadRoot so loading can run
+ * on another thread.
+ */
+typedef struct {
+    bool lazy;
+    guint n_threads;
+    GCancellable *cancellable;
+    ProgressFunc progress;
+    gpointer progress_data;
+} LoadOptions;
+
+static LoadOptions load_options_init(WadRoot *self, GCancellable *cancellable)
 {
-    g_clear_object(&self->archive);
+    return (LoadOptions){
+        .lazy = self->lazy,
+        .n_threads
+        = self->n_threads == 0 ? g_get_num_processors() : self->n_threads,
+        .cancellable = cancellable,
+    };
+}
+
+static void report_progress(
+    LoadOptions const *options,
+    guint n_decoded,
+    guint n_total,
+    guint64 bytes_read
+)
+{
+    if (options->progress) {
+        options->progress(
+            n_decoded,
+            n_total,
+            bytes_read,
+            options->progress_data
+        );
+    }
+}
 
+static bool check_directory(GArray *directory, GError **error)
+{
+    for (guint i = 0; i < directory->len; ++i) {
+        WadDirectoryEntry const *dir_entry
+            = &g_array_index(directory, WadDirectoryEntry, i);
+        if (!wad_file_type_is_valid(dir_entry->file_type)) {
+            wad_set_file_type_error(error, dir_entry->file_type);
+            return false;
+        }
+    }
+    return true;
+}
+
+static WadTextureArchive *load_from_stream(
+    GInputStream *base_stream,
+    LoadOptions const *options,
+    GError **error
+)
+{
     g_autoptr(WadInputStream) stream = wad_input_stream_new(base_stream);
-    GDataInputStream *dstream = G_DATA_INPUT_STREAM(stream);
     GError *e = nullptr;
 
     // Header
-    char buffer[4];
-    gsize bytes_read;
-    g_input_stream_read_all(
-        G_INPUT_STREAM(stream),
-        buffer,
-        4,
-        &bytes_read,
-        nullptr,
+    guint32 num_dirs = 0;
+    guint32 dir_offset = 0;
+    wad_input_stream_read_header(
+        stream,
+        &num_dirs,
+        &dir_offset,
+        options->cancellable,
         &e
     );
     if (e) {
         g_propagate_error(error, e);
+        return nullptr;
+    }
+    g_info(
+        "\nHEADER\n  num_dirs = %" G_GUINT32_FORMAT "\n  dir_offset = %#x",
+        num_dirs,
+        dir_offset
+    );
+
+    // Directory Entries
+    g_seekable_seek(
+        G_SEEKABLE(stream),
+        dir_offset,
+        G_SEEK_SET,
+        options->cancellable,
+        &e
+    );
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    g_autoptr(GArray) directory = wad_input_stream_read_directory(
+        stream,
+        num_dirs,
+        options->cancellable,
+        &e
+    );
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    guint64 total_read = 12 + (guint64)num_dirs * WAD_DIRECTORY_ENTRY_SIZE;
+
+    // File Entries
+    g_autoptr(WadTextureArchive) archive = wad_texture_archive_new();
+    if (options->lazy) {
+        if (!check_directory(directory, error)) {
+            return nullptr;
+        }
+        wad_texture_archive_set_pending(archive, directory, stream, nullptr);
+        return g_steal_pointer(&archive);
+    }
+    for (guint i = 0; i < directory->len; ++i) {
+        if (g_cancellable_set_error_if_cancelled(options->cancellable, error)) {
+            return nullptr;
+        }
+        WadDirectoryEntry *dir_entry
+            = &g_array_index(directory, WadDirectoryEntry, i);
+        WadTexture texture
+            = wad_input_stream_read_entry(stream, dir_entry, &e);
+        if (e) {
+            g_propagate_error(error, e);
+            return nullptr;
+        }
+        wad_texture_archive_take_entry(archive, dir_entry, &texture);
+        total_read += g_seekable_tell(G_SEEKABLE(stream))
+                    - dir_entry->entry_offset;
+        report_progress(options, i + 1, directory->len, total_read);
+    }
+    return g_steal_pointer(&archive);
+}
+
+// Shared state for decoding a directory with wad_parallel_for().
+typedef struct {
+    GBytes *bytes;
+    GArray *directory; // Array<WadDirectoryEntry>
+    LoadOptions const *options;
+    WadTexture *results; // One per directory entry
+    gint failed;         // Set once any entry fails, atomic
+    GMutex lock;
+    guint n_decoded;
+    guint64 bytes_read;
+    guint error_index;
+    GError *error; // Error of the lowest-indexed failing entry
+} DecodeJob;
+
+static void decode_one(guint i, gpointer data)
+{
+    DecodeJob *job = data;
+    if (g_atomic_int_get(&job->failed)) {
         return;
     }
+
+    // Each call reads through its own cursor over the shared image.
+    g_auto(WadByteReader) reader = {};
+    wad_byte_reader_init(&reader, job->bytes);
+    WadDirectoryEntry const *dir_entry
+        = &g_array_index(job->directory, WadDirectoryEntry, i);
+    GError *e = nullptr;
+    if (!g_cancellable_set_error_if_cancelled(job->options->cancellable, &e)) {
+        job->results[i] = wad_byte_reader_read_entry(&reader, dir_entry, &e);
+    }
+
+    g_mutex_lock(&job->lock);
+    if (e) {
+        if (!job->error || i < job->error_index) {
+            g_clear_error(&job->error);
+            job->error = e;
+            job->error_index = i;
+        } else {
+            g_error_free(e);
+        }
+        g_atomic_int_set(&job->failed, TRUE);
+    } else {
+        job->n_decoded += 1;
+        job->bytes_read += reader.offset - dir_entry->entry_offset;
+        report_progress(
+            job->options,
+            job->n_decoded,
+            job->directory->len,
+            job->bytes_read
+        );
+    }
+    g_mutex_unlock(&job->lock);
+}
+
+/*
+ * Decodes every entry of `directory` from `bytes` in parallel, then adds them
+ * to `archive` in directory order.
+ */
+static void decode_parallel(
+    WadTextureArchive *archive,
+    GBytes *bytes,
+    GArray *directory,
+    guint64 bytes_read,
+    LoadOptions const *options,
+    GError **error
+)
+{
+    DecodeJob job = {
+        .bytes = bytes,
+        .directory = directory,
+        .options = options,
+        .results = g_new0(WadTexture, directory->len),
+        .bytes_read = bytes_read,
+    };
+    g_mutex_init(&job.lock);
+
+    wad_parallel_for(directory->len, options->n_threads, decode_one, &job);
+
+    for (guint i = 0; i < directory->len; ++i) {
+        if (job.error) {
+            wad_texture_clear(&job.results[i]);
+            continue;
+        }
+        wad_texture_archive_take_entry(
+            archive,
+            &g_array_index(directory, WadDirectoryEntry, i),
+            &job.results[i]
+        );
+    }
+    if (job.error) {
+        g_propagate_error(error, job.error);
+    }
+    g_free(job.results);
+    g_mutex_clear(&job.lock);
+}
+
+/*
+ * Decodes the entries of `directory` from the in-memory WAD image `bytes`,
+ * after `bytes_read` bytes of header and directory have been consumed.
+ */
+static WadTextureArchive *decode_entries(
+    GBytes *bytes,
+    GArray *directory,
+    guint64 bytes_read,
+    LoadOptions const *options,
+    GError **error
+)
+{
+    g_auto(WadByteReader) reader = {};
+    wad_byte_reader_init(&reader, bytes);
+    GError *e = nullptr;
+
+    g_autoptr(WadTextureArchive) archive = wad_texture_archive_new();
+    if (options->lazy) {
+        if (!check_directory(directory, error)) {
+            return nullptr;
+        }
+        wad_texture_archive_set_pending(archive, directory, nullptr, bytes);
+        return g_steal_pointer(&archive);
+    }
+    if (options->n_threads > 1) {
+        decode_parallel(archive, bytes, directory, bytes_read, options, &e);
+        if (e) {
+            g_propagate_error(error, e);
+            return nullptr;
+        }
+        return g_steal_pointer(&archive);
+    }
+    for (guint i = 0; i < directory->len; ++i) {
+        if (g_cancellable_set_error_if_cancelled(options->cancellable, error)) {
+            return nullptr;
+        }
+        WadDirectoryEntry *dir_entry
+            = &g_array_index(directory, WadDirectoryEntry, i);
+        WadTexture texture = wad_byte_reader_read_entry(&reader, dir_entry, &e);
+        if (e) {
+            g_propagate_error(error, e);
+            return nullptr;
+        }
+        wad_texture_archive_take_entry(archive, dir_entry, &texture);
+        bytes_read += reader.offset - dir_entry->entry_offset;
+        report_progress(options, i + 1, directory->len, bytes_read);
+    }
+    return g_steal_pointer(&archive);
+}
+
+static WadTextureArchive *
+load_from_bytes(GBytes *bytes, LoadOptions const *options, GError **error)
+{
+    g_auto(WadByteReader) reader = {};
+    wad_byte_reader_init(&reader, bytes);
+    GError *e = nullptr;
+
+    // Header
+    char buffer[4];
+    wad_byte_reader_read(&reader, buffer, 4, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
     if (strncmp(buffer, "WAD3", 4) != 0) {
         g_set_error(
             error,
@@ -48,145 +365,630 @@ void load_from_stream(WadRoot *self, GInputStream *base_stream, GError **error)
             "Bad magic number %.4s",
             buffer
         );
-        return;
+        return nullptr;
     }
-    guint32 num_dirs = g_data_input_stream_read_uint32(dstream, nullptr, &e);
+    guint32 num_dirs = wad_byte_reader_read_uint32(&reader, &e);
     if (e) {
         g_propagate_error(error, e);
-        return;
+        return nullptr;
     }
-    guint32 dir_offset = g_data_input_stream_read_uint32(dstream, nullptr, &e);
+    guint32 dir_offset = wad_byte_reader_read_uint32(&reader, &e);
     if (e) {
         g_propagate_error(error, e);
-        return;
+        return nullptr;
     }
-    g_info(
-        "\nHEADER\n  num_dirs = %" G_GUINT32_FORMAT "\n  dir_offset = %#x",
-        num_dirs,
-        dir_offset
-    );
 
     // Directory Entries
-    g_autoptr(GPtrArray) directory = g_ptr_array_new_full(
+    guint64 dir_end
+        = dir_offset + (guint64)num_dirs * WAD_DIRECTORY_ENTRY_SIZE;
+    if (dir_end > g_bytes_get_size(bytes)) {
+        g_set_error(
+            error,
+            WAD_LOAD_ERROR,
+            WAD_LOAD_ERROR_TRUNCATED,
+            "Directory of %" G_GUINT32_FORMAT " entries at %#x runs past "
+            "the end of the file",
+            num_dirs,
+            dir_offset
+        );
+        return nullptr;
+    }
+    wad_byte_reader_seek(&reader, dir_offset, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    g_autoptr(GArray) directory = g_array_sized_new(
+        FALSE,
+        FALSE,
+        sizeof(WadDirectoryEntry),
+        num_dirs
+    );
+    g_array_set_size(directory, num_dirs);
+    wad_byte_reader_read_directory(
+        &reader,
         num_dirs,
-        (GDestroyNotify)wad_directory_entry_free
+        (WadDirectoryEntry *)directory->data,
+        &e
     );
-    g_seekable_seek(G_SEEKABLE(stream), dir_offset, G_SEEK_SET, nullptr, &e);
     if (e) {
         g_propagate_error(error, e);
-        return;
+        return nullptr;
     }
-    for (guint32 i = 0; i < num_dirs; ++i) {
-        WadDirectoryEntry *entry
-            = wad_input_stream_read_directory_entry(stream, &e);
-        if (e) {
-            g_propagate_error(error, e);
-            return;
+    guint64 total_read = 12 + (guint64)num_dirs * WAD_DIRECTORY_ENTRY_SIZE;
+    return decode_entries(bytes, directory, total_read, options, error);
+}
+
+// Reads exactly `n` bytes from `stream` into `dest`.
+static bool read_exactly(
+    GInputStream *stream,
+    void *dest,
+    gsize n,
+    GCancellable *cancellable,
+    GError **error
+)
+{
+    gsize bytes_read = 0;
+    GError *e = nullptr;
+    g_input_stream_read_all(stream, dest, n, &bytes_read, cancellable, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return false;
+    }
+    if (bytes_read != n) {
+        g_set_error_literal(
+            error,
+            WAD_LOAD_ERROR,
+            WAD_LOAD_ERROR_TRUNCATED,
+            "Unexpected end of stream"
+        );
+        return false;
+    }
+    return true;
+}
+
+/*
+ * Appends exactly `n` bytes from `stream` to `image`, growing it a chunk at a
+ * time so that a corrupt size only costs memory for data actually present.
+ */
+static bool read_append(
+    GInputStream *stream,
+    GByteArray *image,
+    gsize n,
+    GCancellable *cancellable,
+    GError **error
+)
+{
+    while (n > 0) {
+        gsize chunk = MIN(n, READ_CHUNK_SIZE);
+        gsize start = image->len;
+        g_byte_array_set_size(image, start + chunk);
+        if (!read_exactly(
+                stream,
+                image->data + start,
+                chunk,
+                cancellable,
+                error
+            )) {
+            return false;
         }
-        g_ptr_array_add(directory, entry);
-        g_info(
-            "\nentry %" G_GUINT32_FORMAT
-            " {\n" "  entry_offset = %#x\n" "  disk_size = %" G_GUINT32_FORMAT
-            "\n" "  entry_size = %" G_GUINT32_FORMAT
-            "\n" "  file_type = %hhx\n" "  compressed = %hhu\n" "  texture_name = '%.16s'\n" "}",
-            i,
-            entry->entry_offset,
-            entry->disk_size,
-            entry->entry_size,
-            entry->file_type,
-            entry->compressed,
-            entry->texture_name
+        n -= chunk;
+    }
+    return true;
+}
+
+/*
+ * Loads from a stream in a single forward pass, without seeking.
+ *
+ * The directory normally sits at the end of the file, so everything up to it
+ * is buffered. Then the directory is decoded, any entries stored after it are
+ * read, and the entries are decoded from the buffer as with load_from_bytes().
+ */
+static WadTextureArchive *load_from_sequential_stream(
+    GInputStream *stream,
+    LoadOptions const *options,
+    GError **error
+)
+{
+    GCancellable *cancellable = options->cancellable;
+
+    // Header
+    guchar header[12];
+    if (!read_exactly(stream, header, sizeof(header), cancellable, error)) {
+        return nullptr;
+    }
+    if (strncmp((char const *)header, "WAD3", 4) != 0) {
+        g_set_error(
+            error,
+            WAD_LOAD_ERROR,
+            WAD_LOAD_ERROR_MAGIC,
+            "Bad magic number %.4s",
+            header
+        );
+        return nullptr;
+    }
+    guint32 num_dirs;
+    guint32 dir_offset;
+    memcpy(&num_dirs, header + 4, 4);
+    memcpy(&dir_offset, header + 8, 4);
+    num_dirs = GUINT32_FROM_LE(num_dirs);
+    dir_offset = GUINT32_FROM_LE(dir_offset);
+    if (dir_offset < sizeof(header)) {
+        g_set_error(
+            error,
+            WAD_LOAD_ERROR,
+            WAD_LOAD_ERROR_TRUNCATED,
+            "Directory offset %#x overlaps the header",
+            dir_offset
+        );
+        return nullptr;
+    }
+    if (num_dirs > MAX_DIRECTORY_ENTRIES) {
+        g_set_error(
+            error,
+            WAD_LOAD_ERROR,
+            WAD_LOAD_ERROR_TRUNCATED,
+            "Directory of %" G_GUINT32_FORMAT " entries is too large",
+            num_dirs
         );
+        return nullptr;
+    }
+    gsize dir_size = (gsize)num_dirs * WAD_DIRECTORY_ENTRY_SIZE;
+    if ((guint64)dir_offset + dir_size > G_MAXUINT32) {
+        g_set_error(
+            error,
+            WAD_LOAD_ERROR,
+            WAD_LOAD_ERROR_TRUNCATED,
+            "Directory at %#x runs past the 4 GiB limit of the format",
+            dir_offset
+        );
+        return nullptr;
     }
 
-    // File Entries
-    g_autoptr(WadTextureArchive) archive = wad_texture_archive_new();
+    // Everything up to and including the directory
+    g_autoptr(GByteArray) image = g_byte_array_new();
+    g_byte_array_append(image, header, sizeof(header));
+    if (!read_append(
+            stream,
+            image,
+            dir_offset + dir_size - sizeof(header),
+            cancellable,
+            error
+        )) {
+        return nullptr;
+    }
+    g_autoptr(GArray) directory = g_array_sized_new(
+        FALSE,
+        FALSE,
+        sizeof(WadDirectoryEntry),
+        num_dirs
+    );
+    g_array_set_size(directory, num_dirs);
+    wad_directory_entry_decode(
+        image->data + dir_offset,
+        num_dirs,
+        (WadDirectoryEntry *)directory->data
+    );
+
+    // Entries stored after the directory
+    guint64 end = image->len;
     for (guint i = 0; i < directory->len; ++i) {
-        WadDirectoryEntry *dir_entry = directory->pdata[i];
-        g_seekable_seek(
-            G_SEEKABLE(stream),
-            dir_entry->entry_offset,
-            G_SEEK_SET,
-            nullptr,
-            &e
+        WadDirectoryEntry const *dir_entry
+            = &g_array_index(directory, WadDirectoryEntry, i);
+        end = MAX(end, (guint64)dir_entry->entry_offset + dir_entry->disk_size);
+    }
+    if (end > G_MAXUINT32) {
+        g_set_error_literal(
+            error,
+            WAD_LOAD_ERROR,
+            WAD_LOAD_ERROR_TRUNCATED,
+            "Entry runs past the 4 GiB limit of the format"
+        );
+        return nullptr;
+    }
+    if (end > image->len
+        && !read_append(stream, image, end - image->len, cancellable, error)) {
+        return nullptr;
+    }
+
+    g_autoptr(GBytes) bytes
+        = g_byte_array_free_to_bytes(g_steal_pointer(&image));
+    guint64 bytes_read = sizeof(header) + dir_size;
+    return decode_entries(bytes, directory, bytes_read, options, error);
+}
+
+static WadTextureArchive *
+load_from_file(GFile *file, LoadOptions const *options, GError **error)
+{
+    GError *e = nullptr;
+    g_autoptr(GFileInputStream) stream
+        = g_file_read(file, options->cancellable, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    return load_from_stream(G_INPUT_STREAM(stream), options, error);
+}
+
+static GBytes *map_file(GFile *file, GError **error)
+{
+    g_autofree char *path = g_file_get_path(file);
+    if (!path) {
+        g_autofree char *name = g_file_get_parse_name(file);
+        g_set_error(
+            error,
+            G_IO_ERROR,
+            G_IO_ERROR_NOT_SUPPORTED,
+            "Cannot map '%s': not a local file",
+            name
+        );
+        return nullptr;
+    }
+    GError *e = nullptr;
+    GMappedFile *mapped = g_mapped_file_new(path, FALSE, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    GBytes *bytes = g_mapped_file_get_bytes(mapped);
+    g_mapped_file_unref(mapped);
+    return bytes;
+}
+
+// Async loading
+
+/*
+ * AsyncLoad:
+ *
+ * Task data for wad_root_load_from_file_async(). Reference counted with
+ * g_atomic_rc_box so pending progress reports can outlive the task.
+ */
+typedef struct {
+    WadRoot *root;
+    GFile *file;
+    LoadOptions options;
+    GMainContext *context;
+    GMutex lock;
+    guint n_decoded;
+    guint n_total;
+    guint64 bytes_read;
+    bool report_pending;
+} AsyncLoad;
+
+static void async_load_clear(AsyncLoad *data)
+{
+    g_clear_object(&data->root);
+    g_clear_object(&data->file);
+    g_clear_object(&data->options.cancellable);
+    g_clear_pointer(&data->context, g_main_context_unref);
+    g_mutex_clear(&data->lock);
+}
+
+static void async_load_release(AsyncLoad *data)
+{
+    g_atomic_rc_box_release_full(data, (GDestroyNotify)async_load_clear);
+}
+
+static gboolean async_load_emit_progress(gpointer user_data)
+{
+    AsyncLoad *data = user_data;
+    g_mutex_lock(&data->lock);
+    guint n_decoded = data->n_decoded;
+    guint n_total = data->n_total;
+    guint64 bytes_read = data->bytes_read;
+    data->report_pending = false;
+    g_mutex_unlock(&data->lock);
+
+    g_signal_emit(
+        data->root,
+        obj_signals[SIGNAL_PROGRESS],
+        0,
+        n_decoded,
+        n_total,
+        bytes_read
+    );
+    return G_SOURCE_REMOVE;
+}
+
+// Runs on the loading thread(s). Coalesces reports so at most one is queued on
+// the caller's main context at a time.
+static void async_load_progress(
+    guint n_decoded,
+    guint n_total,
+    guint64 bytes_read,
+    gpointer user_data
+)
+{
+    AsyncLoad *data = user_data;
+    g_mutex_lock(&data->lock);
+    data->n_decoded = n_decoded;
+    data->n_total = n_total;
+    data->bytes_read = bytes_read;
+    bool schedule = !data->report_pending;
+    data->report_pending = true;
+    g_mutex_unlock(&data->lock);
+
+    if (schedule) {
+        g_main_context_invoke_full(
+            data->context,
+            G_PRIORITY_DEFAULT,
+            async_load_emit_progress,
+            g_atomic_rc_box_acquire(data),
+            (GDestroyNotify)async_load_release
+        );
+    }
+}
+
+static void async_load_thread(
+    GTask *task,
+    gpointer,
+    gpointer task_data,
+    GCancellable *
+)
+{
+    AsyncLoad *data = task_data;
+    GError *e = nullptr;
+    WadTextureArchive *archive
+        = load_from_file(data->file, &data->options, &e);
+    if (e) {
+        g_task_return_error(task, e);
+        return;
+    }
+    g_task_return_pointer(task, archive, g_object_unref);
+}
+
+// Watching
+
+/*
+ * Snapshot:
+ * @pending: Index of the texture decoded for this entry by the latest reload,
+ * or -1 if the entry was unchanged.
+ *
+ * An entry of the watched file as it was when last read.
+ */
+typedef struct {
+    WadName key;
+    char name[17];
+    guint32 disk_size;
+    guint8 file_type;
+    guint64 hash;
+    gint pending;
+} Snapshot;
+
+static GHashTable *snapshot_table_new(void)
+{
+    return g_hash_table_new_full(
+        wad_name_hash,
+        wad_name_equal_func,
+        nullptr,
+        g_free
+    );
+}
+
+static bool snapshot_equal(Snapshot const *a, Snapshot const *b)
+{
+    return a->disk_size == b->disk_size && a->file_type == b->file_type
+        && a->hash == b->hash;
+}
+
+// A texture decoded by a reload, to be installed once the reload succeeds.
+typedef struct {
+    WadName key;
+    char name[17];
+    WadDirectoryEntry dir_entry;
+    WadTexture texture;
+} Pending;
+
+static void pending_clear(Pending *pending)
+{
+    wad_texture_clear(&pending->texture);
+}
+
+/*
+ * Reads the entry described by `dir_entry` into a buffer of its own, so that
+ * a texture decoded from it does not hold on to the rest of the file.
+ * `file_size` bounds the entry before anything is allocated for it.
+ */
+static GBytes *read_payload(
+    WadInputStream *stream,
+    WadDirectoryEntry const *dir_entry,
+    guint64 file_size,
+    GError **error
+)
+{
+    if ((guint64)dir_entry->entry_offset + dir_entry->disk_size > file_size) {
+        g_set_error(
+            error,
+            WAD_LOAD_ERROR,
+            WAD_LOAD_ERROR_TRUNCATED,
+            "Entry of %" G_GUINT32_FORMAT " bytes at %#x runs past the end "
+            "of the file",
+            dir_entry->disk_size,
+            dir_entry->entry_offset
         );
+        return nullptr;
+    }
+    GError *e = nullptr;
+    g_seekable_seek(
+        G_SEEKABLE(stream),
+        dir_entry->entry_offset,
+        G_SEEK_SET,
+        nullptr,
+        &e
+    );
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    g_autofree guchar *data = g_malloc(dir_entry->disk_size);
+    if (!read_exactly(
+            G_INPUT_STREAM(stream),
+            data,
+            dir_entry->disk_size,
+            nullptr,
+            error
+        )) {
+        return nullptr;
+    }
+    return g_bytes_new_take(g_steal_pointer(&data), dir_entry->disk_size);
+}
+
+/*
+ * Reads the directory of `file` and every entry's payload, and decodes the
+ * entries which are not in `old` with the same size, type and payload hash.
+ * Entries that only moved within the file are not decoded again.
+ *
+ * On success returns the new snapshot and fills `pending` with the decoded
+ * textures. On failure nothing is changed, so a half-written file can simply
+ * be read again later.
+ */
+static GHashTable *read_changes(
+    GFile *file,
+    GHashTable *old,
+    GArray *pending,
+    GError **error
+)
+{
+    GError *e = nullptr;
+    g_autoptr(GFileInputStream) file_stream = g_file_read(file, nullptr, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    g_autoptr(WadInputStream) stream
+        = wad_input_stream_new(G_INPUT_STREAM(file_stream));
+
+    g_seekable_seek(G_SEEKABLE(stream), 0, G_SEEK_END, nullptr, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    guint64 file_size = g_seekable_tell(G_SEEKABLE(stream));
+    g_seekable_seek(G_SEEKABLE(stream), 0, G_SEEK_SET, nullptr, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+
+    guint32 num_dirs = 0;
+    guint32 dir_offset = 0;
+    wad_input_stream_read_header(stream, &num_dirs, &dir_offset, nullptr, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    g_seekable_seek(G_SEEKABLE(stream), dir_offset, G_SEEK_SET, nullptr, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    g_autoptr(GArray) directory
+        = wad_input_stream_read_directory(stream, num_dirs, nullptr, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return nullptr;
+    }
+    if (!check_directory(directory, error)) {
+        return nullptr;
+    }
+
+    g_autoptr(GHashTable) snapshot = snapshot_table_new();
+    for (guint i = 0; i < directory->len; ++i) {
+        WadDirectoryEntry dir_entry
+            = g_array_index(directory, WadDirectoryEntry, i);
+        g_autoptr(GBytes) bytes
+            = read_payload(stream, &dir_entry, file_size, &e);
         if (e) {
-            g_propagate_error(error, e);
-            return;
-        }
-        switch (dir_entry->file_type) {
-        case WAD_FILE_TYPE_QPIC: {
-            WadQpicFile *qpic = wad_input_stream_read_qpic_file(stream, &e);
-            if (e) {
-                g_propagate_error(error, e);
-                return;
-            }
-            g_info(
-                "%.16s -- Qpic (%" G_GUINT32_FORMAT " x %" G_GUINT32_FORMAT ")",
-                dir_entry->texture_name,
-                qpic->width,
-                qpic->height
-            );
-            GValue *v = g_new0(GValue, 1);
-            g_value_init(v, WAD_TYPE_QPIC_FILE);
-            g_value_take_boxed(v, qpic);
-            wad_texture_archive_add_texture(
-                archive,
-                dir_entry->texture_name,
-                v
-            );
-        } break;
-        case WAD_FILE_TYPE_SPRAYDECAL:
-        case WAD_FILE_TYPE_MIPTEX: {
-            WadMiptexFile *miptex
-                = wad_input_stream_read_miptex_file(stream, &e);
-            if (e) {
-                g_propagate_error(error, e);
-                return;
-            }
-            g_info("%.16s -- miptex/spraydecal", dir_entry->texture_name);
-            GValue *v = g_new0(GValue, 1);
-            g_value_init(v, WAD_TYPE_MIPTEX_FILE);
-            g_value_take_boxed(v, miptex);
-            wad_texture_archive_add_texture(
-                archive,
-                dir_entry->texture_name,
-                v
-            );
-        } break;
-        case WAD_FILE_TYPE_FONT: {
-            WadFontFile *font = wad_input_stream_read_font_file(stream, &e);
-            if (e) {
-                g_propagate_error(error, e);
-                return;
-            }
-            g_info(
-                "%.16s -- font (%" G_GUINT32_FORMAT " rows)",
-                dir_entry->texture_name,
-                font->row_count
-            );
-            GValue *v = g_new0(GValue, 1);
-            g_value_init(v, WAD_TYPE_FONT_FILE);
-            g_value_take_boxed(v, font);
-            wad_texture_archive_add_texture(
-                archive,
-                dir_entry->texture_name,
-                v
+            g_propagate_prefixed_error(
+                error,
+                e,
+                "Texture '%.16s': ",
+                dir_entry.texture_name
             );
-        } break;
-        default:
-            g_set_error(
+            return nullptr;
+        }
+
+        Snapshot *entry = g_new0(Snapshot, 1);
+        memcpy(entry->name, dir_entry.texture_name, 16);
+        wad_name_init(&entry->key, entry->name);
+        entry->disk_size = dir_entry.disk_size;
+        entry->file_type = dir_entry.file_type;
+        gsize size = 0;
+        gconstpointer data = g_bytes_get_data(bytes, &size);
+        entry->hash = wad_hash_bytes(0, data, size);
+        entry->pending = -1;
+        // Later entries of the same name win, as with a full load.
+        g_hash_table_replace(snapshot, &entry->key, entry);
+
+        Snapshot const *previous
+            = old ? g_hash_table_lookup(old, &entry->key) : nullptr;
+        if (previous && snapshot_equal(previous, entry)) {
+            continue;
+        }
+        WadByteReader reader;
+        wad_byte_reader_init(&reader, bytes);
+        dir_entry.entry_offset = 0;
+        WadTexture texture
+            = wad_byte_reader_read_entry(&reader, &dir_entry, &e);
+        wad_byte_reader_clear(&reader);
+        if (e) {
+            g_propagate_prefixed_error(
                 error,
-                WAD_LOAD_ERROR,
-                WAD_LOAD_ERROR_FILE_TYPE,
-                "unknown file type %#hhx",
-                dir_entry->file_type
+                e,
+                "Texture '%s': ",
+                entry->name
             );
-            return;
-            break;
+            return nullptr;
         }
+        Pending decoded = {
+            .key = entry->key,
+            .dir_entry = dir_entry,
+            .texture = texture,
+        };
+        memcpy(decoded.name, entry->name, sizeof(decoded.name));
+        entry->pending = pending->len;
+        g_array_append_val(pending, decoded);
+    }
+    return g_steal_pointer(&snapshot);
+}
+
+static void emit_changes(WadRoot *self, enum Signal signal, GPtrArray *names)
+{
+    for (guint i = 0; i < names->len; ++i) {
+        g_signal_emit(self, obj_signals[signal], 0, names->pdata[i]);
+    }
+}
+
+static void stop_watching(WadRoot *self)
+{
+    if (self->monitor) {
+        g_signal_handlers_disconnect_by_data(self->monitor, self);
+        g_file_monitor_cancel(self->monitor);
+    }
+    g_clear_object(&self->monitor);
+    g_clear_object(&self->watched_file);
+    g_clear_pointer(&self->snapshot, g_hash_table_unref);
+}
+
+static void on_watched_file_changed(
+    GFileMonitor *,
+    GFile *,
+    GFile *,
+    GFileMonitorEvent event,
+    gpointer user_data
+)
+{
+    WadRoot *self = user_data;
+    if (event != G_FILE_MONITOR_EVENT_CHANGES_DONE_HINT
+        && event != G_FILE_MONITOR_EVENT_CREATED) {
+        return;
+    }
+    g_autoptr(GError) e = nullptr;
+    wad_root_reload(self, &e);
+    if (e) {
+        // Most likely caught mid-write; the next change reloads again.
+        g_info("Failed to reload watched WAD: %s", e->message);
     }
-    self->archive = g_object_ref(archive);
 }
 
 // GObject /////////////////////////////////////////////////////////////////////
@@ -194,20 +996,192 @@ void load_from_stream(WadRoot *self, GInputStream *base_stream, GError **error)
 static void wad_root_dispose(GObject *object)
 {
     WadRoot *self = WAD_ROOT(object);
+    stop_watching(self);
     g_clear_object(&self->archive);
     G_OBJECT_CLASS(wad_root_parent_class)->dispose(object);
 }
 
+static void wad_root_set_property(
+    GObject *object,
+    guint property_id,
+    GValue const *value,
+    GParamSpec *pspec
+)
+{
+    WadRoot *self = WAD_ROOT(object);
+    switch ((enum Property)property_id) {
+    case PROP_LAZY:
+        wad_root_set_lazy(self, g_value_get_boolean(value));
+        break;
+    case PROP_N_THREADS:
+        wad_root_set_n_threads(self, g_value_get_uint(value));
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
+    }
+}
+
+static void wad_root_get_property(
+    GObject *object,
+    guint property_id,
+    GValue *value,
+    GParamSpec *pspec
+)
+{
+    WadRoot *self = WAD_ROOT(object);
+    switch ((enum Property)property_id) {
+    case PROP_LAZY:
+        g_value_set_boolean(value, self->lazy);
+        break;
+    case PROP_N_THREADS:
+        g_value_set_uint(value, self->n_threads);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID(object, property_id, pspec);
+    }
+}
+
 // WadRoot /////////////////////////////////////////////////////////////////////
 
 static void wad_root_class_init(WadRootClass *klass)
 {
     GObjectClass *oclass = G_OBJECT_CLASS(klass);
     oclass->dispose = wad_root_dispose;
+    oclass->set_property = wad_root_set_property;
+    oclass->get_property = wad_root_get_property;
+
+    /**
+     * WadRoot:lazy
+     * Whether subsequent loads defer decoding textures until they are first
+     * requested from the [class@WadTextureArchive].
+     *
+     * A lazily-loaded archive keeps its source stream or mapping open until
+     * every texture has been decoded or the archive is freed.
+     */
+    obj_properties[PROP_LAZY] = g_param_spec_boolean(
+        "lazy",
+        nullptr,
+        nullptr,
+        FALSE,
+        G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY
+    );
+
+    /**
+     * WadRoot:n-threads
+     * Number of threads used to decode textures, or 0 to use one per
+     * processor.
+     *
+     * Only wad_root_load_from_mapped_file() and
+     * wad_root_load_from_sequential_stream() decode in parallel, since each
+     * worker needs its own view of the data in memory. Other loaders, and
+     * lazy loads, ignore this property.
+     */
+    obj_properties[PROP_N_THREADS] = g_param_spec_uint(
+        "n-threads",
+        nullptr,
+        nullptr,
+        0,
+        G_MAXUINT,
+        1,
+        G_PARAM_READWRITE | G_PARAM_EXPLICIT_NOTIFY
+    );
+
+    g_object_class_install_properties(oclass, N_PROPERTIES, obj_properties);
+
+    /**
+     * WadRoot::progress:
+     * @root: The [class@WadRoot].
+     * @n_decoded: Number of entries decoded so far.
+     * @n_total: Number of entries in the WAD.
+     * @bytes_read: Number of bytes read so far.
+     *
+     * Emitted during wad_root_load_from_file_async(), on the thread-default
+     * main context of the caller. Reports are coalesced, so not every entry
+     * produces an emission.
+     */
+    obj_signals[SIGNAL_PROGRESS] = g_signal_new(
+        "progress",
+        G_TYPE_FROM_CLASS(klass),
+        G_SIGNAL_RUN_LAST,
+        0,
+        nullptr,
+        nullptr,
+        nullptr,
+        G_TYPE_NONE,
+        3,
+        G_TYPE_UINT,
+        G_TYPE_UINT,
+        G_TYPE_UINT64
+    );
+
+    /**
+     * WadRoot::texture-added:
+     * @root: The [class@WadRoot].
+     * @texture_name: Name of the new texture.
+     *
+     * Emitted when a reload of the watched file finds a texture that was not
+     * in it before. See wad_root_watch_file().
+     */
+    obj_signals[SIGNAL_TEXTURE_ADDED] = g_signal_new(
+        "texture-added",
+        G_TYPE_FROM_CLASS(klass),
+        G_SIGNAL_RUN_LAST,
+        0,
+        nullptr,
+        nullptr,
+        nullptr,
+        G_TYPE_NONE,
+        1,
+        G_TYPE_STRING
+    );
+
+    /**
+     * WadRoot::texture-changed:
+     * @root: The [class@WadRoot].
+     * @texture_name: Name of the texture.
+     *
+     * Emitted when a reload of the watched file finds that the content of a
+     * texture has changed. The archive holds the new texture by the time this
+     * is emitted.
+     */
+    obj_signals[SIGNAL_TEXTURE_CHANGED] = g_signal_new(
+        "texture-changed",
+        G_TYPE_FROM_CLASS(klass),
+        G_SIGNAL_RUN_LAST,
+        0,
+        nullptr,
+        nullptr,
+        nullptr,
+        G_TYPE_NONE,
+        1,
+        G_TYPE_STRING
+    );
+
+    /**
+     * WadRoot::texture-removed:
+     * @root: The [class@WadRoot].
+     * @texture_name: Name of the texture.
+     *
+     * Emitted when a reload of the watched file finds that a texture is gone.
+     * The texture has already been removed from the archive.
+     */
+    obj_signals[SIGNAL_TEXTURE_REMOVED] = g_signal_new(
+        "texture-removed",
+        G_TYPE_FROM_CLASS(klass),
+        G_SIGNAL_RUN_LAST,
+        0,
+        nullptr,
+        nullptr,
+        nullptr,
+        G_TYPE_NONE,
+        1,
+        G_TYPE_STRING
+    );
 }
 
-static void wad_root_init(WadRoot *)
+static void wad_root_init(WadRoot *self)
 {
+    self->n_threads = 1;
 }
 
 // Public //////////////////////////////////////////////////////////////////////
@@ -217,8 +1191,8 @@ static void wad_root_init(WadRoot *)
  *
  * Creates a new empty [class@WadRoot] object.
  *
- * Use wad_root_load_from_file() or wad_root_load_from_stream() to read an
- * existing WAD file.
+ * Use wad_root_load_from_file(), wad_root_load_from_mapped_file() or
+ * wad_root_load_from_stream() to read an existing WAD file.
  *
  * Returns: An empty [class@WadRoot].
  */
@@ -234,6 +1208,9 @@ WadRoot *wad_root_new(void)
  * @error: The return location for [struct@GError].
  *
  * Loads a WAD texture archive from `stream`.
+ *
+ * If `stream` cannot seek, this falls back to
+ * wad_root_load_from_sequential_stream().
  */
 void
 wad_root_load_from_stream(WadRoot *self, GInputStream *stream, GError **error)
@@ -241,7 +1218,48 @@ wad_root_load_from_stream(WadRoot *self, GInputStream *stream, GError **error)
     g_return_if_fail(WAD_IS_ROOT(self));
     g_return_if_fail(G_IS_INPUT_STREAM(stream));
     g_return_if_fail(error == nullptr || *error == nullptr);
-    load_from_stream(self, stream, error);
+
+    stop_watching(self);
+    g_clear_object(&self->archive);
+    LoadOptions options = load_options_init(self, nullptr);
+    if (G_IS_SEEKABLE(stream) && g_seekable_can_seek(G_SEEKABLE(stream))) {
+        self->archive = load_from_stream(stream, &options, error);
+    } else {
+        self->archive = load_from_sequential_stream(stream, &options, error);
+    }
+}
+
+/**
+ * wad_root_load_from_sequential_stream:
+ * @root: A [class@WadRoot].
+ * @stream: The stream to load from.
+ * @error: The return location for [struct@GError].
+ *
+ * Loads a WAD texture archive from `stream` in a single forward pass, without
+ * seeking. This works with pipes, decompressors and network streams.
+ *
+ * Everything up to the end of the directory, which is usually at the end of
+ * the file, is buffered in memory and the entries are decoded from that
+ * buffer. As with wad_root_load_from_mapped_file(), the loaded textures hold
+ * [struct@GLib.Bytes] views of the buffer instead of [struct@GLib.Array]s.
+ *
+ * wad_root_load_from_stream() uses this automatically for streams that cannot
+ * seek.
+ */
+void wad_root_load_from_sequential_stream(
+    WadRoot *self,
+    GInputStream *stream,
+    GError **error
+)
+{
+    g_return_if_fail(WAD_IS_ROOT(self));
+    g_return_if_fail(G_IS_INPUT_STREAM(stream));
+    g_return_if_fail(error == nullptr || *error == nullptr);
+
+    stop_watching(self);
+    g_clear_object(&self->archive);
+    LoadOptions options = load_options_init(self, nullptr);
+    self->archive = load_from_sequential_stream(stream, &options, error);
 }
 
 /**
@@ -251,6 +1269,9 @@ wad_root_load_from_stream(WadRoot *self, GInputStream *stream, GError **error)
  * @error: The return location for [struct@GError].
  *
  * Loads a WAD texture archive from `file`.
+ *
+ * See wad_root_load_from_file_async() for the asynchronous version of this
+ * function.
  */
 void wad_root_load_from_file(WadRoot *self, GFile *file, GError **error)
 {
@@ -258,13 +1279,398 @@ void wad_root_load_from_file(WadRoot *self, GFile *file, GError **error)
     g_return_if_fail(G_IS_FILE(file));
     g_return_if_fail(error == nullptr || *error == nullptr);
 
+    stop_watching(self);
+    g_clear_object(&self->archive);
+    LoadOptions options = load_options_init(self, nullptr);
+    self->archive = load_from_file(file, &options, error);
+}
+
+/**
+ * wad_root_load_from_file_async:
+ * @root: A [class@WadRoot].
+ * @file: The file to load from.
+ * @cancellable: (nullable): A [class@Gio.Cancellable].
+ * @callback: (scope async): Callback to call when the load completes.
+ * @user_data: Data to pass to @callback.
+ *
+ * Asynchronously loads a WAD texture archive from `file` on a worker thread.
+ *
+ * [signal@WadRoot::progress] is emitted while the load runs. Cancelling
+ * @cancellable stops the load between entries. The current archive is kept
+ * until the load finishes; call wad_root_load_from_file_finish() from
+ * @callback to install the new one.
+ */
+void wad_root_load_from_file_async(
+    WadRoot *self,
+    GFile *file,
+    GCancellable *cancellable,
+    GAsyncReadyCallback callback,
+    gpointer user_data
+)
+{
+    g_return_if_fail(WAD_IS_ROOT(self));
+    g_return_if_fail(G_IS_FILE(file));
+    g_return_if_fail(cancellable == nullptr || G_IS_CANCELLABLE(cancellable));
+
+    AsyncLoad *data = g_atomic_rc_box_new0(AsyncLoad);
+    data->root = g_object_ref(self);
+    data->file = g_object_ref(file);
+    data->options = load_options_init(self, cancellable);
+    if (cancellable) {
+        g_object_ref(cancellable);
+    }
+    data->options.progress = async_load_progress;
+    data->options.progress_data = data;
+    data->context = g_main_context_ref_thread_default();
+    g_mutex_init(&data->lock);
+
+    g_autoptr(GTask) task = g_task_new(self, cancellable, callback, user_data);
+    g_task_set_source_tag(task, wad_root_load_from_file_async);
+    g_task_set_task_data(task, data, (GDestroyNotify)async_load_release);
+    g_task_run_in_thread(task, async_load_thread);
+}
+
+/**
+ * wad_root_load_from_file_finish:
+ * @root: A [class@WadRoot].
+ * @result: The [iface@Gio.AsyncResult] passed to the callback.
+ * @error: The return location for [struct@GError].
+ *
+ * Finishes a load started with wad_root_load_from_file_async().
+ *
+ * On success the loaded archive replaces the current one. On failure, as with
+ * wad_root_load_from_file(), the archive is cleared.
+ *
+ * Returns: `TRUE` if the load succeeded.
+ */
+gboolean wad_root_load_from_file_finish(
+    WadRoot *self,
+    GAsyncResult *result,
+    GError **error
+)
+{
+    g_return_val_if_fail(WAD_IS_ROOT(self), FALSE);
+    g_return_val_if_fail(g_task_is_valid(result, self), FALSE);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
+
+    stop_watching(self);
+    g_clear_object(&self->archive);
+    self->archive = g_task_propagate_pointer(G_TASK(result), error);
+    return self->archive != nullptr;
+}
+
+/**
+ * wad_root_load_from_mapped_file:
+ * @root: A [class@WadRoot].
+ * @file: The file to load from. Must have a local path.
+ * @error: The return location for [struct@GError].
+ *
+ * Loads a WAD texture archive from `file` by mapping it into memory.
+ *
+ * Unlike wad_root_load_from_file(), image and palette data are not copied:
+ * the loaded textures hold [struct@GLib.Bytes] views of the mapping in their
+ * `mip_bytes`, `data_bytes` and `palette_bytes` fields (and similar), and their
+ * [struct@GLib.Array] fields are left `NULL`. The mapping is released when the
+ * last texture referencing it is freed.
+ *
+ * The file must not be truncated or modified while it is mapped.
+ */
+void wad_root_load_from_mapped_file(WadRoot *self, GFile *file, GError **error)
+{
+    g_return_if_fail(WAD_IS_ROOT(self));
+    g_return_if_fail(G_IS_FILE(file));
+    g_return_if_fail(error == nullptr || *error == nullptr);
+
+    stop_watching(self);
+    g_clear_object(&self->archive);
+    GError *e = nullptr;
+    g_autoptr(GBytes) bytes = map_file(file, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return;
+    }
+    LoadOptions options = load_options_init(self, nullptr);
+    self->archive = load_from_bytes(bytes, &options, error);
+}
+
+/**
+ * wad_root_save_to_stream:
+ * @root: A [class@WadRoot].
+ * @stream: The stream to write to.
+ * @error: The return location for [struct@GError].
+ *
+ * Writes the texture archive to `stream` as a WAD3 file. The stream is written
+ * front to back and does not need to be seekable.
+ *
+ * See wad_output_stream_write_archive().
+ */
+void
+wad_root_save_to_stream(WadRoot *self, GOutputStream *stream, GError **error)
+{
+    g_return_if_fail(WAD_IS_ROOT(self));
+    g_return_if_fail(self->archive != nullptr);
+    g_return_if_fail(G_IS_OUTPUT_STREAM(stream));
+    g_return_if_fail(error == nullptr || *error == nullptr);
+
+    g_autoptr(WadOutputStream) wad_stream = wad_output_stream_new(stream);
+    g_filter_output_stream_set_close_base_stream(
+        G_FILTER_OUTPUT_STREAM(wad_stream),
+        FALSE
+    );
+    wad_output_stream_write_archive(wad_stream, self->archive, nullptr, error);
+}
+
+/**
+ * wad_root_save_to_file:
+ * @root: A [class@WadRoot].
+ * @file: The file to write to.
+ * @error: The return location for [struct@GError].
+ *
+ * Writes the texture archive to `file` as a WAD3 file, replacing it. The file
+ * is only replaced once the archive has been written in full, so it is safe to
+ * save over the file the archive was loaded from, even if it was mapped with
+ * wad_root_load_from_mapped_file().
+ */
+void wad_root_save_to_file(WadRoot *self, GFile *file, GError **error)
+{
+    g_return_if_fail(WAD_IS_ROOT(self));
+    g_return_if_fail(self->archive != nullptr);
+    g_return_if_fail(G_IS_FILE(file));
+    g_return_if_fail(error == nullptr || *error == nullptr);
+
+    GError *e = nullptr;
+    g_autoptr(GFileOutputStream) stream = g_file_replace(
+        file,
+        nullptr,
+        FALSE,
+        G_FILE_CREATE_REPLACE_DESTINATION,
+        nullptr,
+        &e
+    );
+    if (e) {
+        g_propagate_error(error, e);
+        return;
+    }
+    wad_root_save_to_stream(self, G_OUTPUT_STREAM(stream), &e);
+    if (e) {
+        // Closing with a cancelled cancellable leaves the original file be.
+        g_autoptr(GCancellable) cancel = g_cancellable_new();
+        g_cancellable_cancel(cancel);
+        g_output_stream_close(G_OUTPUT_STREAM(stream), cancel, nullptr);
+        g_propagate_error(error, e);
+        return;
+    }
+    g_output_stream_close(G_OUTPUT_STREAM(stream), nullptr, error);
+}
+
+/**
+ * wad_root_watch_file:
+ * @root: A [class@WadRoot].
+ * @file: The file to load from and watch.
+ * @error: The return location for [struct@GError].
+ *
+ * Loads a WAD texture archive from `file`, as wad_root_load_from_file() does,
+ * and keeps it up to date as the file changes on disk.
+ *
+ * A change to the file triggers wad_root_reload() from the thread-default
+ * main context. The archive is updated in place, and
+ * [signal@WadRoot::texture-added], [signal@WadRoot::texture-changed] and
+ * [signal@WadRoot::texture-removed] are emitted for each affected texture.
+ * No signals are emitted for the initial load.
+ *
+ * Textures are always decoded up front, whatever [property@WadRoot:lazy] is
+ * set to. Watching stops when another file is loaded, on
+ * wad_root_unwatch(), or if the initial load fails.
+ */
+void wad_root_watch_file(WadRoot *self, GFile *file, GError **error)
+{
+    g_return_if_fail(WAD_IS_ROOT(self));
+    g_return_if_fail(G_IS_FILE(file));
+    g_return_if_fail(error == nullptr || *error == nullptr);
+
+    stop_watching(self);
+    g_clear_object(&self->archive);
+
+    GError *e = nullptr;
+    g_autoptr(WadTextureArchive) archive = wad_texture_archive_new();
+    g_autoptr(GArray) pending = g_array_new(FALSE, FALSE, sizeof(Pending));
+    g_array_set_clear_func(pending, (GDestroyNotify)pending_clear);
+    g_autoptr(GHashTable) snapshot = read_changes(file, nullptr, pending, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return;
+    }
+    g_autoptr(GFileMonitor) monitor
+        = g_file_monitor_file(file, G_FILE_MONITOR_NONE, nullptr, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return;
+    }
+    for (guint i = 0; i < pending->len; ++i) {
+        Pending *decoded = &g_array_index(pending, Pending, i);
+        wad_texture_archive_take_entry(
+            archive,
+            &decoded->dir_entry,
+            &decoded->texture
+        );
+    }
+    g_signal_connect(
+        monitor,
+        "changed",
+        G_CALLBACK(on_watched_file_changed),
+        self
+    );
+    self->archive = g_steal_pointer(&archive);
+    self->watched_file = g_object_ref(file);
+    self->monitor = g_steal_pointer(&monitor);
+    self->snapshot = g_steal_pointer(&snapshot);
+}
+
+/**
+ * wad_root_reload:
+ * @root: A [class@WadRoot] watching a file.
+ * @error: The return location for [struct@GError].
+ *
+ * Brings the archive up to date with the file given to
+ * wad_root_watch_file(), without waiting for the file monitor.
+ *
+ * The whole directory is read again, and each entry is compared with the
+ * previous load by its size, type and a hash of its payload. Only entries
+ * that are new or different are decoded. If the file cannot be read, the
+ * archive is left as it was.
+ *
+ * Replaced and removed textures are dropped from any [class@WadRgbaCache] or
+ * [class@WadContentRegistry] using the archive, through
+ * [signal@WadTextureArchive::texture-invalidated].
+ */
+void wad_root_reload(WadRoot *self, GError **error)
+{
+    g_return_if_fail(WAD_IS_ROOT(self));
+    g_return_if_fail(self->watched_file != nullptr);
+    g_return_if_fail(error == nullptr || *error == nullptr);
+
     GError *e = nullptr;
-    g_autoptr(GFileInputStream) stream = g_file_read(file, nullptr, &e);
+    g_autoptr(GArray) pending = g_array_new(FALSE, FALSE, sizeof(Pending));
+    g_array_set_clear_func(pending, (GDestroyNotify)pending_clear);
+    g_autoptr(GHashTable) snapshot
+        = read_changes(self->watched_file, self->snapshot, pending, &e);
     if (e) {
         g_propagate_error(error, e);
         return;
     }
-    load_from_stream(self, G_INPUT_STREAM(stream), error);
+
+    // Signals are emitted once the archive is fully updated. A handler may
+    // drop the last reference to the root, so hold one until then.
+    g_autoptr(WadRoot) root = g_object_ref(self);
+    g_autoptr(GPtrArray) added = g_ptr_array_new_with_free_func(g_free);
+    g_autoptr(GPtrArray) changed = g_ptr_array_new_with_free_func(g_free);
+    g_autoptr(GPtrArray) removed = g_ptr_array_new_with_free_func(g_free);
+    for (guint i = 0; i < pending->len; ++i) {
+        Pending *decoded = &g_array_index(pending, Pending, i);
+        Snapshot const *entry = g_hash_table_lookup(snapshot, &decoded->key);
+        if (entry->pending != (gint)i) {
+            // Overridden by a later entry of the same name.
+            continue;
+        }
+        bool existed = g_hash_table_contains(self->snapshot, &decoded->key);
+        wad_texture_archive_take_entry(
+            self->archive,
+            &decoded->dir_entry,
+            &decoded->texture
+        );
+        g_ptr_array_add(existed ? changed : added, g_strdup(decoded->name));
+    }
+    GHashTableIter iter;
+    Snapshot const *entry;
+    g_hash_table_iter_init(&iter, self->snapshot);
+    while (g_hash_table_iter_next(&iter, nullptr, (gpointer *)&entry)) {
+        if (!g_hash_table_contains(snapshot, &entry->key)) {
+            wad_texture_archive_remove_texture(self->archive, entry->name);
+            g_ptr_array_add(removed, g_strdup(entry->name));
+        }
+    }
+    g_clear_pointer(&self->snapshot, g_hash_table_unref);
+    self->snapshot = g_steal_pointer(&snapshot);
+
+    emit_changes(self, SIGNAL_TEXTURE_REMOVED, removed);
+    emit_changes(self, SIGNAL_TEXTURE_ADDED, added);
+    emit_changes(self, SIGNAL_TEXTURE_CHANGED, changed);
+}
+
+/**
+ * wad_root_unwatch:
+ * @root: A [class@WadRoot].
+ *
+ * Stops watching the file given to wad_root_watch_file(). The archive is
+ * kept as it is.
+ */
+void wad_root_unwatch(WadRoot *self)
+{
+    g_return_if_fail(WAD_IS_ROOT(self));
+    stop_watching(self);
+}
+
+/**
+ * wad_root_set_lazy:
+ * @root: A [class@WadRoot].
+ * @lazy: Whether to load lazily.
+ *
+ * Sets [property@WadRoot:lazy].
+ */
+void wad_root_set_lazy(WadRoot *self, gboolean lazy)
+{
+    g_return_if_fail(WAD_IS_ROOT(self));
+    if (self->lazy != !!lazy) {
+        self->lazy = lazy;
+        g_object_notify_by_pspec(G_OBJECT(self), obj_properties[PROP_LAZY]);
+    }
+}
+
+/**
+ * wad_root_get_lazy:
+ * @root: A [class@WadRoot].
+ *
+ * Gets [property@WadRoot:lazy].
+ *
+ * Returns: Whether loading is lazy.
+ */
+gboolean wad_root_get_lazy(WadRoot *self)
+{
+    g_return_val_if_fail(WAD_IS_ROOT(self), FALSE);
+    return self->lazy;
+}
+
+/**
+ * wad_root_set_n_threads:
+ * @root: A [class@WadRoot].
+ * @n_threads: Number of decoding threads, or 0 for one per processor.
+ *
+ * Sets [property@WadRoot:n-threads].
+ */
+void wad_root_set_n_threads(WadRoot *self, guint n_threads)
+{
+    g_return_if_fail(WAD_IS_ROOT(self));
+    if (self->n_threads != n_threads) {
+        self->n_threads = n_threads;
+        g_object_notify_by_pspec(
+            G_OBJECT(self),
+            obj_properties[PROP_N_THREADS]
+        );
+    }
+}
+
+/**
+ * wad_root_get_n_threads:
+ * @root: A [class@WadRoot].
+ *
+ * Gets [property@WadRoot:n-threads].
+ *
+ * Returns: Number of decoding threads, or 0 for one per processor.
+ */
+guint wad_root_get_n_threads(WadRoot *self)
+{
+    g_return_val_if_fail(WAD_IS_ROOT(self), 0);
+    return self->n_threads;
 }
 
 /**
@@ -16,8 +16,45 @@ WadRoot *wad_root_new(void);
 void
 wad_root_load_from_stream(WadRoot *root, GInputStream *stream, GError **error);
 
+void wad_root_load_from_sequential_stream(
+    WadRoot *root,
+    GInputStream *stream,
+    GError **error
+);
+
 void wad_root_load_from_file(WadRoot *root, GFile *file, GError **error);
 
+void wad_root_load_from_file_async(
+    WadRoot *root,
+    GFile *file,
+    GCancellable *cancellable,
+    GAsyncReadyCallback callback,
+    gpointer user_data
+);
+gboolean wad_root_load_from_file_finish(
+    WadRoot *root,
+    GAsyncResult *result,
+    GError **error
+);
+
+void
+wad_root_load_from_mapped_file(WadRoot *root, GFile *file, GError **error);
+
+void
+wad_root_save_to_stream(WadRoot *root, GOutputStream *stream, GError **error);
+
+void wad_root_save_to_file(WadRoot *root, GFile *file, GError **error);
+
+void wad_root_watch_file(WadRoot *root, GFile *file, GError **error);
+void wad_root_reload(WadRoot *root, GError **error);
+void wad_root_unwatch(WadRoot *root);
+
+void wad_root_set_lazy(WadRoot *root, gboolean lazy);
+gboolean wad_root_get_lazy(WadRoot *root);
+
+void wad_root_set_n_threads(WadRoot *root, guint n_threads);
+guint wad_root_get_n_threads(WadRoot *root);
+
 WadTextureArchive *wad_root_get_archive(WadRoot *root);
 
 G_END_DECLS
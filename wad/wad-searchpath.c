@@ -0,0 +1,265 @@
+#include "wad-searchpath.h"
+
+#include "wad-private.h"
+#include "wad-root.h"
+
+/**
+ * WadSearchPath:
+ *
+ * An ordered list of texture archives searched as one.
+ *
+ * Names from every archive are merged into a single index when the archive is
+ * appended, so finding which archive holds a texture costs one lookup no
+ * matter how many archives there are. As with the engine's WAD list, archives
+ * appended earlier take priority: if two archives contain the same name, the
+ * first one wins.
+ *
+ * Files appended with wad_search_path_append_file() are loaded lazily, so
+ * only the textures that are actually requested are ever decoded.
+ *
+ * The index is a snapshot of each archive's names at the time it was
+ * appended. Textures added to an archive afterwards are not found.
+ */
+struct _WadSearchPath {
+    GObject parent_instance;
+    GPtrArray *archives; // Array<WadTextureArchive>
+    WadNameIndex index;  // Folded name -> position in archives
+};
+
+G_DEFINE_FINAL_TYPE(WadSearchPath, wad_search_path, G_TYPE_OBJECT)
+
+// Private /////////////////////////////////////////////////////////////////////
+
+static WadTextureArchive *
+find_archive(WadSearchPath *self, char const *texture_name)
+{
+    WadName key;
+    guint i = 0;
+    wad_name_init(&key, texture_name);
+    if (!wad_name_index_lookup(&self->index, &key, &i)) {
+        return nullptr;
+    }
+    return g_ptr_array_index(self->archives, i);
+}
+
+// GObject /////////////////////////////////////////////////////////////////////
+
+static void wad_search_path_finalize(GObject *object)
+{
+    WadSearchPath *self = WAD_SEARCH_PATH(object);
+    g_clear_pointer(&self->archives, g_ptr_array_unref);
+    wad_name_index_clear(&self->index);
+    G_OBJECT_CLASS(wad_search_path_parent_class)->finalize(object);
+}
+
+// WadSearchPath ///////////////////////////////////////////////////////////////
+
+static void wad_search_path_class_init(WadSearchPathClass *klass)
+{
+    GObjectClass *oclass = G_OBJECT_CLASS(klass);
+    oclass->finalize = wad_search_path_finalize;
+}
+
+static void wad_search_path_init(WadSearchPath *self)
+{
+    self->archives = g_ptr_array_new_with_free_func(g_object_unref);
+    wad_name_index_init(&self->index);
+}
+
+// Public //////////////////////////////////////////////////////////////////////
+
+/**
+ * wad_search_path_new:
+ *
+ * Creates an empty search path.
+ *
+ * Returns: A new [class@WadSearchPath].
+ */
+WadSearchPath *wad_search_path_new(void)
+{
+    return g_object_new(WAD_TYPE_SEARCH_PATH, nullptr);
+}
+
+/**
+ * wad_search_path_append_file:
+ * @search_path: A [class@WadSearchPath].
+ * @file: The WAD file to add.
+ * @error: The return location for [struct@GError].
+ *
+ * Lazily loads `file` and appends it to the end of the search path, after
+ * every archive already added.
+ */
+void wad_search_path_append_file(
+    WadSearchPath *self,
+    GFile *file,
+    GError **error
+)
+{
+    g_return_if_fail(WAD_IS_SEARCH_PATH(self));
+    g_return_if_fail(G_IS_FILE(file));
+    g_return_if_fail(error == nullptr || *error == nullptr);
+
+    g_autoptr(WadRoot) root = wad_root_new();
+    GError *e = nullptr;
+
+    wad_root_set_lazy(root, TRUE);
+    wad_root_load_from_file(root, file, &e);
+    if (e) {
+        g_propagate_error(error, e);
+        return;
+    }
+    wad_search_path_append_archive(self, wad_root_get_archive(root));
+}
+
+/**
+ * wad_search_path_append_archive:
+ * @search_path: A [class@WadSearchPath].
+ * @archive: The archive to add.
+ *
+ * Appends `archive` to the end of the search path, after every archive already
+ * added. Names it shares with an earlier archive are shadowed.
+ */
+void wad_search_path_append_archive(
+    WadSearchPath *self,
+    WadTextureArchive *archive
+)
+{
+    g_return_if_fail(WAD_IS_SEARCH_PATH(self));
+    g_return_if_fail(WAD_IS_TEXTURE_ARCHIVE(archive));
+
+    guint position = self->archives->len;
+    g_ptr_array_add(self->archives, g_object_ref(archive));
+
+    g_autofree char const **names = wad_texture_archive_get_names(archive);
+    for (char const **name = names; *name != nullptr; ++name) {
+        WadName key;
+        wad_name_init(&key, *name);
+        if (!wad_name_index_lookup(&self->index, &key, nullptr)) {
+            wad_name_index_insert(&self->index, &key, position);
+        }
+    }
+}
+
+/**
+ * wad_search_path_get_n_archives:
+ * @search_path: A [class@WadSearchPath].
+ *
+ * Gets the number of archives in the search path.
+ *
+ * Returns: The number of archives.
+ */
+guint wad_search_path_get_n_archives(WadSearchPath *self)
+{
+    g_return_val_if_fail(WAD_IS_SEARCH_PATH(self), 0);
+    return self->archives->len;
+}
+
+/**
+ * wad_search_path_get_archive:
+ * @search_path: A [class@WadSearchPath].
+ * @index: Position of the archive, in the order they were appended.
+ *
+ * Gets an archive from the search path.
+ *
+ * Returns: (transfer none): The archive.
+ */
+WadTextureArchive *
+wad_search_path_get_archive(WadSearchPath *self, guint index)
+{
+    g_return_val_if_fail(WAD_IS_SEARCH_PATH(self), nullptr);
+    g_return_val_if_fail(index < self->archives->len, nullptr);
+    return g_ptr_array_index(self->archives, index);
+}
+
+/**
+ * wad_search_path_find:
+ * @search_path: A [class@WadSearchPath].
+ * @texture_name: Name of the texture.
+ *
+ * Finds which archive provides a texture, without decoding it.
+ *
+ * Returns: The position of the first archive containing `texture_name`, or -1
+ * if none does.
+ */
+gint wad_search_path_find(WadSearchPath *self, char const *texture_name)
+{
+    g_return_val_if_fail(WAD_IS_SEARCH_PATH(self), -1);
+    g_return_val_if_fail(texture_name != nullptr, -1);
+
+    WadName key;
+    guint i = 0;
+    wad_name_init(&key, texture_name);
+    if (!wad_name_index_lookup(&self->index, &key, &i)) {
+        return -1;
+    }
+    return (gint)i;
+}
+
+/**
+ * wad_search_path_get_miptex:
+ * @search_path: A [class@WadSearchPath].
+ * @texture_name: Name of the texture.
+ *
+ * Gets a miptex from the first archive containing `texture_name`.
+ *
+ * Returns: (transfer none) (nullable): The texture, or `NULL` if no archive
+ * has it or it is not a miptex.
+ */
+WadMiptexFile *
+wad_search_path_get_miptex(WadSearchPath *self, char const *texture_name)
+{
+    g_return_val_if_fail(WAD_IS_SEARCH_PATH(self), nullptr);
+    g_return_val_if_fail(texture_name != nullptr, nullptr);
+
+    WadTextureArchive *archive = find_archive(self, texture_name);
+    if (!archive) {
+        return nullptr;
+    }
+    return wad_texture_archive_get_miptex(archive, texture_name);
+}
+
+/**
+ * wad_search_path_get_qpic:
+ * @search_path: A [class@WadSearchPath].
+ * @texture_name: Name of the texture.
+ *
+ * Gets a qpic from the first archive containing `texture_name`.
+ *
+ * Returns: (transfer none) (nullable): The texture, or `NULL` if no archive
+ * has it or it is not a qpic.
+ */
+WadQpicFile *
+wad_search_path_get_qpic(WadSearchPath *self, char const *texture_name)
+{
+    g_return_val_if_fail(WAD_IS_SEARCH_PATH(self), nullptr);
+    g_return_val_if_fail(texture_name != nullptr, nullptr);
+
+    WadTextureArchive *archive = find_archive(self, texture_name);
+    if (!archive) {
+        return nullptr;
+    }
+    return wad_texture_archive_get_qpic(archive, texture_name);
+}
+
+/**
+ * wad_search_path_get_font:
+ * @search_path: A [class@WadSearchPath].
+ * @texture_name: Name of the texture.
+ *
+ * Gets a font from the first archive containing `texture_name`.
+ *
+ * Returns: (transfer none) (nullable): The font, or `NULL` if no archive has
+ * it or it is not a font.
+ */
+WadFontFile *
+wad_search_path_get_font(WadSearchPath *self, char const *texture_name)
+{
+    g_return_val_if_fail(WAD_IS_SEARCH_PATH(self), nullptr);
+    g_return_val_if_fail(texture_name != nullptr, nullptr);
+
+    WadTextureArchive *archive = find_archive(self, texture_name);
+    if (!archive) {
+        return nullptr;
+    }
+    return wad_texture_archive_get_font(archive, texture_name);
+}
@@ -0,0 +1,49 @@
+#pragma once
+
+#include "wad/wad-texturearchive.h"
+
+#include <gio/gio.h>
+#include <glib-object.h>
+
+G_BEGIN_DECLS
+
+#define WAD_TYPE_SEARCH_PATH wad_search_path_get_type()
+
+G_DECLARE_FINAL_TYPE(WadSearchPath, wad_search_path, WAD, SEARCH_PATH, GObject)
+
+WadSearchPath *wad_search_path_new(void);
+
+void wad_search_path_append_file(
+    WadSearchPath *search_path,
+    GFile *file,
+    GError **error
+);
+
+void wad_search_path_append_archive(
+    WadSearchPath *search_path,
+    WadTextureArchive *archive
+);
+
+guint wad_search_path_get_n_archives(WadSearchPath *search_path);
+
+WadTextureArchive *
+wad_search_path_get_archive(WadSearchPath *search_path, guint index);
+
+gint wad_search_path_find(WadSearchPath *search_path, char const *texture_name);
+
+WadMiptexFile *wad_search_path_get_miptex(
+    WadSearchPath *search_path,
+    char const *texture_name
+);
+
+WadQpicFile *wad_search_path_get_qpic(
+    WadSearchPath *search_path,
+    char const *texture_name
+);
+
+WadFontFile *wad_search_path_get_font(
+    WadSearchPath *search_path,
+    char const *texture_name
+);
+
+G_END_DECLS
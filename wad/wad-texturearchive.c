@@ -1,23 +1,324 @@
 #include "wad-texturearchive.h"
 
+#include "wad-private.h"
+
+// WadRgbaImage
+
+G_DEFINE_BOXED_TYPE(
+    WadRgbaImage,
+    wad_rgba_image,
+    wad_rgba_image_copy,
+    wad_rgba_image_free
+)
+
+WadRgbaImage *wad_rgba_image_copy(WadRgbaImage const *image)
+{
+    WadRgbaImage *copy = g_new(WadRgbaImage, 1);
+    copy->name = g_strdup(image->name);
+    copy->width = image->width;
+    copy->height = image->height;
+    copy->pixels = image->pixels ? g_bytes_ref(image->pixels) : nullptr;
+    return copy;
+}
+
+void wad_rgba_image_free(WadRgbaImage *image)
+{
+    g_free(image->name);
+    if (image->pixels) {
+        g_bytes_unref(image->pixels);
+    }
+    g_free(image);
+}
+
+// WadTextureArchive
+
 /**
  * WadTextureArchive:
  *
  * A collection of textures.
+ *
+ * Textures are kept in a single array of tagged entries, with names interned
+ * in a string chunk. Use wad_texture_archive_get_miptex(),
+ * wad_texture_archive_get_qpic() or wad_texture_archive_get_font() to look up
+ * a texture of a known type.
+ *
+ * As in GoldSrc, names are matched case-insensitively and only their first 16
+ * bytes are significant, so "WALL01" and "wall01" refer to the same texture.
+ *
+ * Palettes are interned as textures are added: textures with identical
+ * palettes share one read-only copy in their `palette_bytes`, and have the
+ * same `palette_id`. A palette is dropped once no texture in the archive uses
+ * it.
+ *
+ * An archive loaded lazily (see [property@WadRoot:lazy]) keeps only the WAD
+ * directory and a handle to its source. Each texture is decoded the first time
+ * it is requested, and cached.
+ *
+ * Replacing or removing a texture emits
+ * [signal@WadTextureArchive::texture-invalidated], which caches of decoded
+ * textures such as [class@WadRgbaCache] use to drop their copies.
  */
 struct _WadTextureArchive {
     GObject parent_instance;
-    GHashTable *textures;
+    GArray *entries;     // Array<Entry>
+    WadNameIndex index;  // Folded name -> position in entries
+    GStringChunk *names; // Backing storage for entry names
+    WadPalettePool palettes;
+    GMutex lock;
+    // Lazy loading
+    guint n_pending;
+    GArray *directory; // Array<WadDirectoryEntry>
+    WadInputStream *source_stream;
+    GBytes *source_bytes;
 };
 
 G_DEFINE_FINAL_TYPE(WadTextureArchive, wad_texture_archive, G_TYPE_OBJECT)
 
+enum Signal {
+    SIGNAL_TEXTURE_INVALIDATED,
+    N_SIGNALS,
+};
+
+static guint obj_signals[N_SIGNALS];
+
 // Private /////////////////////////////////////////////////////////////////////
 
-static void free_value(GValue *value)
+typedef struct {
+    char const *name;
+    WadName key;
+    WadTexture texture;
+    // Wrapper handed out by wad_texture_archive_get_texture(), created on
+    // first use. Does not own the texture.
+    GValue *value;
+    // Set until the texture has been decoded.
+    WadDirectoryEntry const *pending;
+    // Type given by the WAD directory, or 0 if added without one.
+    WadFileType file_type;
+} Entry;
+
+static void entry_clear(Entry *entry)
+{
+    if (entry->value) {
+        g_value_unset(entry->value);
+        g_clear_pointer(&entry->value, g_free);
+    }
+    wad_texture_clear(&entry->texture);
+    entry->pending = nullptr;
+}
+
+static void clear_pending(WadTextureArchive *self)
+{
+    g_clear_pointer(&self->directory, g_array_unref);
+    g_clear_object(&self->source_stream);
+    g_clear_pointer(&self->source_bytes, g_bytes_unref);
+}
+
+// Must hold lock.
+static void intern_palette(WadTextureArchive *self, WadTexture *texture)
+{
+    if (texture->type == WAD_TYPE_MIPTEX_FILE) {
+        WadMiptexFile *miptex = texture->boxed;
+        miptex->palette_id = wad_palette_pool_intern(
+            &self->palettes,
+            &miptex->palette,
+            &miptex->palette_bytes
+        );
+    } else if (texture->type == WAD_TYPE_QPIC_FILE) {
+        WadQpicFile *qpic = texture->boxed;
+        qpic->palette_id = wad_palette_pool_intern(
+            &self->palettes,
+            &qpic->palette,
+            &qpic->palette_bytes
+        );
+    } else if (texture->type == WAD_TYPE_FONT_FILE) {
+        WadFontFile *font = texture->boxed;
+        font->palette_id = wad_palette_pool_intern(
+            &self->palettes,
+            &font->palette,
+            &font->palette_bytes
+        );
+    }
+}
+
+// Gives back the palette use taken by intern_palette(). Must hold lock.
+static void release_palette(WadTextureArchive *self, WadTexture const *texture)
+{
+    guint id = 0;
+    if (texture->type == WAD_TYPE_MIPTEX_FILE) {
+        id = ((WadMiptexFile const *)texture->boxed)->palette_id;
+    } else if (texture->type == WAD_TYPE_QPIC_FILE) {
+        id = ((WadQpicFile const *)texture->boxed)->palette_id;
+    } else if (texture->type == WAD_TYPE_FONT_FILE) {
+        id = ((WadFontFile const *)texture->boxed)->palette_id;
+    }
+    wad_palette_pool_release(&self->palettes, id);
+}
+
+// Must hold lock.
+static Entry *
+lookup_key(WadTextureArchive *self, WadName const *key, guint *index)
+{
+    guint i = 0;
+    if (!wad_name_index_lookup(&self->index, key, &i)) {
+        return nullptr;
+    }
+    if (index) {
+        *index = i;
+    }
+    return &g_array_index(self->entries, Entry, i);
+}
+
+// Must hold lock.
+static Entry *lookup(WadTextureArchive *self, char const *name, guint *index)
+{
+    WadName key;
+    wad_name_init(&key, name);
+    return lookup_key(self, &key, index);
+}
+
+// Must hold lock.
+static void remove_entry(WadTextureArchive *self, guint index)
+{
+    Entry *entry = &g_array_index(self->entries, Entry, index);
+    wad_name_index_remove(&self->index, &entry->key);
+    release_palette(self, &entry->texture);
+    if (entry->pending) {
+        self->n_pending -= 1;
+    }
+    g_array_remove_index_fast(self->entries, index);
+    if (index < self->entries->len) {
+        Entry const *moved = &g_array_index(self->entries, Entry, index);
+        wad_name_index_insert(&self->index, &moved->key, index);
+    }
+    if (self->n_pending == 0) {
+        clear_pending(self);
+    }
+}
+
+/*
+ * Returns the entry called `name`, creating an empty one if there is none.
+ * Must hold lock.
+ */
+static Entry *insert_entry(WadTextureArchive *self, char const *name)
+{
+    WadName key;
+    wad_name_init(&key, name);
+    Entry *entry = lookup_key(self, &key, nullptr);
+    if (entry) {
+        if (entry->pending) {
+            self->n_pending -= 1;
+        }
+        release_palette(self, &entry->texture);
+        entry_clear(entry);
+        return entry;
+    }
+    g_array_set_size(self->entries, self->entries->len + 1);
+    entry = &g_array_index(self->entries, Entry, self->entries->len - 1);
+    entry->name = g_string_chunk_insert_const(self->names, name);
+    entry->key = key;
+    wad_name_index_insert(&self->index, &key, self->entries->len - 1);
+    return entry;
+}
+
+// Returns whether a texture was replaced. Must hold lock.
+static bool take(
+    WadTextureArchive *self,
+    char const *name,
+    WadFileType file_type,
+    WadTexture *texture
+)
+{
+    bool replaced = lookup(self, name, nullptr) != nullptr;
+    intern_palette(self, texture);
+    Entry *entry = insert_entry(self, name);
+    entry->texture = *texture;
+    entry->file_type = file_type;
+    *texture = (WadTexture){};
+    return replaced;
+}
+
+static WadFileType default_file_type(GType type)
+{
+    if (type == WAD_TYPE_QPIC_FILE) {
+        return WAD_FILE_TYPE_QPIC;
+    }
+    if (type == WAD_TYPE_FONT_FILE) {
+        return WAD_FILE_TYPE_FONT;
+    }
+    return WAD_FILE_TYPE_MIPTEX;
+}
+
+// Must hold lock.
+static void load_pending(WadTextureArchive *self, guint index)
+{
+    g_autoptr(GError) error = nullptr;
+    Entry *entry = &g_array_index(self->entries, Entry, index);
+    WadTexture texture;
+
+    if (self->source_bytes) {
+        g_auto(WadByteReader) reader = {};
+        wad_byte_reader_init(&reader, self->source_bytes);
+        texture = wad_byte_reader_read_entry(&reader, entry->pending, &error);
+    } else {
+        texture = wad_input_stream_read_entry(
+            self->source_stream,
+            entry->pending,
+            &error
+        );
+    }
+    if (error) {
+        g_warning(
+            "Failed to load texture '%s': %s",
+            entry->name,
+            error->message
+        );
+        remove_entry(self, index);
+        return;
+    }
+    intern_palette(self, &texture);
+    entry->texture = texture;
+    entry->pending = nullptr;
+    self->n_pending -= 1;
+    if (self->n_pending == 0) {
+        clear_pending(self);
+    }
+}
+
+// Must hold lock.
+static void load_all_pending(WadTextureArchive *self)
+{
+    for (guint i = 0; self->n_pending > 0 && i < self->entries->len;) {
+        if (g_array_index(self->entries, Entry, i).pending) {
+            // A texture that fails to load is swapped out for the last one,
+            // so look at this position again.
+            load_pending(self, i);
+        } else {
+            i += 1;
+        }
+    }
+}
+
+/*
+ * Looks up `name`, decoding it first if needed, and returns it if it holds a
+ * `type`.
+ */
+static gpointer
+get_typed(WadTextureArchive *self, char const *texture_name, GType type)
 {
-    g_value_unset(value);
-    g_free(value);
+    gpointer texture = nullptr;
+    guint i = 0;
+
+    g_mutex_lock(&self->lock);
+    Entry *entry = lookup(self, texture_name, &i);
+    if (entry && entry->pending) {
+        load_pending(self, i);
+        entry = lookup(self, texture_name, nullptr);
+    }
+    if (entry && entry->texture.type == type) {
+        texture = entry->texture.boxed;
+    }
+    g_mutex_unlock(&self->lock);
+    return texture;
 }
 
 // GObject /////////////////////////////////////////////////////////////////////
@@ -25,9 +326,12 @@ static void free_value(GValue *value)
 static void wad_texture_archive_finalize(GObject *object)
 {
     WadTextureArchive *self = WAD_TEXTURE_ARCHIVE(object);
-    if (self->textures) {
-        g_hash_table_unref(self->textures);
-    }
+    wad_name_index_clear(&self->index);
+    g_clear_pointer(&self->entries, g_array_unref);
+    g_clear_pointer(&self->names, g_string_chunk_free);
+    wad_palette_pool_clear(&self->palettes);
+    clear_pending(self);
+    g_mutex_clear(&self->lock);
     G_OBJECT_CLASS(wad_texture_archive_parent_class)->finalize(object);
 }
 
@@ -37,16 +341,37 @@ static void wad_texture_archive_class_init(WadTextureArchiveClass *klass)
 {
     GObjectClass *oclass = G_OBJECT_CLASS(klass);
     oclass->finalize = wad_texture_archive_finalize;
+
+    /**
+     * WadTextureArchive::texture-invalidated:
+     * @archive: The [class@WadTextureArchive].
+     * @texture_name: Name of the texture.
+     *
+     * Emitted after a texture is replaced or removed, from the thread that
+     * changed the archive. Anything derived from the old texture is stale.
+     */
+    obj_signals[SIGNAL_TEXTURE_INVALIDATED] = g_signal_new(
+        "texture-invalidated",
+        G_TYPE_FROM_CLASS(klass),
+        G_SIGNAL_RUN_LAST,
+        0,
+        nullptr,
+        nullptr,
+        nullptr,
+        G_TYPE_NONE,
+        1,
+        G_TYPE_STRING
+    );
 }
 
 static void wad_texture_archive_init(WadTextureArchive *self)
 {
-    self->textures = g_hash_table_new_full(
-        g_str_hash,
-        g_str_equal,
-        g_free,
-        (GDestroyNotify)free_value
-    );
+    self->entries = g_array_new(FALSE, TRUE, sizeof(Entry));
+    g_array_set_clear_func(self->entries, (GDestroyNotify)entry_clear);
+    wad_name_index_init(&self->index);
+    self->names = g_string_chunk_new(1024);
+    wad_palette_pool_init(&self->palettes);
+    g_mutex_init(&self->lock);
 }
 
 // Public //////////////////////////////////////////////////////////////////////
@@ -67,9 +392,10 @@ WadTextureArchive *wad_texture_archive_new(void)
  * wad_texture_archive_add_texture:
  * @archive: A [class@WadTextureArchive].
  * @texture_name: Name of the texture.
- * @texture: (transfer full): A texture.
+ * @texture: (transfer full): A [struct@WadMiptexFile], [struct@WadQpicFile] or
+ * [struct@WadFontFile].
  *
- * Adds a texture to the archive.
+ * Adds a texture to the archive, replacing any texture of the same name.
  */
 void wad_texture_archive_add_texture(
     WadTextureArchive *self,
@@ -79,8 +405,15 @@ void wad_texture_archive_add_texture(
 {
     g_return_if_fail(WAD_IS_TEXTURE_ARCHIVE(self));
     g_return_if_fail(texture_name != nullptr);
-    g_return_if_fail(G_IS_VALUE(texture));
-    g_hash_table_insert(self->textures, g_strdup(texture_name), texture);
+    g_return_if_fail(G_VALUE_HOLDS_BOXED(texture));
+
+    WadTexture typed = {
+        .type = G_VALUE_TYPE(texture),
+        .boxed = g_value_dup_boxed(texture),
+    };
+    g_value_unset(texture);
+    g_free(texture);
+    wad_texture_archive_take_texture(self, texture_name, &typed);
 }
 
 /**
@@ -94,7 +427,22 @@ void
 wad_texture_archive_remove_texture(WadTextureArchive *self, char const *texture)
 {
     g_return_if_fail(WAD_IS_TEXTURE_ARCHIVE(self));
-    g_hash_table_remove(self->textures, texture);
+    guint i = 0;
+
+    g_mutex_lock(&self->lock);
+    bool removed = lookup(self, texture, &i) != nullptr;
+    if (removed) {
+        remove_entry(self, i);
+    }
+    g_mutex_unlock(&self->lock);
+    if (removed) {
+        g_signal_emit(
+            self,
+            obj_signals[SIGNAL_TEXTURE_INVALIDATED],
+            0,
+            texture
+        );
+    }
 }
 
 /**
@@ -102,7 +450,16 @@ wad_texture_archive_remove_texture(WadTextureArchive *self, char const *texture)
  * @archive: A [class@WadTextureArchive].
  * @texture_name: Name of the texture.
  *
- * Gets a texture from the wad.
+ * Gets a texture from the wad, wrapped in a [struct@GObject.Value].
+ *
+ * If the archive was loaded lazily and the texture has not been requested
+ * before, it is decoded now. A texture that fails to decode is dropped from
+ * the archive with a warning.
+ *
+ * Prefer the typed getters such as wad_texture_archive_get_miptex(), which do
+ * not allocate a wrapper. The returned value only stays valid until the
+ * texture is removed or replaced.
+ *
  * Returns: (transfer none) (nullable): The requested texture, or `NULL` if the
  * given name does not exist.
  */
@@ -112,18 +469,523 @@ GValue *wad_texture_archive_get_texture(
 )
 {
     g_return_val_if_fail(WAD_IS_TEXTURE_ARCHIVE(self), nullptr);
-    return g_hash_table_lookup(self->textures, texture_name);
+    GValue *value = nullptr;
+    guint i = 0;
+
+    g_mutex_lock(&self->lock);
+    Entry *entry = lookup(self, texture_name, &i);
+    if (entry && entry->pending) {
+        load_pending(self, i);
+        entry = lookup(self, texture_name, nullptr);
+    }
+    if (entry) {
+        if (!entry->value) {
+            entry->value = g_new0(GValue, 1);
+            g_value_init(entry->value, entry->texture.type);
+            g_value_set_static_boxed(entry->value, entry->texture.boxed);
+        }
+        value = entry->value;
+    }
+    g_mutex_unlock(&self->lock);
+    return value;
+}
+
+/**
+ * wad_texture_archive_get_miptex:
+ * @archive: A [class@WadTextureArchive].
+ * @texture_name: Name of the texture.
+ *
+ * Gets a miptex or spray decal from the archive, decoding it first if the
+ * archive was loaded lazily.
+ *
+ * Returns: (transfer none) (nullable): The texture, or `NULL` if there is no
+ * texture of that name or it is not a miptex.
+ */
+WadMiptexFile *wad_texture_archive_get_miptex(
+    WadTextureArchive *self,
+    char const *texture_name
+)
+{
+    g_return_val_if_fail(WAD_IS_TEXTURE_ARCHIVE(self), nullptr);
+    return get_typed(self, texture_name, WAD_TYPE_MIPTEX_FILE);
+}
+
+/**
+ * wad_texture_archive_get_qpic:
+ * @archive: A [class@WadTextureArchive].
+ * @texture_name: Name of the texture.
+ *
+ * Gets a qpic from the archive, decoding it first if the archive was loaded
+ * lazily.
+ *
+ * Returns: (transfer none) (nullable): The texture, or `NULL` if there is no
+ * texture of that name or it is not a qpic.
+ */
+WadQpicFile *
+wad_texture_archive_get_qpic(WadTextureArchive *self, char const *texture_name)
+{
+    g_return_val_if_fail(WAD_IS_TEXTURE_ARCHIVE(self), nullptr);
+    return get_typed(self, texture_name, WAD_TYPE_QPIC_FILE);
+}
+
+/**
+ * wad_texture_archive_get_font:
+ * @archive: A [class@WadTextureArchive].
+ * @texture_name: Name of the texture.
+ *
+ * Gets a font from the archive, decoding it first if the archive was loaded
+ * lazily.
+ *
+ * Returns: (transfer none) (nullable): The font, or `NULL` if there is no
+ * texture of that name or it is not a font.
+ */
+WadFontFile *
+wad_texture_archive_get_font(WadTextureArchive *self, char const *texture_name)
+{
+    g_return_val_if_fail(WAD_IS_TEXTURE_ARCHIVE(self), nullptr);
+    return get_typed(self, texture_name, WAD_TYPE_FONT_FILE);
+}
+
+static void compute_stats_one(guint index, gpointer user_data)
+{
+    GPtrArray *miptexes = user_data;
+    wad_miptex_file_get_stats(g_ptr_array_index(miptexes, index));
+}
+
+/**
+ * wad_texture_archive_compute_stats:
+ * @archive: A [class@WadTextureArchive].
+ * @n_threads: Number of threads to use, or 0 to use one per processor.
+ *
+ * Computes and caches the statistics of every miptex in the archive (see
+ * wad_miptex_file_get_stats()), spreading the work across a thread pool.
+ * Textures of a lazily-loaded archive are decoded first.
+ */
+void
+wad_texture_archive_compute_stats(WadTextureArchive *self, guint n_threads)
+{
+    g_return_if_fail(WAD_IS_TEXTURE_ARCHIVE(self));
+
+    g_mutex_lock(&self->lock);
+    load_all_pending(self);
+    g_autoptr(GPtrArray) miptexes = g_ptr_array_new();
+    for (guint i = 0; i < self->entries->len; ++i) {
+        Entry const *entry = &g_array_index(self->entries, Entry, i);
+        if (entry->texture.type == WAD_TYPE_MIPTEX_FILE) {
+            g_ptr_array_add(miptexes, entry->texture.boxed);
+        }
+    }
+    // Hold the lock so no texture is removed while being worked on.
+    wad_parallel_for(miptexes->len, n_threads, compute_stats_one, miptexes);
+    g_mutex_unlock(&self->lock);
+}
+
+typedef struct {
+    WadQpicFile const *qpic;
+    guint lut; // Position in QpicBatch.luts
+    gsize offset;
+} QpicJob;
+
+typedef struct {
+    GArray *jobs; // Array<QpicJob>
+    GArray *luts; // Array<WadPaletteLut>, one per distinct palette
+    guint scale;
+    guchar *pixels;
+} QpicBatch;
+
+static void qpic_to_rgba_one(guint index, gpointer user_data)
+{
+    QpicBatch const *batch = user_data;
+    QpicJob const *job = &g_array_index(batch->jobs, QpicJob, index);
+    gsize size = 0;
+    guchar const *data = wad_qpic_file_get_data(job->qpic, &size);
+    wad_palette_lut_expand_scaled(
+        &g_array_index(batch->luts, WadPaletteLut, job->lut),
+        data,
+        size,
+        job->qpic->width,
+        job->qpic->height,
+        batch->scale,
+        batch->pixels + job->offset,
+        (gsize)job->qpic->width * batch->scale * 4
+    );
+}
+
+// Finds or builds the lookup table for a qpic's palette.
+static guint qpic_lut(
+    GArray *luts,
+    GHashTable *lut_by_id,
+    WadQpicFile const *qpic,
+    WadGammaTable const *gamma
+)
+{
+    gpointer found = nullptr;
+    if (qpic->palette_id != 0
+        && g_hash_table_lookup_extended(
+            lut_by_id,
+            GUINT_TO_POINTER(qpic->palette_id),
+            nullptr,
+            &found
+        )) {
+        return GPOINTER_TO_UINT(found);
+    }
+    gsize n_colors = 0;
+    WadRgb const *palette = wad_qpic_file_get_palette_data(qpic, &n_colors);
+    guint index = luts->len;
+    g_array_set_size(luts, index + 1);
+    wad_palette_lut_init(
+        &g_array_index(luts, WadPaletteLut, index),
+        palette,
+        n_colors,
+        gamma
+    );
+    if (qpic->palette_id != 0) {
+        g_hash_table_insert(
+            lut_by_id,
+            GUINT_TO_POINTER(qpic->palette_id),
+            GUINT_TO_POINTER(index)
+        );
+    }
+    return index;
+}
+
+/**
+ * wad_texture_archive_qpics_to_rgba:
+ * @archive: A [class@WadTextureArchive].
+ * @gamma: (nullable): Color correction to apply, or `NULL` for none.
+ * @scale: How many times to enlarge each image in each direction, from 1.
+ * @n_threads: Number of threads to use, or 0 to use one per processor.
+ *
+ * Converts every qpic in the archive to RGBA, as
+ * wad_qpic_file_to_rgba_scaled() does, spreading the images across a thread
+ * pool. Textures of a lazily-loaded archive are decoded first. Images that
+ * share a palette share its lookup table.
+ *
+ * All of the images are written into a single buffer; each image's pixels are
+ * a slice of it.
+ *
+ * Returns: (transfer full) (element-type WadRgbaImage): The images, in the
+ * order they were added to the archive.
+ */
+GPtrArray *wad_texture_archive_qpics_to_rgba(
+    WadTextureArchive *self,
+    WadGammaTable const *gamma,
+    guint scale,
+    guint n_threads
+)
+{
+    g_return_val_if_fail(WAD_IS_TEXTURE_ARCHIVE(self), nullptr);
+    g_return_val_if_fail(scale >= 1, nullptr);
+
+    GPtrArray *images
+        = g_ptr_array_new_with_free_func((GDestroyNotify)wad_rgba_image_free);
+    g_autoptr(GArray) jobs = g_array_new(FALSE, FALSE, sizeof(QpicJob));
+    g_autoptr(GArray) luts = g_array_new(FALSE, FALSE, sizeof(WadPaletteLut));
+    g_autoptr(GHashTable) lut_by_id = g_hash_table_new(nullptr, nullptr);
+    gsize total_size = 0;
+
+    g_mutex_lock(&self->lock);
+    load_all_pending(self);
+    for (guint i = 0; i < self->entries->len; ++i) {
+        Entry const *entry = &g_array_index(self->entries, Entry, i);
+        if (entry->texture.type != WAD_TYPE_QPIC_FILE) {
+            continue;
+        }
+        WadQpicFile const *qpic = entry->texture.boxed;
+        QpicJob job = {
+            .qpic = qpic,
+            .lut = qpic_lut(luts, lut_by_id, qpic, gamma),
+            .offset = total_size,
+        };
+        WadRgbaImage *image = g_new0(WadRgbaImage, 1);
+        image->name = g_strdup(entry->name);
+        image->width = qpic->width * scale;
+        image->height = qpic->height * scale;
+        g_array_append_val(jobs, job);
+        g_ptr_array_add(images, image);
+        total_size += (gsize)image->width * image->height * 4;
+    }
+
+    QpicBatch batch = {jobs, luts, scale, g_malloc(total_size)};
+    // Hold the lock so no texture is removed while being worked on.
+    wad_parallel_for(jobs->len, n_threads, qpic_to_rgba_one, &batch);
+    g_mutex_unlock(&self->lock);
+
+    g_autoptr(GBytes) pixels = g_bytes_new_take(batch.pixels, total_size);
+    for (guint i = 0; i < images->len; ++i) {
+        WadRgbaImage *image = g_ptr_array_index(images, i);
+        image->pixels = g_bytes_new_from_bytes(
+            pixels,
+            g_array_index(jobs, QpicJob, i).offset,
+            (gsize)image->width * image->height * 4
+        );
+    }
+    return images;
+}
+
+typedef struct {
+    WadRgbaImage *const *images;
+    WadDither dither;
+    WadMiptexFile **miptexes;
+    GError **errors;
+} ImportBatch;
+
+static void import_one(guint index, gpointer user_data)
+{
+    ImportBatch const *batch = user_data;
+    WadRgbaImage const *image = batch->images[index];
+    gsize size = 0;
+    guchar const *pixels = g_bytes_get_data(image->pixels, &size);
+    if (size < (gsize)image->width * image->height * 4) {
+        g_set_error(
+            &batch->errors[index],
+            G_IO_ERROR,
+            G_IO_ERROR_INVALID_ARGUMENT,
+            "Image '%s' is missing pixel data",
+            image->name
+        );
+        return;
+    }
+    batch->miptexes[index] = wad_miptex_file_new_from_rgba(
+        image->name,
+        image->width,
+        image->height,
+        pixels,
+        (gsize)image->width * 4,
+        batch->dither,
+        &batch->errors[index]
+    );
+}
+
+/**
+ * wad_texture_archive_import_rgba:
+ * @archive: A [class@WadTextureArchive].
+ * @images: (element-type WadRgbaImage): The images to import.
+ * @dither: How to dither the images.
+ * @n_threads: Number of threads to use, or 0 to use one per processor.
+ * @error: The return location for [struct@GError].
+ *
+ * Converts truecolor images to miptex textures, as
+ * wad_miptex_file_new_from_rgba() does, and adds them to the archive under
+ * their names, replacing any textures of the same names. The images are
+ * spread across a thread pool.
+ *
+ * If any image cannot be converted, none are added.
+ * Returns: Whether the images were imported.
+ */
+gboolean wad_texture_archive_import_rgba(
+    WadTextureArchive *self,
+    GPtrArray *images,
+    WadDither dither,
+    guint n_threads,
+    GError **error
+)
+{
+    g_return_val_if_fail(WAD_IS_TEXTURE_ARCHIVE(self), FALSE);
+    g_return_val_if_fail(images != nullptr, FALSE);
+    g_return_val_if_fail(error == nullptr || *error == nullptr, FALSE);
+
+    guint n = images->len;
+    g_autofree WadMiptexFile **miptexes = g_new0(WadMiptexFile *, n);
+    g_autofree GError **errors = g_new0(GError *, n);
+    ImportBatch batch = {
+        .images = (WadRgbaImage *const *)images->pdata,
+        .dither = dither,
+        .miptexes = miptexes,
+        .errors = errors,
+    };
+    wad_parallel_for(n, n_threads, import_one, &batch);
+
+    GError *e = nullptr;
+    for (guint i = 0; i < n; ++i) {
+        if (errors[i] && !e) {
+            e = g_steal_pointer(&errors[i]);
+        }
+        g_clear_error(&errors[i]);
+    }
+    if (e) {
+        for (guint i = 0; i < n; ++i) {
+            g_clear_pointer(&miptexes[i], wad_miptex_file_free);
+        }
+        g_propagate_error(error, e);
+        return FALSE;
+    }
+    for (guint i = 0; i < n; ++i) {
+        WadRgbaImage const *image = g_ptr_array_index(images, i);
+        WadTexture texture = {
+            .type = WAD_TYPE_MIPTEX_FILE,
+            .boxed = miptexes[i],
+        };
+        wad_texture_archive_take_texture(self, image->name, &texture);
+    }
+    return TRUE;
 }
 
 /**
  * wad_texture_archive_get_names:
  * @archive: A [class@WadTextureArchive].
  *
- * Retrieves the texture names from the archive as a `NULL`-terminated array.
+ * Retrieves the texture names from the archive as a `NULL`-terminated array,
+ * in the order they were added.
+ *
+ * This includes textures that have not been decoded yet. The names remain
+ * valid for the lifetime of the archive.
+ *
  * Returns: (transfer container): A `NULL`-terminated array of texture names.
  */
 char const **wad_texture_archive_get_names(WadTextureArchive *self)
 {
-    gpointer *names = g_hash_table_get_keys_as_array(self->textures, nullptr);
-    return (char const **)names;
+    g_return_val_if_fail(WAD_IS_TEXTURE_ARCHIVE(self), nullptr);
+    g_mutex_lock(&self->lock);
+    char const **names = g_new(char const *, self->entries->len + 1);
+    for (guint i = 0; i < self->entries->len; ++i) {
+        names[i] = g_array_index(self->entries, Entry, i).name;
+    }
+    names[self->entries->len] = nullptr;
+    g_mutex_unlock(&self->lock);
+    return names;
+}
+
+// Internal ////////////////////////////////////////////////////////////////////
+
+void wad_texture_clear(WadTexture *texture)
+{
+    if (texture->boxed) {
+        g_boxed_free(texture->type, texture->boxed);
+    }
+    texture->type = G_TYPE_INVALID;
+    texture->boxed = nullptr;
+}
+
+/*
+ * Copies the texture called `texture_name` into `texture`, decoding it first
+ * if needed, and returns whether there was one. The copy shares the
+ * texture's pixel and palette storage, but stays valid when the texture is
+ * removed from or replaced in the archive.
+ *
+ * If `file_type` is given, it is set to the type the texture had in the WAD
+ * directory it was loaded from, which tells spray decals from other miptex
+ * textures. Textures added without a directory get the usual type for their
+ * kind.
+ */
+bool wad_texture_archive_dup_texture(
+    WadTextureArchive *self,
+    char const *texture_name,
+    WadTexture *texture,
+    WadFileType *file_type
+)
+{
+    guint i = 0;
+    g_mutex_lock(&self->lock);
+    Entry *entry = lookup(self, texture_name, &i);
+    if (entry && entry->pending) {
+        load_pending(self, i);
+        entry = lookup(self, texture_name, nullptr);
+    }
+    if (entry) {
+        GType type = entry->texture.type;
+        texture->type = type;
+        texture->boxed = g_boxed_copy(type, entry->texture.boxed);
+        if (file_type) {
+            *file_type = entry->file_type ? entry->file_type
+                                          : default_file_type(type);
+        }
+    }
+    g_mutex_unlock(&self->lock);
+    return entry != nullptr;
+}
+
+/*
+ * Adds `texture` under `texture_name`, taking ownership of it and leaving
+ * `texture` cleared.
+ */
+void wad_texture_archive_take_texture(
+    WadTextureArchive *self,
+    char const *texture_name,
+    WadTexture *texture
+)
+{
+    g_mutex_lock(&self->lock);
+    bool replaced = take(self, texture_name, 0, texture);
+    g_mutex_unlock(&self->lock);
+    if (replaced) {
+        g_signal_emit(
+            self,
+            obj_signals[SIGNAL_TEXTURE_INVALIDATED],
+            0,
+            texture_name
+        );
+    }
+}
+
+/*
+ * Like wad_texture_archive_take_texture(), named after the directory entry
+ * the texture was decoded from and keeping its file type.
+ */
+void wad_texture_archive_take_entry(
+    WadTextureArchive *self,
+    WadDirectoryEntry const *entry,
+    WadTexture *texture
+)
+{
+    char name[17] = {};
+    memcpy(name, entry->texture_name, 16);
+    g_mutex_lock(&self->lock);
+    bool replaced = take(self, name, entry->file_type, texture);
+    g_mutex_unlock(&self->lock);
+    if (replaced) {
+        g_signal_emit(self, obj_signals[SIGNAL_TEXTURE_INVALIDATED], 0, name);
+    }
+}
+
+/*
+ * Registers every entry of `directory` to be decoded on first access from
+ * either `stream` or `bytes`. Takes a reference to each argument.
+ */
+void wad_texture_archive_set_pending(
+    WadTextureArchive *self,
+    GArray *directory,
+    WadInputStream *stream,
+    GBytes *bytes
+)
+{
+    g_mutex_lock(&self->lock);
+    clear_pending(self);
+    self->n_pending = 0;
+    self->directory = g_array_ref(directory);
+    self->source_stream = stream ? g_object_ref(stream) : nullptr;
+    self->source_bytes = bytes ? g_bytes_ref(bytes) : nullptr;
+    for (guint i = 0; i < self->entries->len; ++i) {
+        release_palette(self, &g_array_index(self->entries, Entry, i).texture);
+    }
+    g_array_set_size(self->entries, 0);
+    wad_name_index_remove_all(&self->index);
+    g_array_set_size(self->entries, directory->len);
+    for (guint i = 0; i < directory->len; ++i) {
+        WadDirectoryEntry const *dir_entry
+            = &g_array_index(directory, WadDirectoryEntry, i);
+        WadName key;
+        wad_name_init(&key, dir_entry->texture_name);
+        Entry *entry = lookup_key(self, &key, nullptr);
+        if (entry) {
+            // Later entries of the same name win, as with eager loading.
+            entry->pending = dir_entry;
+            entry->file_type = dir_entry->file_type;
+            continue;
+        }
+        char name[17] = {};
+        memcpy(name, dir_entry->texture_name, 16);
+        entry = &g_array_index(self->entries, Entry, self->n_pending);
+        entry->name = g_string_chunk_insert_const(self->names, name);
+        entry->key = key;
+        entry->pending = dir_entry;
+        entry->file_type = dir_entry->file_type;
+        wad_name_index_insert(&self->index, &key, self->n_pending);
+        self->n_pending += 1;
+    }
+    g_array_set_size(self->entries, self->n_pending);
+    if (self->n_pending == 0) {
+        clear_pending(self);
+    }
+    g_mutex_unlock(&self->lock);
 }
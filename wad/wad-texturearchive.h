@@ -1,9 +1,40 @@
 #pragma once
 
+#include "wad/wad-fontfile.h"
+#include "wad/wad-miptexfile.h"
+#include "wad/wad-qpicfile.h"
+
 #include <glib-object.h>
 
 G_BEGIN_DECLS
 
+// WadRgbaImage
+
+#define WAD_TYPE_RGBA_IMAGE wad_rgba_image_get_type()
+
+/**
+ * WadRgbaImage:
+ * @name: Name of the texture the image was made from.
+ * @width: Width of the image, in pixels.
+ * @height: Height of the image, in pixels.
+ * @pixels: Tightly-packed 8-bit RGBA rows.
+ *
+ * A texture converted to RGBA.
+ */
+typedef struct {
+    char *name;
+    guint width, height;
+    GBytes *pixels;
+} WadRgbaImage;
+
+GType wad_rgba_image_get_type(void);
+WadRgbaImage *wad_rgba_image_copy(WadRgbaImage const *image);
+void wad_rgba_image_free(WadRgbaImage *image);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC(WadRgbaImage, wad_rgba_image_free)
+
+// WadTextureArchive
+
 #define WAD_TYPE_TEXTURE_ARCHIVE wad_texture_archive_get_type()
 
 G_DECLARE_FINAL_TYPE(
@@ -32,6 +63,41 @@ GValue *wad_texture_archive_get_texture(
     char const *texture_name
 );
 
+WadMiptexFile *wad_texture_archive_get_miptex(
+    WadTextureArchive *archive,
+    char const *texture_name
+);
+
+WadQpicFile *wad_texture_archive_get_qpic(
+    WadTextureArchive *archive,
+    char const *texture_name
+);
+
+WadFontFile *wad_texture_archive_get_font(
+    WadTextureArchive *archive,
+    char const *texture_name
+);
+
+void wad_texture_archive_compute_stats(
+    WadTextureArchive *archive,
+    guint n_threads
+);
+
+GPtrArray *wad_texture_archive_qpics_to_rgba(
+    WadTextureArchive *archive,
+    WadGammaTable const *gamma,
+    guint scale,
+    guint n_threads
+);
+
+gboolean wad_texture_archive_import_rgba(
+    WadTextureArchive *archive,
+    GPtrArray *images,
+    WadDither dither,
+    guint n_threads,
+    GError **error
+);
+
 char const **wad_texture_archive_get_names(WadTextureArchive *archive);
 
 G_END_DECLS
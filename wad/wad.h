@@ -3,14 +3,22 @@
 
 #define __WAD_H_INSIDE__
 
+#include <wad/wad-atlas.h>
+#include <wad/wad-catalog.h>
+#include <wad/wad-contentregistry.h>
 #include <wad/wad-directoryentry.h>
 #include <wad/wad-fontfile.h>
+#include <wad/wad-gammatable.h>
+#include <wad/wad-glyphatlas.h>
 #include <wad/wad-inputstream.h>
 #include <wad/wad-loaderror.h>
 #include <wad/wad-miptexfile.h>
+#include <wad/wad-outputstream.h>
 #include <wad/wad-qpicfile.h>
 #include <wad/wad-rgb.h>
+#include <wad/wad-rgbacache.h>
 #include <wad/wad-root.h>
+#include <wad/wad-searchpath.h>
 #include <wad/wad-texturearchive.h>
 
 #undef __WAD_H_INSIDE__